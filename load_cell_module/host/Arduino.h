@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * The part of the Arduino core the load cell module uses, implemented on the host by
+ * arduino_host.cpp. Time is virtual: it only passes in delay(), while waiting for the
+ * HX711 and while the serial port has no room, and the host decides how it maps to
+ * real time.
+ *
+ * The AVR has a 32 bit double, so floating point output is computed with float to
+ * print exactly what the module prints.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long milliseconds);
+void delayMicroseconds(unsigned int microseconds);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+/**
+ * Formatting of text and numbers on top of write(), like Print of the Arduino core.
+ */
+class Print
+{
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    size_t print(const char* text);
+    size_t print(char value);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const char* text);
+    size_t println(char value);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+
+private:
+    size_t PrintNumber(unsigned long value, int base);
+    size_t PrintFloat(float value, int digits);
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/**
+ * The UART of the module. Bytes leave the transmit buffer with the baud rate, a write
+ * into a full buffer waits like it does on the AVR. Received bytes come from the host.
+ */
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud_rate);
+    void end();
+    void flush();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t value) override;
+    using Print::write;
+
+    explicit operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,88 @@
+#include "HX711.h"
+
+#include "firmware_host.h"
+
+void HX711::begin(uint8_t data_pin, uint8_t clock_pin, bool)
+{
+    this->data_pin_ = data_pin;
+    this->clock_pin_ = clock_pin;
+}
+
+bool HX711::is_ready()
+{
+    return FirmwareHost::IsAdcReady();
+}
+
+void HX711::wait_ready(uint32_t milliseconds)
+{
+    while (!this->is_ready())
+        delay(milliseconds);
+}
+
+float HX711::read()
+{
+    return static_cast<float>(FirmwareHost::ReadAdc());
+}
+
+float HX711::read_average(uint8_t times)
+{
+    if (times < 1)
+        times = 1;
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < times; i++)
+        sum += this->read();
+    return sum / times;
+}
+
+float HX711::get_value(uint8_t times)
+{
+    return this->read_average(times) - this->offset_;
+}
+
+float HX711::get_units(uint8_t times)
+{
+    return this->get_value(times) / this->scale_;
+}
+
+void HX711::tare(uint8_t times)
+{
+    this->offset_ = static_cast<int32_t>(this->read_average(times));
+}
+
+float HX711::get_tare()
+{
+    return -this->offset_ / this->scale_;
+}
+
+bool HX711::tare_set()
+{
+    return this->offset_ != 0;
+}
+
+void HX711::set_scale(float scale)
+{
+    this->scale_ = scale;
+}
+
+float HX711::get_scale()
+{
+    return this->scale_;
+}
+
+void HX711::set_offset(int32_t offset)
+{
+    this->offset_ = offset;
+}
+
+int32_t HX711::get_offset()
+{
+    return this->offset_;
+}
+
+void HX711::power_down()
+{
+}
+
+void HX711::power_up()
+{
+}
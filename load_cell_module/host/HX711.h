@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * The interface of the HX711 library by Rob Tillaart the load cell module uses. The
+ * counts come from the ADC of the firmware host, which converts with the rate of the
+ * HX711 and lets read() wait for the next conversion like the chip does.
+ */
+
+#include "Arduino.h"
+
+class HX711
+{
+public:
+    void begin(uint8_t data_pin, uint8_t clock_pin, bool fast_processor = false);
+
+    bool is_ready();
+    void wait_ready(uint32_t milliseconds = 0);
+
+    /**
+     * Waits for the next conversion and returns its raw count.
+     */
+    float read();
+    float read_average(uint8_t times = 10);
+
+    /**
+     * Returns the average count without the tare offset.
+     */
+    float get_value(uint8_t times = 1);
+
+    /**
+     * Returns the average count without the tare offset, divided by the scale.
+     */
+    float get_units(uint8_t times = 1);
+
+    void tare(uint8_t times = 10);
+    float get_tare();
+    bool tare_set();
+
+    void set_scale(float scale = 1.0);
+    float get_scale();
+    void set_offset(int32_t offset = 0);
+    int32_t get_offset();
+
+    void power_down();
+    void power_up();
+
+private:
+    uint8_t data_pin_ = 0;
+    uint8_t clock_pin_ = 0;
+    int32_t offset_ = 0;
+    float scale_ = 1.0f;
+};
@@ -0,0 +1,540 @@
+#include "firmware_host.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+
+// Defined by the sketch.
+void setup();
+void loop();
+
+// Reading the clock takes a few microseconds on the AVR, which also keeps busy waits on
+// millis() going.
+static const uint64_t CLOCK_READ_NS = 4000;
+
+// The HX711 delivers signed 24 bit counts.
+static const int32_t ADC_MIN = -8388608;
+static const int32_t ADC_MAX = 8388607;
+
+/**
+ * The state of the simulated board. Only touched by the thread running the firmware,
+ * except for the statistics.
+ */
+struct HostState
+{
+    FirmwareHostSettings settings;
+    std::chrono::steady_clock::time_point start;
+    uint64_t now_ns = 0;
+    uint64_t byte_ns = 0;
+
+    // Bytes in the transmit buffer with the time they are completely on the wire.
+    std::deque<std::pair<uint8_t, uint64_t>> transmit;
+    uint64_t transmit_end_ns = 0;
+    std::deque<uint8_t> receive;
+    std::multimap<uint64_t, uint8_t> scheduled_commands;
+
+    uint64_t last_conversion = 0;
+
+    bool at_line_start = true;
+    bool has_line = false;
+    uint64_t last_line_start_ns = 0;
+    bool full_rate_pending = false;
+    uint64_t full_rate_command_ns = 0;
+
+    std::mutex statistics_lock;
+    FirmwareHostStatistics statistics;
+};
+
+static HostState host;
+
+HardwareSerial Serial;
+
+/**
+ * Writes the bytes, which are completely on the wire by now, to the pseudo terminal.
+ */
+static void SendDueBytes()
+{
+    uint8_t buffer[128];
+    size_t count = 0;
+    while (!host.transmit.empty() && host.transmit.front().second <= host.now_ns)
+    {
+        buffer[count++] = host.transmit.front().first;
+        host.transmit.pop_front();
+        if (count == sizeof(buffer) || host.transmit.empty() || host.transmit.front().second > host.now_ns)
+        {
+            if (host.settings.serial_fd >= 0)
+            {
+                ssize_t written = write(host.settings.serial_fd, buffer, count);
+                (void)written;
+            }
+            count = 0;
+        }
+    }
+}
+
+/**
+ * Puts a received byte into the receive buffer, which drops it if full like the AVR core.
+ */
+static void ReceiveByte(uint8_t value)
+{
+    if (host.receive.size() >= host.settings.receive_buffer_size)
+        return;
+    host.receive.push_back(value);
+
+    std::lock_guard<std::mutex> lock(host.statistics_lock);
+    host.statistics.commands++;
+    if (value == 'F')
+    {
+        host.full_rate_pending = true;
+        host.full_rate_command_ns = host.now_ns;
+    }
+}
+
+static void ReceiveBytes()
+{
+    while (!host.scheduled_commands.empty() && host.scheduled_commands.begin()->first <= host.now_ns)
+    {
+        ReceiveByte(host.scheduled_commands.begin()->second);
+        host.scheduled_commands.erase(host.scheduled_commands.begin());
+    }
+
+    if (host.settings.serial_fd < 0)
+        return;
+
+    uint8_t buffer[64];
+    size_t free_space = host.settings.receive_buffer_size - std::min<size_t>(host.receive.size(), host.settings.receive_buffer_size);
+    if (free_space == 0)
+        return;
+    ssize_t count = read(host.settings.serial_fd, buffer, std::min(sizeof(buffer), free_space));
+    for (ssize_t i = 0; i < count; i++)
+        ReceiveByte(buffer[i]);
+}
+
+/**
+ * Moves the virtual time forward to the given time, stepping through the bytes leaving
+ * the transmit buffer on the way, so that they arrive one by one in real time mode.
+ */
+static void AdvanceTo(uint64_t time_ns)
+{
+    do
+    {
+        uint64_t next_ns = time_ns;
+        if (!host.transmit.empty())
+            next_ns = std::min(next_ns, host.transmit.front().second);
+        if (!host.scheduled_commands.empty())
+            next_ns = std::min(next_ns, host.scheduled_commands.begin()->first);
+        next_ns = std::max(next_ns, host.now_ns);
+
+        if (host.settings.realtime)
+            std::this_thread::sleep_until(host.start + std::chrono::nanoseconds(next_ns));
+        host.now_ns = next_ns;
+
+        SendDueBytes();
+        ReceiveBytes();
+    } while (host.now_ns < time_ns);
+}
+
+void FirmwareHost::Configure(const FirmwareHostSettings& settings)
+{
+    host.settings = settings;
+    host.start = std::chrono::steady_clock::now();
+    host.now_ns = 0;
+    host.byte_ns = 0;
+    host.transmit.clear();
+    host.transmit_end_ns = 0;
+    host.receive.clear();
+    host.scheduled_commands.clear();
+    host.last_conversion = 0;
+    host.at_line_start = true;
+    host.has_line = false;
+    host.full_rate_pending = false;
+
+    std::lock_guard<std::mutex> lock(host.statistics_lock);
+    host.statistics = FirmwareHostStatistics();
+}
+
+void FirmwareHost::Setup()
+{
+    setup();
+}
+
+void FirmwareHost::Loop()
+{
+    {
+        std::lock_guard<std::mutex> lock(host.statistics_lock);
+        host.statistics.loops++;
+    }
+    loop();
+}
+
+uint64_t FirmwareHost::GetMicros()
+{
+    return host.now_ns / 1000;
+}
+
+void FirmwareHost::Advance(uint64_t microseconds)
+{
+    AdvanceTo(host.now_ns + microseconds * 1000);
+}
+
+double FirmwareHost::GetSteadyTime(uint64_t micros)
+{
+    return std::chrono::duration<double>(host.start.time_since_epoch()).count() + micros / 1e6;
+}
+
+void FirmwareHost::ScheduleCommand(uint64_t micros, char command)
+{
+    host.scheduled_commands.emplace(micros * 1000, static_cast<uint8_t>(command));
+}
+
+FirmwareHostStatistics FirmwareHost::GetStatistics()
+{
+    std::lock_guard<std::mutex> lock(host.statistics_lock);
+    return host.statistics;
+}
+
+int32_t FirmwareHost::ReadAdc()
+{
+    uint64_t interval_ns = static_cast<uint64_t>(host.settings.conversion_interval_us) * 1000;
+
+    // A conversion stays readable until the next one, a read right after it waits for
+    // the next conversion to finish.
+    uint64_t conversion = host.now_ns / interval_ns;
+    if (conversion <= host.last_conversion)
+    {
+        conversion = host.last_conversion + 1;
+        AdvanceTo(conversion * interval_ns);
+    }
+    host.last_conversion = conversion;
+
+    int32_t count = host.settings.adc ? host.settings.adc(conversion) : 0;
+    AdvanceTo(host.now_ns + static_cast<uint64_t>(host.settings.shift_out_us) * 1000);
+
+    std::lock_guard<std::mutex> lock(host.statistics_lock);
+    host.statistics.conversions++;
+    return std::min(ADC_MAX, std::max(ADC_MIN, count));
+}
+
+bool FirmwareHost::IsAdcReady()
+{
+    return host.now_ns / (static_cast<uint64_t>(host.settings.conversion_interval_us) * 1000) > host.last_conversion;
+}
+
+int FirmwareHost::OpenTerminal(const std::string& link_path, std::string& terminal_path)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0)
+        return -1;
+    const char* path = nullptr;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || (path = ptsname(master)) == nullptr)
+    {
+        close(master);
+        return -1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    fcntl(master, F_SETFD, FD_CLOEXEC);
+
+    // Without raw mode the terminal would echo the output back as commands until the
+    // driver opens it.
+    termios options = {};
+    if (tcgetattr(master, &options) == 0)
+    {
+        cfmakeraw(&options);
+        tcsetattr(master, TCSANOW, &options);
+    }
+
+    terminal_path = path;
+    if (!link_path.empty())
+    {
+        unlink(link_path.c_str());
+        if (symlink(terminal_path.c_str(), link_path.c_str()) != 0)
+            printf("cannot link %s to %s\n", link_path.c_str(), terminal_path.c_str());
+    }
+    return master;
+}
+
+unsigned long millis()
+{
+    AdvanceTo(host.now_ns + CLOCK_READ_NS);
+    // The AVR has a 32 bit unsigned long, the clock wraps after 49 days.
+    return static_cast<uint32_t>(host.now_ns / 1000000);
+}
+
+unsigned long micros()
+{
+    AdvanceTo(host.now_ns + CLOCK_READ_NS);
+    return static_cast<uint32_t>(host.now_ns / 1000);
+}
+
+void delay(unsigned long milliseconds)
+{
+    AdvanceTo(host.now_ns + static_cast<uint64_t>(milliseconds) * 1000000);
+}
+
+void delayMicroseconds(unsigned int microseconds)
+{
+    AdvanceTo(host.now_ns + static_cast<uint64_t>(microseconds) * 1000);
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
+
+int digitalRead(uint8_t)
+{
+    return LOW;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t count = 0;
+    while (size-- > 0)
+        count += this->write(*buffer++);
+    return count;
+}
+
+size_t Print::print(const char* text)
+{
+    size_t count = 0;
+    while (*text != '\0')
+        count += this->write(static_cast<uint8_t>(*text++));
+    return count;
+}
+
+size_t Print::print(char value)
+{
+    return this->write(static_cast<uint8_t>(value));
+}
+
+size_t Print::print(int value, int base)
+{
+    return this->print(static_cast<long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return this->print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(long value, int base)
+{
+    if (base == 0)
+        return this->write(static_cast<uint8_t>(value));
+    if (base == 10 && value < 0)
+        return this->print('-') + this->PrintNumber(static_cast<unsigned long>(-value), 10);
+    return this->PrintNumber(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    if (base == 0)
+        return this->write(static_cast<uint8_t>(value));
+    return this->PrintNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    return this->PrintFloat(static_cast<float>(value), digits);
+}
+
+size_t Print::println()
+{
+    return this->print("\r\n");
+}
+
+size_t Print::println(const char* text)
+{
+    size_t count = this->print(text);
+    return count + this->println();
+}
+
+size_t Print::println(char value)
+{
+    size_t count = this->print(value);
+    return count + this->println();
+}
+
+size_t Print::println(int value, int base)
+{
+    size_t count = this->print(value, base);
+    return count + this->println();
+}
+
+size_t Print::println(unsigned int value, int base)
+{
+    size_t count = this->print(value, base);
+    return count + this->println();
+}
+
+size_t Print::println(long value, int base)
+{
+    size_t count = this->print(value, base);
+    return count + this->println();
+}
+
+size_t Print::println(unsigned long value, int base)
+{
+    size_t count = this->print(value, base);
+    return count + this->println();
+}
+
+size_t Print::println(double value, int digits)
+{
+    size_t count = this->print(value, digits);
+    return count + this->println();
+}
+
+size_t Print::PrintNumber(unsigned long value, int base)
+{
+    if (base < 2)
+        base = 10;
+
+    char buffer[8 * sizeof(unsigned long) + 1];
+    char* digit = &buffer[sizeof(buffer) - 1];
+    *digit = '\0';
+    do
+    {
+        unsigned long remainder = value % base;
+        value /= base;
+        *--digit = static_cast<char>(remainder < 10 ? remainder + '0' : remainder + 'A' - 10);
+    } while (value != 0);
+    return this->print(digit);
+}
+
+size_t Print::PrintFloat(float value, int digits)
+{
+    // The algorithm of the Arduino core, including its rounding and limits.
+    if (isnan(value))
+        return this->print("nan");
+    if (isinf(value))
+        return this->print("inf");
+    if (value > 4294967040.0f || value < -4294967040.0f)
+        return this->print("ovf");
+
+    size_t count = 0;
+    if (value < 0.0f)
+    {
+        count += this->print('-');
+        value = -value;
+    }
+
+    float rounding = 0.5f;
+    for (int i = 0; i < digits; i++)
+        rounding /= 10.0f;
+    value += rounding;
+
+    uint32_t integer = static_cast<uint32_t>(value);
+    float remainder = value - static_cast<float>(integer);
+    count += this->print(static_cast<unsigned long>(integer));
+
+    if (digits > 0)
+        count += this->print('.');
+    while (digits-- > 0)
+    {
+        remainder *= 10.0f;
+        unsigned int digit = static_cast<unsigned int>(remainder);
+        count += this->print(digit);
+        remainder -= static_cast<float>(digit);
+    }
+    return count;
+}
+
+void HardwareSerial::begin(unsigned long baud_rate)
+{
+    // 8N1 puts 10 bits on the wire for every byte.
+    host.byte_ns = 10000000000ULL / baud_rate;
+}
+
+void HardwareSerial::end()
+{
+    this->flush();
+}
+
+void HardwareSerial::flush()
+{
+    if (!host.transmit.empty())
+        AdvanceTo(host.transmit.back().second);
+}
+
+int HardwareSerial::available()
+{
+    ReceiveBytes();
+    return static_cast<int>(host.receive.size());
+}
+
+int HardwareSerial::read()
+{
+    if (host.receive.empty())
+        return -1;
+    uint8_t value = host.receive.front();
+    host.receive.pop_front();
+    return value;
+}
+
+int HardwareSerial::peek()
+{
+    return host.receive.empty() ? -1 : host.receive.front();
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+    // A full transmit buffer blocks the caller until the UART took the oldest byte.
+    uint64_t start_ns = host.now_ns;
+    while (host.transmit.size() >= host.settings.transmit_buffer_size)
+        AdvanceTo(host.transmit.front().second);
+    uint64_t blocked_ns = host.now_ns - start_ns;
+
+    uint64_t begin_ns = std::max(host.now_ns, host.transmit_end_ns);
+    host.transmit_end_ns = begin_ns + host.byte_ns;
+    host.transmit.emplace_back(value, host.transmit_end_ns);
+
+    std::lock_guard<std::mutex> lock(host.statistics_lock);
+    FirmwareHostStatistics& statistics = host.statistics;
+    statistics.bytes++;
+    statistics.blocked_us += blocked_ns / 1000;
+    statistics.max_blocked_us = std::max(statistics.max_blocked_us, blocked_ns / 1000);
+    statistics.max_transmit_queue = std::max<uint64_t>(statistics.max_transmit_queue, host.transmit.size());
+
+    if (host.at_line_start)
+    {
+        if (host.has_line)
+        {
+            uint64_t interval_us = (host.now_ns - host.last_line_start_ns) / 1000;
+            statistics.min_line_interval_us = statistics.lines > 1 ? std::min(statistics.min_line_interval_us, interval_us) : interval_us;
+            statistics.max_line_interval_us = std::max(statistics.max_line_interval_us, interval_us);
+        }
+        if (host.full_rate_pending)
+        {
+            statistics.max_full_rate_response_us = std::max(statistics.max_full_rate_response_us,
+                (host.now_ns - host.full_rate_command_ns) / 1000);
+            host.full_rate_pending = false;
+        }
+        host.has_line = true;
+        host.last_line_start_ns = host.now_ns;
+    }
+    host.at_line_start = value == '\n';
+    if (host.at_line_start)
+        statistics.lines++;
+    return 1;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Settings of the hardware around the firmware running on the host.
+ */
+struct FirmwareHostSettings
+{
+    // Paces the virtual clock with the steady clock, so that a driver can read the output
+    // in real time. Otherwise the virtual time runs as fast as the host can.
+    bool realtime = false;
+    // Transmit buffer of the AVR core plus the data register of the UART.
+    uint32_t transmit_buffer_size = 65;
+    uint32_t receive_buffer_size = 64;
+    // The HX711 converts with 10 samples per second, or 80 with its RATE pin high.
+    uint32_t conversion_interval_us = 100000;
+    // Clocking the 25 bits out of the HX711 with digitalWrite on a 16 MHz AVR.
+    uint32_t shift_out_us = 120;
+    // Raw count of the conversion with the given number, the first one has the number 1.
+    std::function<int32_t(uint64_t conversion)> adc;
+    // The master side of a pseudo terminal, which receives the output and sends the
+    // commands. -1 drops the output.
+    int serial_fd = -1;
+};
+
+/**
+ * Timing of the firmware as seen on its serial output, in virtual microseconds.
+ */
+struct FirmwareHostStatistics
+{
+    uint64_t loops = 0;
+    // Conversions the firmware read, the HX711 keeps converting in between.
+    uint64_t conversions = 0;
+    uint64_t lines = 0;
+    uint64_t bytes = 0;
+    uint64_t commands = 0;
+    // Time a write spent waiting for room in the transmit buffer, i.e. the time the loop
+    // was blocked by the serial output.
+    uint64_t blocked_us = 0;
+    uint64_t max_blocked_us = 0;
+    uint64_t max_transmit_queue = 0;
+    // Time between the first bytes of two lines.
+    uint64_t min_line_interval_us = 0;
+    uint64_t max_line_interval_us = 0;
+    // Time from the arrival of a full rate command until the first byte of the next line.
+    uint64_t max_full_rate_response_us = 0;
+};
+
+/**
+ * Runs the unmodified sketch of the load cell module against the mock Arduino core and
+ * HX711. There is only one module per process, like the globals of the sketch.
+ */
+class FirmwareHost
+{
+public:
+    /**
+     * Sets up the hardware and starts the virtual time at 0. Must be called before Setup().
+     */
+    static void Configure(const FirmwareHostSettings& settings);
+
+    /**
+     * Runs setup() of the sketch.
+     */
+    static void Setup();
+
+    /**
+     * Runs loop() of the sketch once.
+     */
+    static void Loop();
+
+    static uint64_t GetMicros();
+
+    /**
+     * Lets the given virtual time pass. Sends the bytes due on the serial port and
+     * receives the commands, in real time mode also sleeps until the time has come.
+     */
+    static void Advance(uint64_t microseconds);
+
+    /**
+     * Returns the steady clock time in seconds of the given virtual time in real time mode.
+     */
+    static double GetSteadyTime(uint64_t micros);
+
+    /**
+     * Puts a command into the receive buffer at the given virtual time, as if it arrived
+     * on the serial port then.
+     */
+    static void ScheduleCommand(uint64_t micros, char command);
+
+    static FirmwareHostStatistics GetStatistics();
+
+    /**
+     * Waits for the next conversion of the ADC and returns its raw count, for HX711.
+     */
+    static int32_t ReadAdc();
+
+    static bool IsAdcReady();
+
+    /**
+     * Creates a pseudo terminal in raw mode for serial_fd and returns its master, or -1.
+     * The path of the terminal is returned in terminal_path. A non-empty link_path gets
+     * a symbolic link to it.
+     */
+    static int OpenTerminal(const std::string& link_path, std::string& terminal_path);
+};
@@ -0,0 +1,229 @@
+/**
+ * Runs the load cell module firmware on the host. By default the virtual time runs as
+ * fast as possible for the given seconds, and the timing of the serial output is
+ * checked against the conversion rate of the HX711:
+ *
+ *     firmware_host --seconds 60 --command 20:S --command 30:F --check
+ *
+ * With --pty the firmware runs in real time on a pseudo terminal, which the driver
+ * connects to like to the module:
+ *
+ *     firmware_host --pty --link /tmp/treadmill --csv ../validation/data/02_walk_test.csv
+ *
+ * The ADC delivers the counts of a recording of the validation folder or a synthetic
+ * walk on top of the count of the unloaded load cell, which the tare of the firmware
+ * removes again.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "firmware_host.h"
+
+// Count of the unloaded load cell, removed by the tare.
+static const int32_t UNLOADED_COUNT = 84000;
+static const double PI = 3.14159265358979;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void RequestStop(int)
+{
+    stop_requested = 1;
+}
+
+static void PrintUsage()
+{
+    printf(
+        "usage: firmware_host [options]\n"
+        "  --seconds S        virtual seconds to run (default 60, endless with --pty)\n"
+        "  --csv FILE         counts of a recording with one value per line\n"
+        "  --sps N            conversions per second of the HX711, 10 or 80 (default 10)\n"
+        "  --command T:C      sends the command character C at second T\n"
+        "  --pty              runs in real time on a pseudo terminal\n"
+        "  --link PATH        link to the pseudo terminal\n"
+        "  --check            fails if the output timing is off\n");
+}
+
+/**
+ * Reads the counts of a recording, lines without a number are skipped.
+ */
+static bool LoadCounts(const char* file, std::vector<int32_t>& counts)
+{
+    FILE* input = fopen(file, "r");
+    if (input == nullptr)
+        return false;
+    char line[128];
+    while (fgets(line, sizeof(line), input) != nullptr)
+    {
+        char* end = nullptr;
+        double value = std::strtod(line, &end);
+        if (end != line && std::isfinite(value))
+            counts.push_back(static_cast<int32_t>(value));
+    }
+    fclose(input);
+    return !counts.empty();
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = -1.0;
+    double sps = 10.0;
+    bool pty = false;
+    bool check = false;
+    std::string link_path = "";
+    std::vector<int32_t> counts;
+    std::vector<std::pair<double, char>> commands;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--pty")
+            pty = true;
+        else if (option == "--check")
+            check = true;
+        else if (option == "--help" || i + 1 == argc)
+        {
+            PrintUsage();
+            return option == "--help" ? 0 : 1;
+        }
+        else if (option == "--seconds")
+            seconds = std::atof(argv[++i]);
+        else if (option == "--sps")
+            sps = std::atof(argv[++i]);
+        else if (option == "--link")
+            link_path = argv[++i];
+        else if (option == "--csv")
+        {
+            if (!LoadCounts(argv[++i], counts))
+            {
+                printf("cannot read counts from %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (option == "--command")
+        {
+            const char* value = argv[++i];
+            const char* separator = std::strchr(value, ':');
+            if (separator == nullptr || separator[1] == '\0')
+            {
+                PrintUsage();
+                return 1;
+            }
+            commands.emplace_back(std::atof(value), separator[1]);
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (seconds < 0.0)
+        seconds = pty ? 0.0 : 60.0;
+    if (sps <= 0.0 || (!pty && seconds <= 0.0))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    FirmwareHostSettings settings;
+    settings.conversion_interval_us = static_cast<uint32_t>(1e6 / sps);
+    settings.realtime = pty;
+
+    // The recording starts with the first conversion after the setup, the tare of the
+    // setup sees the unloaded load cell.
+    bool setup_done = false;
+    uint64_t first_conversion = 0;
+    settings.adc = [&](uint64_t conversion) -> int32_t {
+        if (!setup_done)
+            return UNLOADED_COUNT;
+        if (first_conversion == 0)
+            first_conversion = conversion;
+        uint64_t index = conversion - first_conversion;
+        if (!counts.empty())
+            return UNLOADED_COUNT + counts[index % counts.size()];
+        double time = index / sps;
+        return UNLOADED_COUNT + static_cast<int32_t>(450000.0 + 200000.0 * std::sin(2.0 * PI * 1.8 * time));
+    };
+
+    std::string terminal_path = "";
+    if (pty)
+    {
+        settings.serial_fd = FirmwareHost::OpenTerminal(link_path, terminal_path);
+        if (settings.serial_fd < 0)
+        {
+            printf("cannot create a pseudo terminal\n");
+            return 1;
+        }
+        printf("running the load cell module on %s\n", link_path.empty() ? terminal_path.c_str() : link_path.c_str());
+        fflush(stdout);
+    }
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+
+    FirmwareHost::Configure(settings);
+    for (const std::pair<double, char>& command : commands)
+        FirmwareHost::ScheduleCommand(static_cast<uint64_t>(command.first * 1e6), command.second);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FirmwareHost::Setup();
+    setup_done = true;
+    uint64_t setup_us = FirmwareHost::GetMicros();
+    while (!stop_requested && (seconds <= 0.0 || FirmwareHost::GetMicros() < seconds * 1e6))
+        FirmwareHost::Loop();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (settings.serial_fd >= 0)
+        close(settings.serial_fd);
+    if (!link_path.empty())
+        unlink(link_path.c_str());
+
+    FirmwareHostStatistics statistics = FirmwareHost::GetStatistics();
+    double virtual_seconds = FirmwareHost::GetMicros() / 1e6;
+    double output_seconds = (FirmwareHost::GetMicros() - setup_us) / 1e6;
+    printf("virtual time %.1f s in %.3f s, setup %.2f s\n", virtual_seconds, elapsed, setup_us / 1e6);
+    printf("loops %llu, conversions %llu, lines %llu (%.2f per second), bytes %llu, commands %llu\n",
+        static_cast<unsigned long long>(statistics.loops), static_cast<unsigned long long>(statistics.conversions),
+        static_cast<unsigned long long>(statistics.lines), statistics.lines / output_seconds,
+        static_cast<unsigned long long>(statistics.bytes), static_cast<unsigned long long>(statistics.commands));
+    printf("line interval %.1f to %.1f ms, full rate response %.1f ms\n",
+        statistics.min_line_interval_us / 1e3, statistics.max_line_interval_us / 1e3,
+        statistics.max_full_rate_response_us / 1e3);
+    printf("blocked on the serial output %.1f ms in total, %.1f ms at most, transmit queue %llu bytes at most\n",
+        statistics.blocked_us / 1e3, statistics.max_blocked_us / 1e3,
+        static_cast<unsigned long long>(statistics.max_transmit_queue));
+
+    if (!check)
+        return 0;
+
+    // The module must send every conversion right away without waiting for the UART,
+    // and answer a full rate request with the next conversion.
+    double interval_us = 1e6 / sps;
+    bool success = true;
+    if (statistics.blocked_us > 0)
+    {
+        printf("check failed: the serial output blocked the loop\n");
+        success = false;
+    }
+    if (commands.empty() && (statistics.max_line_interval_us > 1.5 * interval_us || statistics.min_line_interval_us < 0.5 * interval_us))
+    {
+        printf("check failed: the lines do not follow the conversions\n");
+        success = false;
+    }
+    if (statistics.max_full_rate_response_us > interval_us + 15000.0)
+    {
+        printf("check failed: a full rate request waited longer than a conversion\n");
+        success = false;
+    }
+    if (success)
+        printf("timing checks passed\n");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,8 @@
+/**
+ * The unmodified sketch of the load cell module as a C++ translation unit. The Arduino
+ * IDE includes Arduino.h in front of a sketch as well.
+ */
+
+#include "Arduino.h"
+
+#include "../load_cell_module.ino"
@@ -15,6 +15,21 @@ uint8_t data_pin  = 4;
 uint8_t clock_pin = 3;
 HX711 treadmill;
 
+/*
+Sends the raw load cell counts instead of the normalized value. The driver then
+normalizes with its calibration range, which can be determined automatically with
+its calibration mode instead of hard-coding the bounds below.
+*/
+const bool send_raw_counts = false;
+
+/*
+The driver controls the output rate with single command characters. 'S' enters the
+standby mode, in which only one heartbeat sample per standby_heartbeat_ms is sent, so
+that the PC can sleep while the headset is idle. 'F' returns to full rate streaming.
+*/
+const unsigned long standby_heartbeat_ms = 1000;
+bool standby = false;
+
 float raw_measurement(float value)
 {
   return value;
@@ -45,6 +60,29 @@ float normalize_measurement(float value, float min_value, float max_value)
   return result;
 }
 
+void handle_commands()
+{
+  while(Serial.available() > 0)
+  {
+    char command = Serial.read();
+    if(command == 'S')
+      standby = true;
+    else if(command == 'F')
+      standby = false;
+  }
+}
+
+void send_measurement(float raw_value)
+{
+  if(send_raw_counts)
+  {
+    Serial.println(raw_value);
+    return;
+  }
+  float normalized_value = normalize_measurement(raw_value, 100000.0, 800000.0);
+  Serial.println(normalized_value);
+}
+
 
 void setup()
 {
@@ -57,12 +95,31 @@ void setup()
 
 void loop()
 {
+  handle_commands();
+  if(standby)
+  {
+    /*
+    The HX711 is not read during the wait. It keeps converting on its own, so the
+    heartbeat after the wait carries a fresh conversion and the ones in between are
+    skipped. The wait is split into short slices, so that a full rate request is
+    answered with the next conversion instead of after the remaining heartbeat
+    interval.
+    */
+    unsigned long start = millis();
+    while(millis() - start < standby_heartbeat_ms)
+    {
+      delay(10);
+      handle_commands();
+      if(!standby)
+        return;
+    }
+  }
+
   float raw_value = treadmill.get_units();
   /*
   This is an active decision against smoothing. A useful EMA smoothing would lead
   to too much latency for a useful game input device.
   */
   // float smoothed_value = ema_measurement(raw_value, 0.07);
-  float normalized_value = normalize_measurement(raw_value, 100000.0, 800000.0);
-  Serial.println(normalized_value);
+  send_measurement(raw_value);
 }
@@ -0,0 +1,102 @@
+"""
+Reads a session recording of the driver (see session_recording_folder) and
+prints its metadata, event counts and gaps. Also reads the recording of a
+crashed session, up to the last records the driver wrote.
+
+    session_reader.py FILE [--csv OUT] [--values OUT]
+
+--csv exports all samples with their timestamps, --values only the raw values
+one per line, which device_simulator --csv and replay_benchmark replay.
+"""
+
+import argparse
+import datetime
+import struct
+import sys
+
+FILE_MAGIC = 0x53534D54
+CHUNK_MAGIC = 0x4B484354
+HEADER = struct.Struct("<6I2dQ")
+HEADER_METADATA_OFFSET = HEADER.size
+CHUNK_HEADER = struct.Struct("<4I2Q")
+RECORD = struct.Struct("<2dI2H2f")
+RECORD_TYPES = {1: "sample", 2: "read_error", 3: "connect", 4: "disconnect",
+                5: "reconnect", 6: "standby", 7: "calibration_start", 8: "config"}
+GAIT_PHASES = ["idle", "walking", "running"]
+
+def read_session(data: bytes) -> tuple:
+    (magic, version, header_size, chunk_size, record_size, closed,
+     start_host_time, start_unix_time, lost_records) = HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC or version != 1 or record_size != RECORD.size:
+        raise ValueError("not a session recording of version 1")
+    metadata = data[HEADER_METADATA_OFFSET:header_size].split(b"\0", 1)[0].decode("utf-8", "replace")
+    header = {"closed": closed != 0, "lost_records": lost_records, "start_host_time": start_host_time,
+              "start_unix_time": start_unix_time, "metadata": metadata}
+
+    # A chunk without its magic was not started yet, only the committed records count.
+    records = []
+    offset = header_size
+    index = 0
+    while offset + chunk_size <= len(data):
+        chunk_magic, chunk_index, record_count = CHUNK_HEADER.unpack_from(data, offset)[:3]
+        if chunk_magic != CHUNK_MAGIC or chunk_index != index:
+            break
+        record_count = min(record_count, chunk_size // record_size - 1)
+        for position in range(record_count):
+            records.append(RECORD.unpack_from(data, offset + (position + 1) * record_size))
+        offset += chunk_size
+        index += 1
+    return header, records
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Reads a session recording of the treadmill driver.")
+    parser.add_argument("file")
+    parser.add_argument("--csv", help="writes all samples into this CSV file")
+    parser.add_argument("--values", help="writes the raw values one per line into this file")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as file:
+        data = file.read()
+    try:
+        header, records = read_session(data)
+    except (ValueError, struct.error) as error:
+        print(f"{args.file}: {error}")
+        sys.exit(1)
+
+    start = datetime.datetime.fromtimestamp(header["start_unix_time"])
+    print(f"Session started {start:%Y-%m-%d %H:%M:%S}, "
+          f"{'closed' if header['closed'] else 'not closed, the driver crashed or is still recording'}")
+    for line in header["metadata"].splitlines():
+        print("  " + line)
+
+    counts = {}
+    gaps = 0
+    lost = 0
+    for previous, record in zip(records, records[1:]):
+        if record[2] != previous[2] + 1:
+            gaps += 1
+            lost += (record[2] - previous[2] - 1) & 0xFFFFFFFF
+    for record in records:
+        counts[record[3]] = counts.get(record[3], 0) + 1
+    if records:
+        duration = records[-1][0] - header["start_host_time"]
+        print(f"{len(records)} records over {duration:.1f} s, {lost} lost in {gaps} gaps")
+    if header["lost_records"] > lost:
+        print(f"  {header['lost_records']} records lost in total")
+    for record_type, count in sorted(counts.items()):
+        print(f"  {RECORD_TYPES.get(record_type, record_type)}: {count}")
+
+    samples = [record for record in records if record[3] == 1]
+    if args.csv:
+        with open(args.csv, "w") as output:
+            output.write("sequence,host_time,device_time,raw_value,value,gait,step,binary\n")
+            for host_time, device_time, sequence, _, flags, raw_value, value in samples:
+                output.write(f"{sequence},{host_time - header['start_host_time']:.6f},"
+                             f"{device_time - header['start_host_time']:.6f},{raw_value:.6g},{value:.6g},"
+                             f"{GAIT_PHASES[flags & 3] if flags & 3 < 3 else flags & 3},{flags >> 2 & 1},{flags >> 3 & 1}\n")
+        print(f"{len(samples)} samples written to {args.csv}")
+    if args.values:
+        with open(args.values, "w") as output:
+            for record in samples:
+                output.write(f"{record[5]:.6g}\n")
+        print(f"{len(samples)} values written to {args.values}")
@@ -0,0 +1,60 @@
+"""
+Prints the live state the driver publishes in shared memory while SteamVR
+is running. Pass the serial number of the treadmill device as argument.
+"""
+
+import mmap
+import struct
+import sys
+import time
+
+MAGIC = 0x54454D54
+HEADER = struct.Struct("<4I")
+SEQUENCE = struct.Struct("<Q")
+VALUES = struct.Struct("<4d8Q5f3I")
+VALUES_OFFSET = 64
+BLOCK_SIZE = 256
+GAIT_PHASES = ["idle", "walking", "running"]
+
+def open_block(serial_number: str) -> mmap.mmap:
+    name = "CustomTreadmill_" + serial_number
+    if sys.platform == "win32":
+        return mmap.mmap(-1, BLOCK_SIZE, tagname="Local\\" + name, access=mmap.ACCESS_READ)
+    with open("/dev/shm/" + name, "rb") as file:
+        return mmap.mmap(file.fileno(), BLOCK_SIZE, access=mmap.ACCESS_READ)
+
+def read_values(block: mmap.mmap) -> tuple:
+    # Seqlock: retry while the driver is writing or wrote in between.
+    while True:
+        before = SEQUENCE.unpack_from(block, VALUES_OFFSET)[0]
+        values = VALUES.unpack_from(block, VALUES_OFFSET + SEQUENCE.size)
+        after = SEQUENCE.unpack_from(block, VALUES_OFFSET)[0]
+        if before == after and before % 2 == 0:
+            return values
+
+if __name__ == "__main__":
+    serial_number = sys.argv[1] if len(sys.argv) > 1 else "CustomTreadmillDevice"
+    block = open_block(serial_number)
+
+    magic, version, size, process_id = HEADER.unpack_from(block, 0)
+    if magic != MAGIC or version != 1:
+        print("No driver is publishing metrics for " + serial_number)
+        sys.exit(1)
+    print(f"Driver process {process_id}. Press Ctrl+C to stop.")
+
+    try:
+        while True:
+            (timestamp, first_byte_time, publish_time, write_time,
+             sequence, samples, read_errors, reconnects, removed_spikes,
+             frames, input_updates, consumed_samples,
+             value, force, axis_x, axis_y, cadence,
+             gait_phase, connected, standby) = read_values(block)
+            print(f"#{sequence} value {value:.3f} force {force:.3f} axes ({axis_x:+.2f}, {axis_y:+.2f}) "
+                  f"{GAIT_PHASES[gait_phase]} {cadence:.0f}/min "
+                  f"{'connected' if connected else 'disconnected'}{' standby' if standby else ''} "
+                  f"errors {read_errors} reconnects {reconnects}")
+            time.sleep(0.1)
+    except KeyboardInterrupt:
+        print("Monitoring stopped.")
+    finally:
+        block.close()
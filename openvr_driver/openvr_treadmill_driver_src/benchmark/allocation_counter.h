@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Counts the heap allocations of the benchmark process. Replacing the global operator
+ * new makes every allocation visible, including the ones inside the standard library.
+ * Therefore this header must only be included by the single source file of a benchmark.
+ */
+inline std::atomic<size_t> allocations{ 0 };
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* memory = std::malloc(size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,94 @@
+/**
+ * Soak test of the capture against the device simulator. Streams the mixed gait profile
+ * at 80 Hz with jitter, lost and corrupted lines, stalls and a hang up of the pseudo
+ * terminal every 10 seconds, once in the text and once in the binary protocol. Reports
+ * what the simulator sent next to what the capture received, how often it reconnected
+ * and the latency of the lines.
+ *
+ * The faults come from a fixed seed, so two runs see the same stream. The duration of a
+ * protocol in seconds can be given as the first argument, the default is 30.
+ *
+ * Needs a POSIX pseudo terminal. Built by the CMake project as capture_soak_benchmark.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "device_simulator.h"
+#include "mock_driver_host.h"
+#include "treadmill_capture.h"
+
+static const double SAMPLE_RATE = 80.0;
+
+/**
+ * Runs the capture against the simulator for the given seconds and prints the counters
+ * of both sides.
+ */
+static bool Soak(SimulatorProtocol protocol, double seconds)
+{
+    SimulatorSettings settings;
+    settings.protocol = protocol;
+    settings.rate = SAMPLE_RATE;
+    settings.jitter = 0.002;
+    settings.drop_probability = 0.01;
+    settings.corrupt_probability = 0.01;
+    settings.stall_probability = 0.002;
+    settings.stall_duration = 0.3;
+    settings.disconnect_interval = 10.0;
+    settings.disconnect_duration = 1.0;
+    settings.link_path = "/tmp/treadmill_soak_" + std::to_string(getpid());
+
+    DeviceSimulator simulator(settings, ModuleModel::MakeGaitProfile(GaitProfile::MIXED, SAMPLE_RATE, settings.seed));
+    if (!simulator.Start())
+    {
+        printf("cannot create a pseudo terminal\n");
+        return false;
+    }
+
+    TreadmillCapture capture;
+    capture.Configure(SignalPipelineSettings(), simulator.GetPort());
+    capture.StartBackgroundCapture();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    capture.StopBackgroundCapture();
+    simulator.Stop();
+
+    SimulatorStatistics sent = simulator.GetStatistics();
+    CaptureStatistics& received = capture.GetStatistics();
+    printf("%s protocol, %.0f s\n", protocol == SimulatorProtocol::BINARY ? "binary" : "ascii", seconds);
+    printf("  simulator: lines %llu, dropped %llu, corrupted %llu, stalls %llu, disconnects %llu, commands %llu\n",
+        static_cast<unsigned long long>(sent.lines), static_cast<unsigned long long>(sent.dropped),
+        static_cast<unsigned long long>(sent.corrupted), static_cast<unsigned long long>(sent.stalls),
+        static_cast<unsigned long long>(sent.disconnects), static_cast<unsigned long long>(sent.commands));
+    printf("  capture:   samples %llu, read errors %llu, reconnects %llu, wakeups %llu\n",
+        static_cast<unsigned long long>(received.samples.load()), static_cast<unsigned long long>(received.read_errors.load()),
+        static_cast<unsigned long long>(received.reconnects.load()), static_cast<unsigned long long>(received.wakeups.load()));
+    printf("  line latency:       p50 %llu us, p99 %llu us, max %llu us\n",
+        static_cast<unsigned long long>(received.line_latency.GetPercentile(0.5)),
+        static_cast<unsigned long long>(received.line_latency.GetPercentile(0.99)),
+        static_cast<unsigned long long>(received.line_latency.GetMax()));
+    printf("  processing latency: p50 %llu us, p99 %llu us, max %llu us\n",
+        static_cast<unsigned long long>(received.processing_latency.GetPercentile(0.5)),
+        static_cast<unsigned long long>(received.processing_latency.GetPercentile(0.99)),
+        static_cast<unsigned long long>(received.processing_latency.GetMax()));
+
+    // Every disconnect must end in a reconnect, otherwise the capture got stuck.
+    return received.samples.load() > 0 && received.reconnects.load() >= sent.disconnects;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 30.0;
+
+    // The capture logs its connection changes through the driver context.
+    MockDriverHost host;
+    vr::InitServerDriverContext(&host);
+
+    bool success = Soak(SimulatorProtocol::ASCII, seconds) && Soak(SimulatorProtocol::BINARY, seconds);
+    printf(success ? "the capture recovered from every fault\n" : "the capture did not recover\n");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/**
+ * Benchmark of the per frame cost of the direction aware locomotion. Replays the
+ * work MyDeviceProvider::RunFrame and TreadmillDeviceDriver::PublishInputs do for
+ * the direction mapping against the mock driver host, whose HMD turns slowly back and
+ * forth, and counts the heap allocations made on the way.
+ *
+ * Built by the CMake project as direction_benchmark.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "allocation_counter.h"
+#include "direction_mapper.h"
+#include "mock_driver_host.h"
+
+int main()
+{
+    const int FRAMES = 10000000;
+
+    MockDriverHost mock_host;
+    mock_host.SetRecording(false);
+    vr::IVRServerDriverHost* host = &mock_host;
+
+    DirectionSettings settings;
+    settings.mode = DirectionMode::HMD_YAW;
+    settings.tether_yaw = 0.2f;
+    DirectionMapper mapper(settings);
+
+    float max_error = 0.0f;
+    float checksum = 0.0f;
+    size_t allocations_before = allocations;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        float yaw = 1.2f * std::sin(frame * 1.0e-4f);
+        mock_host.SetHmdPose(yaw, 0.0f, 1.7f, 0.0f);
+
+        vr::TrackedDevicePose_t hmd_pose = {};
+        host->GetRawTrackedDevicePoses(0.0f, &hmd_pose, 1);
+
+        bool valid = hmd_pose.bPoseIsValid && hmd_pose.eTrackingResult == vr::TrackingResult_Running_OK;
+        const vr::HmdMatrix34_t& matrix = hmd_pose.mDeviceToAbsoluteTracking;
+        float hmd_yaw = DirectionMapper::GetYaw(matrix.m);
+        float relative_yaw = mapper.Update(hmd_yaw, matrix.m[0][3], matrix.m[2][3], valid, true, frame / 90.0);
+
+        float x;
+        float y;
+        DirectionMapper::Split(0.5f, relative_yaw, x, y);
+        checksum += x + y;
+
+        if ((frame & 1023) == 0)
+        {
+            float expected = std::min(std::max(yaw - settings.tether_yaw, -settings.max_angle), settings.max_angle);
+            max_error = std::max(max_error, std::fabs(x - 0.5f * std::sin(expected)));
+            max_error = std::max(max_error, std::fabs(y - 0.5f * std::cos(expected)));
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t frame_allocations = allocations - allocations_before;
+
+    std::printf("frames:            %d\n", FRAMES);
+    std::printf("time per frame:    %.1f ns\n", elapsed / FRAMES * 1.0e9);
+    std::printf("allocations:       %zu\n", frame_allocations);
+    std::printf("max axis error:    %.2e\n", max_error);
+    std::printf("checksum:          %f\n", checksum);
+    return frame_allocations == 0 ? 0 : 1;
+}
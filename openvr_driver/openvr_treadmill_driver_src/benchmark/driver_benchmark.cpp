@@ -0,0 +1,124 @@
+/**
+ * Benchmark of the full driver stack without SteamVR. The device provider runs against
+ * the mock driver host at 90 Hz, while the device simulator plays the load cell module
+ * and sends a walking pattern at 80 Hz. Runs the frame driven and the sample driven
+ * publish mode and reports the cost of RunFrame, the input update stream the driver
+ * sent and the heap allocations of all threads while the frames ran. The latency of the
+ * publish modes is compared by publish_latency_benchmark.
+ *
+ * Needs a POSIX pseudo terminal. Built by the CMake project as driver_benchmark.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "allocation_counter.h"
+#include "device_provider.h"
+#include "device_settings.h"
+#include "mock_driver_host.h"
+
+#ifndef _WIN32
+#include "device_simulator.h"
+#endif
+
+static const double REFRESH_RATE = 90.0;
+static const double SAMPLE_RATE = 80.0;
+static const double MEASURED_SECONDS = 5.0;
+
+static const char* component_paths[] = {
+    "/input/trigger/value",
+    "/input/trackpad/y",
+    "/input/joystick/y",
+    "/input/trackpad/x",
+    "/input/joystick/x",
+    "/input/speed/value",
+    "/input/accel/value",
+    "/input/walking/click",
+    "/input/running/click",
+};
+
+#ifndef _WIN32
+
+/**
+ * Runs the driver in the given publish mode and prints what it did.
+ */
+static bool RunDriver(const std::string& port, const char* publish_mode)
+{
+    MockDriverHost host;
+    if (!host.LoadSettings(TREADMILL_DEFAULT_SETTINGS))
+    {
+        printf("cannot read %s\n", TREADMILL_DEFAULT_SETTINGS);
+        return false;
+    }
+    host.SetStringSetting(treadmill_main_settings_section, "port_match", port);
+    host.SetStringSetting(treadmill_main_settings_section, "publish_mode", publish_mode);
+    host.SetBoolSetting(treadmill_main_settings_section, "shared_metrics", false);
+
+    MyDeviceProvider provider;
+    if (provider.Init(&host) != vr::VRInitError_None || host.GetDeviceCount() != 1)
+    {
+        printf("the driver did not initialize\n");
+        return false;
+    }
+    vr::ITrackedDeviceServerDriver* device = host.GetDevice(1);
+
+    // The capture connects after its first reconnect, which takes about two seconds.
+    char response[4096];
+    for (int i = 0; i < 10; i++)
+    {
+        host.RunFrames(provider, REFRESH_RATE, static_cast<size_t>(REFRESH_RATE / 2));
+        device->DebugRequest("stats", response, sizeof(response));
+        if (std::strstr(response, "\"connected\":true") != nullptr && std::strstr(response, "\"samples\":0,") == nullptr)
+            break;
+    }
+
+    device->DebugRequest("reset", response, sizeof(response));
+    host.ClearRecording();
+    size_t allocations_before = allocations;
+    host.RunFrames(provider, REFRESH_RATE, static_cast<size_t>(REFRESH_RATE * MEASURED_SECONDS));
+    size_t frame_allocations = allocations - allocations_before;
+
+    const LatencyHistogram& cost = host.GetFrameCost();
+    printf("publish mode %s\n", publish_mode);
+    printf("  frames:            %zu\n", host.GetFrameCount());
+    printf("  RunFrame:          p50 %llu us, p99 %llu us, max %llu us\n",
+        static_cast<unsigned long long>(cost.GetPercentile(0.5)), static_cast<unsigned long long>(cost.GetPercentile(0.99)),
+        static_cast<unsigned long long>(cost.GetMax()));
+    printf("  input updates:     %zu (%.2f per frame)\n", host.GetInputUpdateCount(),
+        static_cast<double>(host.GetInputUpdateCount()) / host.GetFrameCount());
+    for (const char* path : component_paths)
+        printf("    %-22s %zu\n", path, host.GetInputUpdates(host.FindComponent(1, path)).size());
+    printf("  allocations while running frames: %zu\n", frame_allocations);
+    device->DebugRequest("stats", response, sizeof(response));
+    printf("  stats:   %s\n", response);
+
+    provider.Cleanup();
+    return true;
+}
+
+int main()
+{
+    SimulatorSettings settings;
+    settings.rate = SAMPLE_RATE;
+    DeviceSimulator simulator(settings, ModuleModel::MakeGaitProfile(GaitProfile::WALK, SAMPLE_RATE, settings.seed));
+    if (!simulator.Start())
+    {
+        printf("cannot create a pseudo terminal\n");
+        return 1;
+    }
+
+    bool success = RunDriver(simulator.GetPort(), "frame") && RunDriver(simulator.GetPort(), "sample");
+    simulator.Stop();
+    return success ? 0 : 1;
+}
+
+#else
+
+int main()
+{
+    printf("the driver benchmark needs a POSIX pseudo terminal\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * End to end benchmark from the firmware to the capture. The unmodified firmware of the
+ * load cell module runs in real time on the firmware host with its 9600 baud UART model
+ * and the conversion timing of the HX711, the capture reads it through a pseudo
+ * terminal. Reports the throughput and the latency from the end of a conversion in the
+ * HX711 until the first byte arrived and until the capture published the sample, for 10
+ * and 80 conversions per second.
+ *
+ * The seconds per rate can be given as the first argument, the default is 10. Needs a
+ * POSIX pseudo terminal. Built by the CMake project as firmware_benchmark.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "firmware_host.h"
+#include "mock_driver_host.h"
+#include "statistics.h"
+#include "treadmill_capture.h"
+
+static const double PI = 3.14159265358979;
+
+static void PrintHistogram(const char* name, const LatencyHistogram& histogram)
+{
+    printf("  %-28s p50 %llu us, p99 %llu us, max %llu us\n", name,
+        static_cast<unsigned long long>(histogram.GetPercentile(0.5)),
+        static_cast<unsigned long long>(histogram.GetPercentile(0.99)),
+        static_cast<unsigned long long>(histogram.GetMax()));
+}
+
+/**
+ * Runs the firmware with the given conversion rate against the capture and prints what
+ * arrived.
+ */
+static bool Run(double sps, double seconds)
+{
+    FirmwareHostSettings settings;
+    settings.realtime = true;
+    settings.conversion_interval_us = static_cast<uint32_t>(1e6 / sps);
+    // A walk of 1.8 steps per second on top of the unloaded load cell.
+    settings.adc = [sps](uint64_t conversion) -> int32_t {
+        return 84000 + static_cast<int32_t>(450000.0 + 200000.0 * std::sin(2.0 * PI * 1.8 * conversion / sps));
+    };
+
+    std::string terminal_path;
+    settings.serial_fd = FirmwareHost::OpenTerminal("", terminal_path);
+    if (settings.serial_fd < 0)
+    {
+        printf("cannot create a pseudo terminal\n");
+        return false;
+    }
+
+    FirmwareHost::Configure(settings);
+    std::atomic<bool> running{ true };
+    std::thread firmware([&running]() {
+        FirmwareHost::Setup();
+        while (running)
+            FirmwareHost::Loop();
+    });
+
+    TreadmillCapture capture;
+    capture.Configure(SignalPipelineSettings(), terminal_path);
+    capture.StartBackgroundCapture();
+
+    // The capture connects after its first reconnect, which takes about two seconds.
+    TreadmillSample sample;
+    uint64_t sequence = 0;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < end && !(capture.isConnected() && capture.GetStatistics().samples > 0))
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sequence = capture.GetTreadmillSample().sequence;
+
+    // Conversion k ends at k times the conversion interval on the virtual clock, the
+    // line of a sample belongs to the last conversion before its first byte.
+    LatencyHistogram first_byte_latency;
+    LatencyHistogram publish_latency;
+    uint64_t samples = 0;
+    double interval = 1.0 / sps;
+    double start_time = FirmwareHost::GetSteadyTime(0);
+    FirmwareHostStatistics firmware_before = FirmwareHost::GetStatistics();
+    end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+    while (std::chrono::steady_clock::now() < end)
+    {
+        if (!capture.WaitForSample(sequence, std::chrono::milliseconds(200), sample))
+            continue;
+        sequence = sample.sequence;
+        if (sample.first_byte_time <= 0.0)
+            continue;
+        double conversion_time = start_time + std::floor((sample.first_byte_time - start_time) / interval) * interval;
+        first_byte_latency.RecordSeconds(sample.first_byte_time - conversion_time);
+        publish_latency.RecordSeconds(sample.publish_time - conversion_time);
+        samples++;
+    }
+    FirmwareHostStatistics firmware_after = FirmwareHost::GetStatistics();
+
+    capture.StopBackgroundCapture();
+    running = false;
+    firmware.join();
+    close(settings.serial_fd);
+
+    uint64_t lines = firmware_after.lines - firmware_before.lines;
+    printf("%.0f conversions per second, %.0f s\n", sps, seconds);
+    printf("  lines sent %llu, samples %llu (%.1f per second), read errors %llu\n",
+        static_cast<unsigned long long>(lines), static_cast<unsigned long long>(samples), samples / seconds,
+        static_cast<unsigned long long>(capture.GetStatistics().read_errors.load()));
+    PrintHistogram("conversion to first byte:", first_byte_latency);
+    PrintHistogram("conversion to publication:", publish_latency);
+    PrintHistogram("line transfer:", capture.GetStatistics().line_latency);
+    printf("  firmware blocked on the serial output %.1f ms\n", firmware_after.blocked_us / 1e3);
+    return samples > 0;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+
+    // The capture logs its connection changes through the driver context.
+    MockDriverHost host;
+    vr::InitServerDriverContext(&host);
+
+    bool success = Run(10.0, seconds) && Run(80.0, seconds);
+    return success ? 0 : 1;
+}
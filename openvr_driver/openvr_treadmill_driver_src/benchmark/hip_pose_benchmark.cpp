@@ -0,0 +1,97 @@
+/**
+ * Benchmark of the virtual hip pose. Replays the per frame capture of the tracking
+ * state, the pose estimation and the pose update on the frame thread against the mock
+ * driver host. The HMD walks around the anchor at 90 frames per second while the load
+ * cell delivers a sample every 100 ms.
+ *
+ * Built by the CMake project as hip_pose_benchmark.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "allocation_counter.h"
+#include "direction_mapper.h"
+#include "hip_pose_estimator.h"
+#include "mock_driver_host.h"
+#include "seqlock.h"
+
+int main()
+{
+    const int FRAMES = 10000000;
+    const double FRAME_TIME = 1.0 / 90.0;
+    const double SAMPLE_TIME = 0.1;
+
+    MockDriverHost mock_host;
+    mock_host.SetRecording(false);
+    vr::IVRServerDriverHost* host = &mock_host;
+
+    Seqlock<vr::DriverPose_t> hip_pose;
+    HipPoseEstimator estimator;
+
+    double frame_seconds = 0.0;
+    size_t samples = 0;
+    double next_sample = 0.0;
+    float force = 0.0f;
+    double sample_timestamp = 0.0;
+    double checksum = 0.0;
+    size_t allocations_before = allocations;
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        double now = frame * FRAME_TIME;
+        float angle = static_cast<float>(0.6 * std::sin(now * 0.2));
+        float angular_velocity = static_cast<float>(0.12 * std::cos(now * 0.2));
+        mock_host.SetHmdPose(angle, 1.8f * std::sin(angle), 1.7f, -1.8f * std::cos(angle));
+        mock_host.SetHmdVelocity(1.8f * std::cos(angle) * angular_velocity, 0.0f, 1.8f * std::sin(angle) * angular_velocity);
+
+        // The capture thread delivers a new force sample every 100 ms.
+        if (now >= next_sample)
+        {
+            next_sample += SAMPLE_TIME;
+            force = static_cast<float>(0.4 + 0.3 * std::sin(now * 6.0));
+            sample_timestamp = now - 0.004;
+            samples++;
+        }
+
+        // Frame thread: pose fetch, estimation and pose update.
+        auto frame_start = std::chrono::steady_clock::now();
+
+        vr::TrackedDevicePose_t hmd_pose = {};
+        host->GetRawTrackedDevicePoses(0.0f, &hmd_pose, 1);
+
+        const vr::HmdMatrix34_t& matrix = hmd_pose.mDeviceToAbsoluteTracking;
+        TrackingState state;
+        state.hmd_valid = hmd_pose.bPoseIsValid && hmd_pose.eTrackingResult == vr::TrackingResult_Running_OK;
+        state.hmd_x = matrix.m[0][3];
+        state.hmd_y = matrix.m[1][3];
+        state.hmd_z = matrix.m[2][3];
+        state.hmd_velocity_x = hmd_pose.vVelocity.v[0];
+        state.hmd_velocity_z = hmd_pose.vVelocity.v[2];
+        state.hmd_yaw = DirectionMapper::GetYaw(matrix.m);
+        state.has_anchor = true;
+        state.rope_length = 1.6f;
+        state.stretch = 0.25f;
+
+        vr::DriverPose_t pose = estimator.Update(state, force, sample_timestamp);
+        hip_pose.Store(pose);
+        host->TrackedDevicePoseUpdated(0, pose, sizeof(pose));
+
+        frame_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count();
+        checksum += pose.vecPosition[0] + pose.vecVelocity[2];
+    }
+
+    size_t benchmark_allocations = allocations - allocations_before;
+    vr::DriverPose_t last_pose = hip_pose.Load();
+
+    std::printf("frames:            %d\n", FRAMES);
+    std::printf("samples:           %zu\n", samples);
+    std::printf("frame thread:      %.1f ns per frame\n", frame_seconds / FRAMES * 1.0e9);
+    std::printf("pose updates:      %zu\n", mock_host.GetPoseUpdateCount());
+    std::printf("allocations:       %zu\n", benchmark_allocations);
+    std::printf("last pose:         valid %d at %.3f %.3f %.3f, offset %.3f s\n", last_pose.poseIsValid,
+        last_pose.vecPosition[0], last_pose.vecPosition[1], last_pose.vecPosition[2], last_pose.poseTimeOffset);
+    std::printf("checksum:          %f\n", checksum);
+    return benchmark_allocations == 0 ? 0 : 1;
+}
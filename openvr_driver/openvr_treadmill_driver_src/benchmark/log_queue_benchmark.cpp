@@ -0,0 +1,115 @@
+/**
+ * Benchmark of the cost of DriverLog() on the calling thread. Enqueues rounds of messages
+ * from one and from four threads while the flusher runs, then stops the queue so that
+ * every round starts empty. Also measures the path of a message dropped on a full queue
+ * and counts the heap allocations made while enqueueing.
+ *
+ * Build without SteamVR, e.g.:
+ *      g++ -O2 -std=c++17 -pthread -Iinclude benchmark/log_queue_benchmark.cpp src/log_queue.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "log_queue.h"
+
+static std::atomic<size_t> written{ 0 };
+
+static void CountingSink(const char*)
+{
+    written++;
+}
+
+static bool Log(LogQueue& queue, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool queued = queue.Enqueue(format, args);
+    va_end(args);
+    return queued;
+}
+
+/**
+ * Enqueues the given number of plain or formatted messages and returns the elapsed
+ * nanoseconds.
+ */
+static double EnqueueMessages(LogQueue& queue, int count, bool formatted)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        if (formatted)
+            Log(queue, "Anchor calibration finished: anchor at %f, %f, rope length %f m", 0.1 * i, -1.5, 2.25);
+        else
+            Log(queue, "Failed to open serial port");
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    const int ROUNDS = 2000;
+    const int MESSAGES_PER_ROUND = 200;
+    const int PRODUCERS = 4;
+
+    LogQueue queue;
+    size_t enqueue_allocations = 0;
+
+    // One producer, with a plain message and one with three float arguments.
+    double single_ns[2] = { 0.0, 0.0 };
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (int formatted = 0; formatted < 2; formatted++)
+        {
+            queue.Start(CountingSink);
+            size_t allocations_before = allocations;
+            single_ns[formatted] += EnqueueMessages(queue, MESSAGES_PER_ROUND, formatted != 0);
+            enqueue_allocations += allocations - allocations_before;
+            queue.Stop();
+        }
+    }
+
+    // Four producers at once, each with its share of the round.
+    std::atomic<long long> multi_ns{ 0 };
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        queue.Start(CountingSink);
+        std::atomic<int> ready{ 0 };
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; p++)
+        {
+            producers.emplace_back([&] {
+                ready++;
+                while (ready < PRODUCERS)
+                    ;
+                multi_ns += static_cast<long long>(EnqueueMessages(queue, MESSAGES_PER_ROUND / PRODUCERS, false));
+            });
+        }
+        for (std::thread& producer : producers)
+            producer.join();
+        queue.Stop();
+    }
+
+    // A full queue, every further message is dropped.
+    queue.Start(CountingSink);
+    EnqueueMessages(queue, static_cast<int>(LogQueue::CAPACITY), false);
+    uint64_t dropped_before = queue.GetDroppedCount();
+    double dropped_ns = EnqueueMessages(queue, 100000, false);
+    uint64_t dropped = queue.GetDroppedCount() - dropped_before;
+    queue.Stop();
+
+    double total = static_cast<double>(ROUNDS) * MESSAGES_PER_ROUND;
+    printf("enqueue, 1 producer:   %.1f ns per plain message\n", single_ns[0] / total);
+    printf("enqueue, 1 producer:   %.1f ns per message with 3 floats\n", single_ns[1] / total);
+    printf("enqueue, %d producers: %.1f ns per plain message\n", PRODUCERS, static_cast<double>(multi_ns) / total);
+    printf("enqueue, queue full:   %.1f ns per message (%llu dropped)\n", dropped_ns / 100000.0, static_cast<unsigned long long>(dropped));
+    printf("allocations while enqueueing: %zu\n", enqueue_allocations);
+    printf("lines written: %zu\n", static_cast<size_t>(written));
+    return 0;
+}
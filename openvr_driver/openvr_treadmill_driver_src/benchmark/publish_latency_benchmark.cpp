@@ -0,0 +1,136 @@
+/**
+ * Compares the latency of the frame driven and the sample driven publish mode. The device
+ * provider runs against the mock driver host at a simulated 90 Hz, while the device
+ * simulator plays the load cell module at 10 Hz like the stock firmware. Reports the
+ * delivery latency from the publication of a sample by the capture thread to its input
+ * update, and the total latency from the first byte of its line.
+ *
+ * In the frame driven mode a sample waits for the next RunFrame(), up to one frame of
+ * 11 ms. The sample driven mode sends it right away on the publisher thread.
+ *
+ * The measured seconds per mode can be given as the first argument, the default is 20.
+ * Needs a POSIX pseudo terminal. Built by the CMake project as publish_latency_benchmark.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "device_provider.h"
+#include "device_settings.h"
+#include "mock_driver_host.h"
+
+#ifndef _WIN32
+#include "device_simulator.h"
+#endif
+
+static const double REFRESH_RATE = 90.0;
+static const double SAMPLE_RATE = 10.0;
+
+#ifndef _WIN32
+
+/**
+ * The percentiles of a latency stage in microseconds.
+ */
+struct StageLatency
+{
+    unsigned long long count = 0;
+    unsigned long long p50 = 0;
+    unsigned long long p99 = 0;
+    unsigned long long max = 0;
+};
+
+/**
+ * Reads a stage out of the response to the "latency" debug request.
+ */
+static StageLatency ParseStage(const char* response, const char* stage)
+{
+    StageLatency latency;
+    std::string key = std::string("\"") + stage + "\":{";
+    const char* position = std::strstr(response, key.c_str());
+    if (position != nullptr)
+    {
+        unsigned long long p999 = 0;
+        sscanf(position + key.size(), "\"count\":%llu,\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu",
+            &latency.count, &latency.p50, &latency.p99, &p999, &latency.max);
+    }
+    return latency;
+}
+
+/**
+ * Runs the driver in the given publish mode for the given seconds and prints its latency.
+ */
+static bool MeasureLatency(const std::string& port, const char* publish_mode, double seconds)
+{
+    MockDriverHost host;
+    if (!host.LoadSettings(TREADMILL_DEFAULT_SETTINGS))
+    {
+        printf("cannot read %s\n", TREADMILL_DEFAULT_SETTINGS);
+        return false;
+    }
+    host.SetStringSetting(treadmill_main_settings_section, "port_match", port);
+    host.SetStringSetting(treadmill_main_settings_section, "publish_mode", publish_mode);
+    host.SetBoolSetting(treadmill_main_settings_section, "shared_metrics", false);
+    host.SetRecording(false);
+
+    MyDeviceProvider provider;
+    if (provider.Init(&host) != vr::VRInitError_None || host.GetDeviceCount() != 1)
+    {
+        printf("the driver did not initialize\n");
+        return false;
+    }
+    vr::ITrackedDeviceServerDriver* device = host.GetDevice(1);
+
+    // The capture connects after its first reconnect, which takes about two seconds.
+    char response[4096];
+    for (int i = 0; i < 10; i++)
+    {
+        host.RunFrames(provider, REFRESH_RATE, static_cast<size_t>(REFRESH_RATE / 2));
+        device->DebugRequest("stats", response, sizeof(response));
+        if (std::strstr(response, "\"connected\":true") != nullptr && std::strstr(response, "\"samples\":0,") == nullptr)
+            break;
+    }
+
+    device->DebugRequest("reset", response, sizeof(response));
+    host.RunFrames(provider, REFRESH_RATE, static_cast<size_t>(REFRESH_RATE * seconds));
+    device->DebugRequest("latency", response, sizeof(response));
+    provider.Cleanup();
+
+    StageLatency delivery = ParseStage(response, "delivery");
+    StageLatency total = ParseStage(response, "total");
+    printf("%-6s %8llu %8llu %8llu %8llu   %8llu %8llu %8llu\n", publish_mode, delivery.count,
+        delivery.p50, delivery.p99, delivery.max, total.p50, total.p99, total.max);
+    return delivery.count > 0;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 20.0;
+
+    SimulatorSettings settings;
+    settings.rate = SAMPLE_RATE;
+    DeviceSimulator simulator(settings, ModuleModel::MakeGaitProfile(GaitProfile::WALK, SAMPLE_RATE, settings.seed));
+    if (!simulator.Start())
+    {
+        printf("cannot create a pseudo terminal\n");
+        return 1;
+    }
+
+    printf("%.0f Hz frames, %.0f Hz samples, %.0f s per mode, latency in us\n", REFRESH_RATE, SAMPLE_RATE, seconds);
+    printf("%-6s %8s %8s %8s %8s   %8s %8s %8s\n", "mode", "samples", "p50", "p99", "max", "total50", "total99", "totalmax");
+    bool success = MeasureLatency(simulator.GetPort(), "frame", seconds) &&
+                   MeasureLatency(simulator.GetPort(), "sample", seconds);
+    simulator.Stop();
+    return success ? 0 : 1;
+}
+
+#else
+
+int main()
+{
+    printf("the publish latency benchmark needs a POSIX pseudo terminal\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * Replays long sessions through the capture on simulated time. The load cell module runs
+ * inside the process on the same clock as the capture, with jitter, lost and corrupted
+ * lines, stalls, a hang up every 5 minutes and a minute of standby every 10 minutes, so
+ * that hours of walking, reconnects and rate changes pass in a fraction of a second.
+ *
+ * Every session is replayed twice and all published samples are hashed. The hashes must
+ * match bit for bit, which makes the printed hash a regression fingerprint of the
+ * complete capture path: a change of the parser, the pipeline or the reconnect logic
+ * shows up as a different hash.
+ *
+ *     replay_benchmark [hours] [recording.csv]
+ *
+ * The default is 1 hour of the mixed gait profile. Built by the CMake project as
+ * replay_benchmark.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mock_driver_host.h"
+#include "simulated_serial_transport.h"
+#include "treadmill_capture.h"
+
+static const double SAMPLE_RATE = 10.0;
+static const double STANDBY_INTERVAL = 600.0;
+static const double STANDBY_DURATION = 60.0;
+
+/**
+ * FNV-1a over the bytes of a value.
+ */
+template <typename T>
+static void Hash(uint64_t& hash, const T& value)
+{
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (unsigned char byte : bytes)
+    {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    }
+}
+
+struct ReplayResult
+{
+    uint64_t hash = 14695981039346656037ULL;
+    uint64_t samples = 0;
+    uint64_t errors = 0;
+    uint64_t reconnects = 0;
+    SimulatorStatistics module;
+    double wall_seconds = 0.0;
+};
+
+/**
+ * Replays the values for the given simulated seconds and hashes every sample published
+ * until then.
+ */
+static ReplayResult Replay(const std::vector<float>& values, double seconds)
+{
+    SimulatorSettings settings;
+    settings.rate = SAMPLE_RATE;
+    settings.jitter = 0.002;
+    settings.drop_probability = 0.005;
+    settings.corrupt_probability = 0.005;
+    settings.stall_probability = 0.001;
+    settings.stall_duration = 0.3;
+    settings.disconnect_interval = 300.0;
+    settings.disconnect_duration = 5.0;
+
+    SimulatedClock clock;
+    std::unique_ptr<SimulatedSerialTransport> transport(new SimulatedSerialTransport(clock, settings, values));
+    SimulatedSerialTransport& module = *transport;
+    TreadmillCapture capture(std::move(transport), clock);
+    capture.Configure(SignalPipelineSettings(), SimulatedSerialTransport::PORT_NAME);
+
+    // The standby is switched on the capture thread, so that it happens at the same
+    // simulated time on every run.
+    ReplayResult result;
+    capture.SetSampleListener([&](const TreadmillSample& sample) {
+        if (sample.timestamp > seconds)
+            return;
+        capture.SetStandby(std::fmod(sample.timestamp, STANDBY_INTERVAL) >= STANDBY_INTERVAL - STANDBY_DURATION);
+
+        Hash(result.hash, sample.value);
+        Hash(result.hash, sample.sequence);
+        Hash(result.hash, sample.timestamp);
+        Hash(result.hash, sample.first_byte_time);
+        Hash(result.hash, sample.publish_time);
+        Hash(result.hash, sample.gait.phase);
+        Hash(result.hash, sample.gait.cadence);
+        Hash(result.hash, sample.gait.cadence_speed);
+        Hash(result.hash, sample.gait.trend);
+        Hash(result.hash, sample.gait.step_count);
+        result.samples++;
+        if (sample.first_byte_time <= 0.0)
+            result.errors++;
+    });
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    capture.StartBackgroundCapture();
+    while (clock.Now() <= seconds)
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    capture.StopBackgroundCapture();
+    result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.reconnects = capture.GetStatistics().reconnects.load();
+    result.module = module.GetStatistics();
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    double hours = argc > 1 ? std::atof(argv[1]) : 1.0;
+    std::vector<float> values;
+    if (argc > 2 && !ModuleModel::LoadRecording(argv[2], values))
+    {
+        printf("cannot read values from %s\n", argv[2]);
+        return 1;
+    }
+    if (values.empty())
+        values = ModuleModel::MakeGaitProfile(GaitProfile::MIXED, SAMPLE_RATE, 1);
+    if (hours <= 0.0)
+    {
+        printf("usage: replay_benchmark [hours] [recording.csv]\n");
+        return 1;
+    }
+
+    // The capture logs its connection changes through the driver context.
+    MockDriverHost host;
+    host.SetRecording(false);
+    vr::InitServerDriverContext(&host);
+
+    double seconds = hours * 3600.0;
+    ReplayResult first = Replay(values, seconds);
+    ReplayResult second = Replay(values, seconds);
+
+    printf("%.2f simulated hours in %.3f s and %.3f s, %.0f times real time\n", hours, first.wall_seconds,
+        second.wall_seconds, seconds / first.wall_seconds);
+    printf("  module:  lines %llu, dropped %llu, corrupted %llu, stalls %llu, disconnects %llu, commands %llu\n",
+        static_cast<unsigned long long>(first.module.lines), static_cast<unsigned long long>(first.module.dropped),
+        static_cast<unsigned long long>(first.module.corrupted), static_cast<unsigned long long>(first.module.stalls),
+        static_cast<unsigned long long>(first.module.disconnects), static_cast<unsigned long long>(first.module.commands));
+    printf("  capture: samples %llu, read errors %llu, reconnects %llu\n",
+        static_cast<unsigned long long>(first.samples), static_cast<unsigned long long>(first.errors),
+        static_cast<unsigned long long>(first.reconnects));
+    printf("  sample hash %016llx\n", static_cast<unsigned long long>(first.hash));
+
+    if (first.hash != second.hash || first.samples != second.samples)
+    {
+        printf("the replays differ: %llu samples with hash %016llx\n", static_cast<unsigned long long>(second.samples),
+            static_cast<unsigned long long>(second.hash));
+        return 1;
+    }
+    printf("both replays published the same samples\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * Benchmark of the response curves. Compares the lookup tables, per value and per
+ * block, against evaluating the curve functions directly, and reports the largest
+ * difference between both.
+ *
+ * Build without CMake, e.g.:
+ *      g++ -O2 -std=c++17 -Iinclude benchmark/response_curve_benchmark.cpp src/response_curve.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "response_curve.h"
+
+static const size_t VALUES = 1 << 16;
+static const int ROUNDS = 200;
+
+/**
+ * Returns the nanoseconds per value of the given evaluation of all values.
+ */
+template <typename Function>
+static double Measure(Function function, std::vector<float>& results)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+        function(results);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (static_cast<double>(VALUES) * ROUNDS) * 1.0e9;
+}
+
+int main()
+{
+    // Pull forces as the capture delivers them, a little outside [0, 1] at times.
+    std::vector<float> values(VALUES);
+    for (size_t i = 0; i < VALUES; i++)
+        values[i] = 0.5f + 0.55f * std::sin(i * 0.01f);
+
+    struct Curve
+    {
+        const char* name;
+        ResponseCurve curve;
+        float (*function)(float);
+    };
+    const Curve curves[] = {
+        { "gamma_soft", ResponseCurve(ResponseCurveType::GAMMA_SOFT), [](float x) { return std::pow(x, 0.6f); } },
+        { "gamma_hard", ResponseCurve(ResponseCurveType::GAMMA_HARD), [](float x) { return x * x; } },
+        { "s_curve", ResponseCurve(ResponseCurveType::S_CURVE), [](float x) { return x * x * (3.0f - 2.0f * x); } },
+        { "gamma 1.7", ResponseCurve(ResponseCurveType::GAMMA, 1.7f), [](float x) { return std::pow(x, 1.7f); } },
+    };
+
+    std::vector<float> direct(VALUES);
+    std::vector<float> table(VALUES);
+    std::vector<float> block(VALUES);
+    float checksum = 0.0f;
+
+    std::printf("%-12s %10s %10s %10s %12s\n", "curve", "direct", "table", "block", "max error");
+    for (const Curve& curve : curves)
+    {
+        double direct_time = Measure([&](std::vector<float>& results) {
+            for (size_t i = 0; i < VALUES; i++)
+                results[i] = curve.function(std::min(std::max(values[i], 0.0f), 1.0f));
+        }, direct);
+        double table_time = Measure([&](std::vector<float>& results) {
+            for (size_t i = 0; i < VALUES; i++)
+                results[i] = curve.curve.Evaluate(values[i]);
+        }, table);
+        double block_time = Measure([&](std::vector<float>& results) {
+            curve.curve.EvaluateBlock(values.data(), results.data(), VALUES);
+        }, block);
+
+        float max_error = 0.0f;
+        for (size_t i = 0; i < VALUES; i++)
+        {
+            max_error = std::max(max_error, std::fabs(table[i] - direct[i]));
+            checksum += table[i] + block[i];
+        }
+        std::printf("%-12s %8.2f ns %8.2f ns %8.2f ns %12.2e\n", curve.name, direct_time, table_time, block_time, max_error);
+    }
+    std::printf("checksum: %f\n", checksum);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * Benchmark of the spike filter for every supported window size and of the whole
+ * signal pipeline, on a synthetic walking signal with occasional spikes. The cost per
+ * sample has to stay far below the 100 ms between two samples of the module.
+ *
+ * Build without CMake, e.g.:
+ *      g++ -O2 -std=c++17 -Iinclude benchmark/spike_filter_benchmark.cpp src/spike_filter.cpp
+ *          src/signal_pipeline.cpp src/gait_detector.cpp src/noise_floor.cpp src/auto_calibration.cpp
+ *          src/quantile_estimator.cpp
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "signal_pipeline.h"
+#include "spike_filter.h"
+
+static const size_t SAMPLES = 1 << 16;
+static const int ROUNDS = 100;
+
+int main()
+{
+    std::vector<float> values(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        values[i] = 0.3f + 0.25f * std::sin(i * 0.08f);
+        if (i % 97 == 0)
+            values[i] += 0.5f;
+    }
+
+    float checksum = 0.0f;
+    for (size_t window = 3; window <= SpikeFilter::MAX_WINDOW; window += 2)
+    {
+        SpikeFilterSettings settings;
+        settings.window = window;
+        SpikeFilter filter(settings);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            for (float value : values)
+                checksum += filter.Process(value);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("spike filter, window %2zu: %6.1f ns per sample, %zu spikes removed\n", window,
+            elapsed / (static_cast<double>(SAMPLES) * ROUNDS) * 1.0e9, filter.GetRemovedSpikes());
+    }
+
+    SignalPipeline pipeline;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (size_t i = 0; i < SAMPLES; i++)
+            checksum += pipeline.Process(values[i], (round * SAMPLES + i) * 0.1).value;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("signal pipeline:         %6.1f ns per sample\n", elapsed / (static_cast<double>(SAMPLES) * ROUNDS) * 1.0e9);
+    std::printf("checksum: %f\n", checksum);
+    return 0;
+}
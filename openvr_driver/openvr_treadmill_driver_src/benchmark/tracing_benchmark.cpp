@@ -0,0 +1,103 @@
+/**
+ * Benchmark of the cost of the trace points. Runs a small amount of per sample work
+ * without trace points, with a begin and end event while tracing is off, and while it
+ * is on. Then records from two threads while the trace is written, as the driver does
+ * when "trace write" arrives during a session. Also counts the heap allocations of a
+ * recording thread after its first event.
+ *
+ * Build without SteamVR, e.g.:
+ *      g++ -O2 -std=c++17 -pthread -Iinclude benchmark/tracing_benchmark.cpp src/tracing.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "allocation_counter.h"
+#include "tracing.h"
+
+static const int ITERATIONS = 50000000;
+
+/**
+ * Stands in for the work between two trace points, e.g. a pipeline stage.
+ */
+static inline float Work(float value, int i)
+{
+    return value * 0.999f + static_cast<float>(i & 7) * 0.001f;
+}
+
+/**
+ * Runs the work with or without trace points and returns the nanoseconds per iteration.
+ */
+template <bool TRACED>
+static double Run(float& result)
+{
+    float value = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        if (TRACED)
+            TraceEvent(TraceEventId::PIPELINE, TracePhase::BEGIN);
+        value = Work(value, i);
+        if (TRACED)
+            TraceEvent(TraceEventId::PIPELINE, TracePhase::END);
+    }
+    result += value;
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+}
+
+int main()
+{
+    float result = 0.0f;
+    Tracer::SetThreadName("benchmark");
+
+    // Warm up, so that the first measurement does not pay for page faults.
+    Run<false>(result);
+
+    double baseline = Run<false>(result);
+    double disabled = Run<true>(result);
+    Tracer::Start();
+    TraceEvent(TraceEventId::PIPELINE, TracePhase::INSTANT);
+    size_t allocations_before = allocations;
+    double enabled = Run<true>(result);
+    size_t recording_allocations = allocations - allocations_before;
+    Tracer::Stop();
+
+    printf("no trace points:      %.2f ns per iteration\n", baseline);
+    printf("tracing off:          %.2f ns per iteration (+%.2f ns for 2 events)\n", disabled, disabled - baseline);
+    printf("tracing on:           %.2f ns per iteration (+%.2f ns for 2 events)\n", enabled, enabled - baseline);
+    printf("allocations while recording: %zu\n", recording_allocations);
+
+    // Two recording threads while the trace is written repeatedly.
+    Tracer::Start();
+    std::atomic<bool> running{ true };
+    auto record = [&](const char* name, TraceEventId id) {
+        Tracer::SetThreadName(name);
+        uint32_t sequence = 0;
+        while (running)
+        {
+            TraceEvent(id, TracePhase::BEGIN);
+            TraceEvent(id, TracePhase::END, ++sequence);
+        }
+    };
+    std::thread capture(record, "capture", TraceEventId::SERIAL_READ);
+    std::thread frame(record, "vrserver frame", TraceEventId::RUN_FRAME);
+
+    int writes = 0;
+    for (; writes < 20; writes++)
+    {
+        if (!Tracer::WriteChromeTrace("tracing_benchmark.json"))
+        {
+            printf("cannot write the trace\n");
+            break;
+        }
+    }
+    running = false;
+    capture.join();
+    frame.join();
+    Tracer::Stop();
+
+    printf("trace written %d times while recording, see tracing_benchmark.json\n", writes);
+    return result > 0.0f ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/**
+ * Fuzz target of the binary frame codec. Every frame decodes to NaN or a finite value,
+ * and a frame that decodes to a value is exactly the frame of that value. The input is
+ * also read as floats, which must survive encoding and decoding bit for bit.
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include "frame_codec.h"
+#include "fuzz_target.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    for (size_t offset = 0; offset + FrameCodec::FRAME_SIZE <= size; offset++)
+    {
+        float value = FrameCodec::Decode(data + offset);
+        FUZZ_CHECK(std::isnan(value) || std::isfinite(value));
+        if (std::isnan(value))
+            continue;
+
+        uint8_t frame[FrameCodec::FRAME_SIZE];
+        FrameCodec::Encode(value, frame);
+        FUZZ_CHECK(std::memcmp(frame, data + offset, FrameCodec::FRAME_SIZE) == 0);
+    }
+
+    for (size_t offset = 0; offset + sizeof(float) <= size; offset += sizeof(float))
+    {
+        float value = 0.0f;
+        std::memcpy(&value, data + offset, sizeof(value));
+
+        uint8_t frame[FrameCodec::FRAME_SIZE];
+        FrameCodec::Encode(value, frame);
+        float decoded = FrameCodec::Decode(frame);
+        if (!std::isfinite(value))
+        {
+            FUZZ_CHECK(std::isnan(decoded));
+            continue;
+        }
+        FUZZ_CHECK(std::memcmp(&decoded, &value, sizeof(value)) == 0);
+
+        // A single flipped bit of the value or the checksum is always detected. Checked
+        // for the first value only, so that the throughput measures the codec.
+        if (offset > 0)
+            continue;
+        for (size_t bit = 8; bit < 8 * FrameCodec::FRAME_SIZE; bit++)
+        {
+            frame[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+            FUZZ_CHECK(std::isnan(FrameCodec::Decode(frame)));
+            frame[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+        }
+    }
+    return 0;
+}
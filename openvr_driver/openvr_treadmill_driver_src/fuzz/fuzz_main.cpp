@@ -0,0 +1,239 @@
+/**
+ * Runs a fuzz target without libFuzzer, e.g. with GCC or MSVC. Replays the inputs of the
+ * given files and folders, then optionally mutates them with a fixed seed and measures
+ * the throughput of the target:
+ *
+ *     line_parser_fuzzer --runs 100000 --benchmark 2 fuzz_corpus/line_parser
+ *
+ * The mutations are far less clever than the coverage guided ones of libFuzzer, but run
+ * the invariants of the target on inputs no recording contains.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fuzz_target.h"
+
+// Pieces of the serial stream that random bytes rarely hit.
+static const std::vector<std::string> tokens = {
+    "\r", "\n", "\r\n", "\xA5", "0.00", "1.00", "-", ".", "e38", "e-45", "nan", "inf", "0x1p3", "        ",
+};
+
+// The input of the running mutation, written to a file if the target aborts on it.
+static const std::vector<uint8_t>* current_input = nullptr;
+
+static void SaveCrashInput(int)
+{
+    if (current_input != nullptr)
+    {
+        FILE* file = fopen("crash-input", "wb");
+        if (file != nullptr)
+        {
+            fwrite(current_input->data(), 1, current_input->size(), file);
+            fclose(file);
+            fprintf(stderr, "the input is saved as crash-input\n");
+        }
+    }
+    std::signal(SIGABRT, SIG_DFL);
+    std::abort();
+}
+
+static void PrintUsage()
+{
+    printf(
+        "usage: <fuzzer> [options] files or folders...\n"
+        "  --runs N       mutated inputs to run after the replay (default 0)\n"
+        "  --seed N       seed of the mutations (default 1)\n"
+        "  --max-size N   largest mutated input in bytes (default 4096)\n"
+        "  --benchmark S  replays the inputs for the given seconds and reports the throughput\n");
+}
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>& content)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    content.clear();
+    uint8_t buffer[4096];
+    size_t count = 0;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        content.insert(content.end(), buffer, buffer + count);
+    fclose(file);
+    return true;
+}
+
+/**
+ * Adds the file, or all files of the folder, to the inputs.
+ */
+static bool AddInputs(const std::string& path, std::vector<std::vector<uint8_t>>& inputs)
+{
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error))
+    {
+        inputs.emplace_back();
+        return ReadFile(path, inputs.back());
+    }
+
+    // Sorted, so that the mutations only depend on the seed.
+    std::vector<std::string> files;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, error))
+    {
+        if (entry.is_regular_file())
+            files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    for (const std::string& file : files)
+    {
+        inputs.emplace_back();
+        if (!ReadFile(file, inputs.back()))
+            inputs.pop_back();
+    }
+    return !error;
+}
+
+/**
+ * Applies one to eight random edits to the input.
+ */
+static void Mutate(std::vector<uint8_t>& input, std::mt19937& random, size_t max_size)
+{
+    int edits = 1 + static_cast<int>(random() % 8);
+    for (int i = 0; i < edits; i++)
+    {
+        size_t position = input.empty() ? 0 : random() % (input.size() + 1);
+        switch (random() % 6)
+        {
+        case 0:
+            if (!input.empty())
+                input[position % input.size()] ^= static_cast<uint8_t>(1 << (random() % 8));
+            break;
+        case 1:
+            input.insert(input.begin() + position, static_cast<uint8_t>(random()));
+            break;
+        case 2:
+            if (!input.empty())
+                input.erase(input.begin() + position % input.size());
+            break;
+        case 3:
+        {
+            const std::string& token = tokens[random() % tokens.size()];
+            input.insert(input.begin() + position, token.begin(), token.end());
+            break;
+        }
+        case 4:
+        {
+            // A run of one byte, longer than any buffer of a decoder.
+            size_t length = 1 + random() % 512;
+            input.insert(input.begin() + position, length, static_cast<uint8_t>(random()));
+            break;
+        }
+        default:
+        {
+            // Repeats a piece of the input, e.g. a line, to grow long lines and streams.
+            if (input.empty())
+                break;
+            size_t start = random() % input.size();
+            size_t length = 1 + random() % std::min<size_t>(64, input.size() - start);
+            std::vector<uint8_t> piece(input.begin() + start, input.begin() + start + length);
+            input.insert(input.begin() + position, piece.begin(), piece.end());
+            break;
+        }
+        }
+    }
+    if (input.size() > max_size)
+        input.resize(max_size);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t runs = 0;
+    uint32_t seed = 1;
+    size_t max_size = 4096;
+    double benchmark_seconds = 0.0;
+    std::vector<std::vector<uint8_t>> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        if (option.rfind("--", 0) == 0 && i + 1 == argc)
+        {
+            PrintUsage();
+            return 1;
+        }
+
+        if (option == "--runs")
+            runs = std::strtoull(argv[++i], nullptr, 10);
+        else if (option == "--seed")
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (option == "--max-size")
+            max_size = std::strtoul(argv[++i], nullptr, 10);
+        else if (option == "--benchmark")
+            benchmark_seconds = std::atof(argv[++i]);
+        else if (option.rfind("--", 0) == 0)
+        {
+            PrintUsage();
+            return 1;
+        }
+        else if (!AddInputs(option, inputs))
+        {
+            printf("cannot read %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    size_t replayed_bytes = 0;
+    for (const std::vector<uint8_t>& input : inputs)
+    {
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        replayed_bytes += input.size();
+    }
+    printf("replayed %zu inputs with %zu bytes\n", inputs.size(), replayed_bytes);
+
+    if (runs > 0)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> input;
+        current_input = &input;
+        std::signal(SIGABRT, SaveCrashInput);
+        for (uint64_t run = 0; run < runs; run++)
+        {
+            if (inputs.empty())
+                input.clear();
+            else
+                input = inputs[random() % inputs.size()];
+            Mutate(input, random, max_size);
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+        current_input = nullptr;
+        printf("ran %llu mutated inputs\n", static_cast<unsigned long long>(runs));
+    }
+
+    if (benchmark_seconds > 0.0 && replayed_bytes > 0)
+    {
+        // Whole passes over the inputs, so that every input weighs the same.
+        uint64_t passes = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while (elapsed < benchmark_seconds)
+        {
+            for (const std::vector<uint8_t>& input : inputs)
+                LLVMFuzzerTestOneInput(input.data(), input.size());
+            passes++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        printf("throughput %.1f MB/s, %.0f inputs/s\n", passes * replayed_bytes / elapsed / 1e6,
+            passes * inputs.size() / elapsed);
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * The entry point of a fuzz target, called by libFuzzer or by fuzz_main.cpp with one
+ * input at a time.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+/**
+ * Aborts on a broken invariant, which libFuzzer reports as a crash with the input.
+ */
+#define FUZZ_CHECK(condition)                                                       \
+    do                                                                              \
+    {                                                                               \
+        if (!(condition))                                                           \
+        {                                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            abort();                                                                \
+        }                                                                           \
+    } while (0)
@@ -0,0 +1,107 @@
+/**
+ * Fuzz target of the line parser, which decodes both the text lines and the binary
+ * frames of the load cell module in the capture. Feeds the input in chunks like the
+ * reads of the capture and checks every line the parser ends. Afterwards the parser must
+ * find back to the stream: a few line ends followed by a text line and by a frame have
+ * to come out exactly, whatever garbage came before.
+ *
+ * The first byte of the input picks the chunk size.
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include "frame_codec.h"
+#include "fuzz_target.h"
+#include "line_parser.h"
+
+/**
+ * Returns true if both are NaN or they have the same value.
+ */
+static bool IsSameValue(float a, float b)
+{
+    return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+static void CheckLine(const LineParser& parser)
+{
+    FUZZ_CHECK(parser.GetEndTime() >= parser.GetFirstByteTime());
+
+    float value = parser.GetValue();
+    FUZZ_CHECK(std::isnan(value) || std::isfinite(value));
+
+    if (parser.IsBinary())
+    {
+        FUZZ_CHECK(parser.GetLength() == FrameCodec::FRAME_SIZE);
+        FUZZ_CHECK(parser.GetLine()[0] == '\0');
+        FUZZ_CHECK(!parser.IsOverflow());
+        return;
+    }
+
+    FUZZ_CHECK(parser.GetLength() <= LineParser::MAX_LINE_LENGTH);
+    FUZZ_CHECK(std::strlen(parser.GetLine()) <= parser.GetLength());
+    FUZZ_CHECK(std::memchr(parser.GetLine(), '\r', parser.GetLength()) == nullptr);
+    FUZZ_CHECK(std::memchr(parser.GetLine(), '\n', parser.GetLength()) == nullptr);
+    if (parser.IsOverflow())
+    {
+        FUZZ_CHECK(parser.GetLength() == 0);
+        FUZZ_CHECK(std::isnan(value));
+    }
+    else
+    {
+        FUZZ_CHECK(IsSameValue(value, LineParser::ParseValue(parser.GetLine())));
+    }
+}
+
+/**
+ * Feeds the bytes and returns how many lines ended, checking each of them.
+ */
+static size_t Feed(LineParser& parser, const uint8_t* data, size_t size, double time)
+{
+    size_t lines = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (parser.Push(static_cast<char>(data[i]), time))
+        {
+            CheckLine(parser);
+            lines++;
+        }
+    }
+    return lines;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    // The capture reads up to 64 bytes at a time, all bytes of a read share its time.
+    size_t chunk_size = 1 + data[0] % 64;
+    data++;
+    size--;
+
+    LineParser parser;
+    double time = 0.0;
+    for (size_t offset = 0; offset < size; offset += chunk_size)
+    {
+        size_t length = size - offset < chunk_size ? size - offset : chunk_size;
+        Feed(parser, data + offset, length, time);
+        time += 0.001;
+    }
+
+    // Enough line ends to complete a pending frame and to end a pending line.
+    uint8_t line_ends[FrameCodec::FRAME_SIZE];
+    std::memset(line_ends, '\r', sizeof(line_ends));
+    Feed(parser, line_ends, sizeof(line_ends), time);
+
+    const char* line = "0.50\r\n";
+    FUZZ_CHECK(Feed(parser, reinterpret_cast<const uint8_t*>(line), std::strlen(line) - 1, time) == 1);
+    FUZZ_CHECK(!parser.IsBinary() && parser.GetValue() == 0.5f);
+    Feed(parser, reinterpret_cast<const uint8_t*>(line) + std::strlen(line) - 1, 1, time);
+
+    uint8_t frame[FrameCodec::FRAME_SIZE];
+    FrameCodec::Encode(0.25f, frame);
+    FUZZ_CHECK(Feed(parser, frame, sizeof(frame), time) == 1);
+    FUZZ_CHECK(parser.IsBinary() && parser.GetValue() == 0.25f);
+    return 0;
+}
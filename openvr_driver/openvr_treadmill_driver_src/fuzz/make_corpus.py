@@ -0,0 +1,75 @@
+"""
+Writes the seed corpus of the fuzz targets from the recordings in
+load_cell_module/validation: the values as the text lines and the binary
+frames the load cell module sends, and a mix of both.
+
+    python make_corpus.py <output folder> <csv files...>
+"""
+
+import os
+import struct
+import sys
+
+VALUES_PER_INPUT = 64
+SYNC_BYTE = 0xA5
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(value):
+    payload = struct.pack("<f", value)
+    return bytes([SYNC_BYTE]) + payload + bytes([crc8(payload)])
+
+
+def read_values(filename):
+    values = []
+    with open(filename) as file:
+        for line in file:
+            text = line.strip()
+            try:
+                float(text)
+            except ValueError:
+                continue
+            values.append(text)
+    return values
+
+
+def write(folder, name, content):
+    with open(os.path.join(folder, name), "wb") as file:
+        file.write(content)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print(__doc__)
+        sys.exit(1)
+
+    output = sys.argv[1]
+    line_parser_folder = os.path.join(output, "line_parser")
+    frame_codec_folder = os.path.join(output, "frame_codec")
+    os.makedirs(line_parser_folder, exist_ok=True)
+    os.makedirs(frame_codec_folder, exist_ok=True)
+
+    for filename in sys.argv[2:]:
+        name = os.path.splitext(os.path.basename(filename))[0]
+        values = read_values(filename)
+        for index, start in enumerate(range(0, len(values), VALUES_PER_INPUT)):
+            chunk = values[start:start + VALUES_PER_INPUT]
+            text = b"".join(value.encode("ascii") + b"\r\n" for value in chunk)
+            frames = b"".join(encode_frame(float(value)) for value in chunk)
+            mixed = b"".join(encode_frame(float(value)) if i % 2 else value.encode("ascii") + b"\r\n"
+                             for i, value in enumerate(chunk))
+
+            # The first byte of a line parser input picks the size of the reads.
+            chunk_size = bytes([index % 64])
+            write(line_parser_folder, "%s_%03d_text" % (name, index), chunk_size + text)
+            write(line_parser_folder, "%s_%03d_binary" % (name, index), chunk_size + frames)
+            write(line_parser_folder, "%s_%03d_mixed" % (name, index), chunk_size + mixed)
+            write(frame_codec_folder, "%s_%03d" % (name, index), frames)
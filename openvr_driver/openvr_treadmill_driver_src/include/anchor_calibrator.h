@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * The estimated rope geometry in the horizontal plane of the tracking space, in meters.
+ */
+struct AnchorEstimate
+{
+    float anchor_x = 0.0f;
+    float anchor_z = 0.0f;
+
+    // Distance between anchor and headset at zero pull force.
+    float rope_length = 0.0f;
+    // Additional distance per unit of normalized pull force.
+    float stretch = 0.0f;
+
+    // RMS distance error of the fit and the number of samples it is based on.
+    float residual = 0.0f;
+    size_t samples = 0;
+};
+
+/**
+ * Tuning parameters of the anchor calibration.
+ */
+struct AnchorCalibrationSettings
+{
+    // Only samples with at least this normalized force have a taut rope.
+    float min_force = 0.15f;
+
+    // The fit is only accepted after this many samples, which is 30 seconds of
+    // pulling at the 10 Hz sample rate of the load cell module.
+    size_t min_samples = 300;
+
+    // Upper bound of the RMS distance error of an accepted fit, in meters.
+    float max_residual = 0.05f;
+
+    // Upper bound of the standard error of the anchor position, in meters. Samples
+    // on a short arc do not pin down the radius of the circle.
+    float max_anchor_error = 0.05f;
+
+    // Plausible range of the rope length, in meters.
+    float min_rope_length = 0.3f;
+    float max_rope_length = 10.0f;
+};
+
+/**
+ * Estimates where the rope is anchored from the headset positions while the rope
+ * is pulled. The distance of the headset from the anchor is modeled as the rope
+ * length plus a stretch proportional to the pull force, which makes the squared
+ * distance linear in the unknowns:
+ *
+ *      x^2 + z^2 = 2 ax x + 2 az z + (L^2 - ax^2 - az^2) + 2 L k f + k^2 f^2
+ *
+ * The normal equations of this least squares problem are accumulated sample by
+ * sample and solved on a low priority background thread, so that the frame thread
+ * only pushes the samples into a lock free queue. The algebraic solution is then
+ * refined on the actual distance errors, which the position noise does not bias.
+ */
+class AnchorCalibrator
+{
+public:
+    AnchorCalibrator() = default;
+    explicit AnchorCalibrator(const AnchorCalibrationSettings& settings);
+    ~AnchorCalibrator();
+
+    AnchorCalibrator(const AnchorCalibrator&) = delete;
+    AnchorCalibrator& operator=(const AnchorCalibrator&) = delete;
+
+    /**
+     * Forgets all samples and starts the background thread.
+     */
+    void Start();
+
+    /**
+     * Stops and joins the background thread.
+     */
+    void Stop();
+
+    /**
+     * Returns true while the calibration collects samples.
+     */
+    bool IsRunning() const;
+
+    /**
+     * Queues a headset position with the pull force measured there. Called from the
+     * frame thread, never blocks. Samples below the minimum force are ignored and
+     * samples arriving while the queue is full are dropped.
+     */
+    void AddSample(float x, float z, float force);
+
+    /**
+     * Returns true exactly once after an estimate was accepted and writes it. The
+     * background thread ends with the accepted estimate.
+     */
+    bool TakeResult(AnchorEstimate& estimate);
+
+    /**
+     * Solves the accumulated normal equations and checks the plausibility of the
+     * result. Exposed so that the fit can be run without the background thread.
+     */
+    bool Solve(AnchorEstimate& estimate) const;
+
+    /**
+     * Adds a sample to the normal equations. Only called by the background thread or
+     * instead of it.
+     */
+    void Accumulate(float x, float z, float force);
+
+private:
+    static constexpr size_t PARAMETERS = 5;
+    static constexpr size_t QUEUE_SIZE = 1024;
+    static constexpr size_t MAX_STORED_SAMPLES = 4096;
+
+    struct Sample
+    {
+        float x;
+        float z;
+        float force;
+    };
+
+    AnchorCalibrationSettings settings_;
+
+    // Single producer single consumer queue between the frame and the background thread.
+    std::array<Sample, QUEUE_SIZE> queue_;
+    std::atomic<size_t> queue_head_{ 0 };
+    std::atomic<size_t> queue_tail_{ 0 };
+
+    // Only touched by the background thread.
+    double normal_matrix_[PARAMETERS][PARAMETERS] = {};
+    double normal_vector_[PARAMETERS] = {};
+    size_t sample_count_ = 0;
+    // Every stride-th accumulated sample is stored.
+    size_t stride_ = 1;
+    std::vector<Sample> samples_;
+
+    std::thread worker_;
+    std::atomic<bool> running_{ false };
+
+    std::mutex result_lock_;
+    AnchorEstimate result_;
+    std::atomic<bool> has_result_{ false };
+
+    /**
+     * Drains the queue and solves after every batch of new samples until an estimate
+     * is accepted or the calibration is stopped.
+     */
+    void WorkerLoop();
+
+    /**
+     * Forgets the accumulated samples.
+     */
+    void Reset();
+};
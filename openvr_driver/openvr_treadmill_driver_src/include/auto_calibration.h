@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+
+#include "quantile_estimator.h"
+
+/**
+ * The bounds the received values are normalized with. The defaults leave the
+ * values of the stock firmware, which already normalizes on the device, unchanged.
+ */
+struct CalibrationProfile
+{
+    float min_value = 0.0f;
+    float max_value = 1.0f;
+};
+
+/**
+ * Tuning parameters of the automatic calibration.
+ */
+struct AutoCalibrationSettings
+{
+    // The percentiles the bounds are derived from. Using robust percentiles instead
+    // of the extremes keeps single glitches out of the profile.
+    double lower_quantile = 0.02;
+    double upper_quantile = 0.98;
+
+    // A calibration session ends after this many samples of walking or running,
+    // which is 30 seconds at the 10 Hz of the load cell module.
+    size_t session_active_samples = 300;
+
+    // A suggestion needs at least this many idle and active samples.
+    size_t min_samples = 50;
+
+    // During a session, samples further than this fraction of the way from the idle
+    // level to the peak level of the session count as walking or running.
+    double session_active_fraction = 0.25;
+};
+
+/**
+ * Derives the normalization bounds from the received values with constant memory.
+ * The lower bound comes from all samples, so it settles on the idle load. The upper
+ * bound only sees samples while walking or running, because the idle samples would
+ * otherwise dominate it.
+ *
+ * Runs continuously to suggest bounds during normal play and can additionally run
+ * a dedicated calibration session whose result replaces the current profile. The
+ * idle classification comes from the gait detector, which runs on values normalized
+ * with the profile being calibrated. A wrong profile, e.g. raw counts of the module
+ * in the default range, saturates it, so a session instead classifies the values by
+ * their distance from its own idle and peak levels.
+ */
+class AutoCalibrator
+{
+public:
+    AutoCalibrator();
+    explicit AutoCalibrator(const AutoCalibrationSettings& settings);
+
+    /**
+     * Adds the next value before normalization together with the idle classification
+     * of the gait detector, which a running session ignores.
+     */
+    void Add(float value, bool idle);
+
+    /**
+     * Starts a new calibration session. A running session is restarted.
+     */
+    void StartSession();
+
+    /**
+     * Returns true while a calibration session collects samples.
+     */
+    bool IsSessionRunning() const;
+
+    /**
+     * Returns true exactly once after a session finished and writes its result
+     * into the given profile.
+     */
+    bool TakeSessionResult(CalibrationProfile& profile);
+
+    /**
+     * Writes the bounds suggested from all samples so far into the given profile.
+     * Returns false if not enough samples were seen yet.
+     */
+    bool GetSuggestion(CalibrationProfile& profile) const;
+
+private:
+    AutoCalibrationSettings settings_;
+
+    P2QuantileEstimator lower_;
+    P2QuantileEstimator upper_;
+
+    P2QuantileEstimator session_lower_;
+    P2QuantileEstimator session_upper_;
+    P2QuantileEstimator session_peak_;
+    bool session_running_ = false;
+    bool session_finished_ = false;
+
+    /**
+     * Returns true if the value of a session counts as walking or running.
+     */
+    bool IsSessionActive(float value) const;
+
+    /**
+     * Builds a profile from the given estimators. Returns false if there are too few
+     * samples or the bounds do not span a usable range.
+     */
+    bool MakeProfile(const P2QuantileEstimator& lower, const P2QuantileEstimator& upper,
+                     CalibrationProfile& profile) const;
+};
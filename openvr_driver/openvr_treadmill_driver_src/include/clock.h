@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * The time base of the capture engine. All timestamps and waits of the capture thread go
+ * through it, so that the engine can run on simulated time, in which recorded sessions
+ * and reconnects replay as fast as the host can compute them and every run yields the
+ * same samples.
+ */
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * Returns the current time in seconds. Only differences between two times of the
+     * same clock are meaningful.
+     */
+    virtual double Now() = 0;
+
+    /**
+     * Blocks the calling thread for the given seconds.
+     */
+    virtual void SleepFor(double seconds) = 0;
+
+    /**
+     * Returns the steady clock of the system shared by all captures.
+     */
+    static Clock& GetSteadyClock();
+};
+
+/**
+ * The steady clock of the system, the time base of the driver. On Windows it is the
+ * QueryPerformanceCounter.
+ */
+class SteadyClock : public Clock
+{
+public:
+    double Now() override;
+
+    void SleepFor(double seconds) override;
+};
+
+/**
+ * A clock that only moves when it is told to. Waits return at once and move the time
+ * forward instead. The time is kept in whole nanoseconds, so that the same steps always
+ * yield the same times.
+ *
+ * Meant to be driven by a single thread, e.g. the capture thread together with a
+ * simulated transport. Now() may be called from any thread.
+ */
+class SimulatedClock : public Clock
+{
+public:
+    explicit SimulatedClock(double start_time = 0.0);
+
+    double Now() override;
+
+    /**
+     * Lets the given seconds pass at once.
+     */
+    void SleepFor(double seconds) override;
+
+    /**
+     * Moves the time forward to the given time. An earlier time leaves it unchanged.
+     */
+    void AdvanceTo(double time);
+
+private:
+    std::atomic<int64_t> nanoseconds_;
+};
@@ -3,13 +3,23 @@
 #include <array>
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
 
+#include "anchor_calibrator.h"
+#include "device_settings.h"
+#include "direction_mapper.h"
+#include "hip_pose_estimator.h"
 #include "openvr_driver.h"
+#include "response_curve.h"
+#include "shared_metrics.h"
+#include "statistics.h"
 #include "treadmill_capture.h"
 
 /**
- * A collection of input identifiers for the input handle array.
+ * A collection of input identifiers for the input handle array. The components following
+ * the direction axes only change with a new sample, the booleans start at WALKING_CLICK.
  */
 enum TreadmillComponents
 {
@@ -18,6 +28,10 @@ enum TreadmillComponents
 	JOYSTICK_Y,
 	TRACKPAD_X,
 	JOYSTICK_X,
+	SPEED_VALUE,
+	ACCEL_VALUE,
+	WALKING_CLICK,
+	RUNNING_CLICK,
 	MAX
 };
 
@@ -29,9 +43,10 @@ class TreadmillDeviceDriver : public vr::ITrackedDeviceServerDriver
 {
 public:
 	/**
-	 * Constructor. Sets the role and serial number of the driver.
+	 * Constructor. Reads the role, serial number, capture source and signal processing
+	 * settings of the device from the given settings.
 	 */
-	TreadmillDeviceDriver( vr::ETrackedControllerRole role );
+	explicit TreadmillDeviceDriver( const DeviceSettings &settings );
 
 	/**
 	 * Overridden. Called when the driver activates. Establishes the serial connection and starts
@@ -41,22 +56,32 @@ public:
 	vr::EVRInitError Activate( uint32_t unObjectId ) override;
 
 	/**
-	 * Unused.
+	 * Overridden. Switches the load cell module to its heartbeat rate and lets the
+	 * capture thread block until the standby is left.
 	 */
 	void EnterStandby() override;
 
+	/**
+	 * Called by the device provider when SteamVR leaves the standby. Restores full
+	 * rate streaming.
+	 */
+	void LeaveStandby();
+
 	/**
 	 * Unused.
 	 */
 	void *GetComponent( const char *pchComponentNameAndVersion ) override;
 
 	/**
-	 * Unused.
+	 * Answers the telemetry commands "stats", "latency", "latency dump",
+	 * "histogram <stage>", "trace start", "trace stop", "trace write", "reset" and
+	 * "config" with a compact JSON object fitted into the response buffer.
 	 */
 	void DebugRequest( const char *pchRequest, char *pchResponseBuffer, uint32_t unResponseBufferSize ) override;
 
 	/**
-	 * Unused.
+	 * Returns the last virtual hip pose, or an invalid pose if the hip pose is disabled or
+	 * the rope anchor is unknown.
 	 */
 	vr::DriverPose_t GetPose() override;
 
@@ -71,9 +96,15 @@ public:
 	const std::string &GetSerialNumber();
 
 	/**
-	 * Main worker method. Maps the read treadmill value to the OpenVR input.
+	 * Returns true if the device needs the HMD pose in RunTreadmillFrame().
 	 */
-	void RunTreadmillFrame();
+	bool UsesHmdPose() const;
+
+	/**
+	 * Main worker method. Maps the read treadmill value to the OpenVR input. The HMD pose
+	 * is fetched once per frame by the device provider and may be null if no device uses it.
+	 */
+	void RunTreadmillFrame( const vr::TrackedDevicePose_t *hmd_pose );
 
 	/**
 	 * Unused.
@@ -84,11 +115,120 @@ private:
 	std::atomic< vr::TrackedDeviceIndex_t > controller_index_;
 	vr::ETrackedControllerRole treadmill_role_;
 
+	DeviceSettings settings_;
+	std::string model_number_;
 	std::string serial_number_;
+	std::string input_profile_;
+	float input_scale_;
 
 	std::array< vr::VRInputComponentHandle_t, TreadmillComponents::MAX > input_handles_;
 
+	// Change tracking of the input components. A component is only sent to vrserver when
+	// its value changed or the keep-alive interval elapsed, instead of on every frame.
+	// In the sample driven mode the frame and the publisher thread both publish, so the
+	// state is guarded by publish_lock_.
+	std::mutex publish_lock_;
+	uint64_t last_sequence_;
+	std::array< float, TreadmillComponents::MAX > input_values_;
+	std::array< float, TreadmillComponents::MAX > published_values_;
+	std::array< std::chrono::steady_clock::time_point, TreadmillComponents::MAX > published_times_;
+	std::array< bool, TreadmillComponents::MAX > is_published_;
+	std::chrono::steady_clock::duration keepalive_interval_;
+	std::chrono::steady_clock::time_point next_keepalive_;
+
+	// In the sample driven mode, a dedicated publisher thread sends the inputs as soon as
+	// the capture thread published a new sample, instead of waiting for the next RunFrame.
+	bool sample_driven_publishing_;
+	std::atomic< bool > is_publishing_;
+	std::thread publisher_thread_;
+
 	std::atomic< bool > is_active_;
 
+	ResponseCurve response_curve_;
+
+	// Updated by the frame thread, applied by whichever thread publishes the inputs.
+	// DebugRequest reads the settings from the copy the frame thread stores whenever a
+	// calibration changed them.
+	DirectionMapper direction_mapper_;
+	Seqlock< DirectionSettings > direction_settings_;
+	std::atomic< float > relative_yaw_;
+	float force_;
+
+	// The force trend of the previous sample, the acceleration is its rate of change.
+	float last_trend_;
+	double last_sample_time_;
+
+	// Collects headset positions on the frame thread and fits the rope anchor in the background.
+	AnchorCalibrator anchor_calibrator_;
+	uint64_t anchor_sequence_;
+	float rope_length_;
+	float rope_stretch_;
+
+	// The optional virtual hip tracker, updated on every frame. GetPose() can be called
+	// from any thread.
+	bool publish_hip_pose_;
+	Seqlock< vr::DriverPose_t > hip_pose_;
+	HipPoseEstimator hip_pose_estimator_;
+	SignalPipelineSettings pipeline_settings_;
+
+	DriverStatistics statistics_;
+	// Steady clock ticks of the last "reset". DebugRequest can come in on any thread.
+	std::atomic< std::chrono::steady_clock::rep > statistics_reset_ticks_;
+	std::string latency_dump_file_;
+
+	// The live state for external monitoring tools, written with every new sample.
+	bool publish_shared_metrics_;
+	SharedMetrics shared_metrics_;
+
 	TreadmillCapture treadmill_device_;
+
+	/**
+	 * Maps the given sample onto the input components and sends all components whose value
+	 * changed or whose keep-alive interval elapsed.
+	 */
+	void PublishInputs( const TreadmillSample &sample );
+
+	/**
+	 * Writes the state after the given sample into the shared memory block.
+	 */
+	void PublishSharedMetrics( const TreadmillSample &sample, float axis_x, float axis_y, bool connected );
+
+	/**
+	 * The loop of the publisher thread in the sample driven mode.
+	 */
+	void PublisherLoop();
+
+	/**
+	 * Builds the JSON responses of the DebugRequest commands.
+	 */
+	std::string GetStatsJson();
+	std::string GetLatencyJson();
+	std::string GetLatencyHistogramJson( const std::string &stage );
+	std::string GetConfigJson();
+
+	/**
+	 * Returns the latency histogram of the given pipeline stage, or null for an unknown name.
+	 */
+	const LatencyHistogram *GetLatencyStage( const std::string &stage );
+
+	/**
+	 * Writes the percentiles and buckets of all latency stages into a CSV file. Returns
+	 * false if the file could not be written.
+	 */
+	bool WriteLatencyDump( const std::string &file );
+
+	/**
+	 * Loads the settings of the signal pipeline running on the capture thread.
+	 */
+	SignalPipelineSettings LoadPipelineSettings();
+
+	/**
+	 * Loads the settings of the direction mapping.
+	 */
+	DirectionSettings LoadDirectionSettings();
+
+	/**
+	 * Loads the response curve mapping the pull force onto the stick deflection from the settings.
+	 */
+	void LoadResponseCurve();
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "controller_device_driver.h"
 #include "openvr_driver.h"
@@ -12,7 +13,8 @@ class MyDeviceProvider : public vr::IServerTrackedDeviceProvider
 {
 public:
 	/**
-	 * Initializes the treadmill driver.
+	 * Initializes one treadmill driver per entry of the device list, or the single
+	 * default device if the list is empty.
 	 */
 	vr::EVRInitError Init( vr::IVRDriverContext *pDriverContext ) override;
 
@@ -22,7 +24,7 @@ public:
 	const char *const *GetInterfaceVersions() override;
 
 	/**
-	 * Main loop method. Calls the device driver RunFrame method.
+	 * Main loop method. Calls the RunFrame method of every device driver.
 	 */
 	void RunFrame() override;
 
@@ -32,20 +34,21 @@ public:
 	bool ShouldBlockStandbyMode() override;
 
 	/**
-	 * Unused.
+	 * Puts the treadmill into its low rate standby mode.
 	 */
 	void EnterStandby() override;
 
 	/**
-	 * Unused.
+	 * Restores full rate streaming of the treadmill.
 	 */
 	void LeaveStandby() override;
 
 	/**
-	 * Deactivates the device driver.
+	 * Deactivates the device drivers.
 	 */
 	void Cleanup() override;
 
 private:
-	std::unique_ptr<TreadmillDeviceDriver> treadmill_device_;
+	std::vector<std::unique_ptr<TreadmillDeviceDriver>> treadmill_devices_;
+	bool needs_hmd_pose_ = false;
 };
\ No newline at end of file
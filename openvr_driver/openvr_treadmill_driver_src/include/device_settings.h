@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+
+#include "openvr_driver.h"
+
+/**
+ * The main settings section of the driver. Holds the defaults of every device.
+ */
+static const char *const treadmill_main_settings_section = "driver_CustomTreadmill";
+
+/**
+ * Access to the SteamVR settings of a single treadmill device. A device configured
+ * in the device list has its own section "driver_CustomTreadmill_<id>". Keys missing
+ * there are read from the main section, so that a device section only has to list
+ * what differs. The single default device uses the main section directly.
+ */
+class DeviceSettings
+{
+public:
+	/**
+	 * Creates the settings of the default device living in the main section.
+	 */
+	DeviceSettings();
+
+	/**
+	 * Creates the settings of the device with the given id of the device list.
+	 */
+	explicit DeviceSettings( const std::string &device_id );
+
+	/**
+	 * Read a value from the device section, or from the main section if the device
+	 * section does not contain the key.
+	 */
+	bool GetBool( const char *key ) const;
+	int32_t GetInt32( const char *key ) const;
+	float GetFloat( const char *key ) const;
+	std::string GetString( const char *key ) const;
+
+	/**
+	 * Reads the path of a file the driver writes. Only an absolute path is returned, a
+	 * relative one would end up wherever vrserver was started, so it is logged and an
+	 * empty string is returned instead.
+	 */
+	std::string GetFilePath( const char *key ) const;
+
+	/**
+	 * Store a value in the section of the device, never in the main section.
+	 */
+	void SetBool( const char *key, bool value ) const;
+	void SetFloat( const char *key, float value ) const;
+
+	/**
+	 * Returns the id of the device, which is empty for the default device.
+	 */
+	const std::string &GetDeviceId() const;
+
+	/**
+	 * Returns the settings section of the device.
+	 */
+	const std::string &GetSection() const;
+
+private:
+	std::string device_id_;
+	std::string section_;
+};
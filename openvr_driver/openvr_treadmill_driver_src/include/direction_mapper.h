@@ -0,0 +1,133 @@
+#pragma once
+
+#include <string>
+
+/**
+ * How the pull force is distributed onto the two stick axes.
+ */
+enum class DirectionMode
+{
+    // Everything goes onto the forward axis, the X axes stay at 0.
+    FORWARD,
+    // The yaw of the HMD relative to the tether forward direction steers the X axes.
+    HMD_YAW,
+    // Like HMD_YAW, but the tether forward direction points from the calibrated rope
+    // anchor to the HMD, so that it follows the user around the anchor.
+    ANCHOR
+};
+
+/**
+ * Tuning parameters of the direction mapping. Angles are given in radians.
+ */
+struct DirectionSettings
+{
+    DirectionMode mode = DirectionMode::FORWARD;
+
+    // The yaw of the HMD while facing straight away from the rope anchor.
+    float tether_yaw = 0.0f;
+
+    // The relative yaw is clamped to this, so that looking over the shoulder never
+    // turns the pull into a sideways or backwards movement.
+    float max_angle = 1.0471976f;
+
+    // Walking time the tether calibration averages the HMD yaw over, in seconds.
+    float calibration_time = 3.0f;
+
+    // The rope anchor in the horizontal plane of the tracking space, used by the
+    // ANCHOR mode. Without an anchor the mode falls back to the fixed tether yaw.
+    bool has_anchor = false;
+    float anchor_x = 0.0f;
+    float anchor_z = 0.0f;
+};
+
+/**
+ * Splits the pull force into a forward and a sideways component from the body yaw,
+ * approximated by the HMD yaw, relative to a calibrated tether forward direction.
+ * Turning the body while pulling then curves the path in game.
+ *
+ * Update() runs once per frame on the frame thread. The resulting relative yaw is a
+ * single float, so that other threads can apply Split() with their own copy of it.
+ */
+class DirectionMapper
+{
+public:
+    DirectionMapper() = default;
+    explicit DirectionMapper(const DirectionSettings& settings);
+
+    /**
+     * Parses the mode name used in the settings. Returns false on an unknown name.
+     */
+    static bool ParseMode(const std::string& name, DirectionMode& mode);
+
+    /**
+     * Returns the yaw of a tracking space pose matrix in radians. Facing -Z is 0 and
+     * turning right is positive.
+     */
+    static float GetYaw(const float (&matrix)[3][4]);
+
+    /**
+     * Distributes the force onto the X and Y axes according to the relative yaw.
+     */
+    static void Split(float force, float relative_yaw, float& x, float& y)
+    {
+        // The comparisons are written so that NaN yields a plain forward pull.
+        if (!(relative_yaw == relative_yaw))
+            relative_yaw = 0.0f;
+        x = force * SinApprox(relative_yaw);
+        y = force * CosApprox(relative_yaw);
+    }
+
+    /**
+     * Feeds the HMD yaw and horizontal position of the current frame and returns the
+     * clamped yaw relative to the tether forward direction. Pass valid = false while
+     * tracking is lost, the last relative yaw is kept then. While a calibration runs,
+     * the frames with walking set are averaged into the new tether forward direction.
+     */
+    float Update(float hmd_yaw, float hmd_x, float hmd_z, bool valid, bool walking, double timestamp);
+
+    /**
+     * Sets the rope anchor used by the ANCHOR mode.
+     */
+    void SetAnchor(float anchor_x, float anchor_z);
+
+    /**
+     * Starts averaging the HMD yaw of the next walking frames into a new tether
+     * forward direction.
+     */
+    void StartCalibration();
+
+    /**
+     * Returns true exactly once after a calibration finished and writes the new tether
+     * yaw, which is already in use.
+     */
+    bool TakeCalibrationResult(float& tether_yaw);
+
+    const DirectionSettings& GetSettings() const;
+
+private:
+    DirectionSettings settings_;
+    float relative_yaw_ = 0.0f;
+
+    bool calibrating_ = false;
+    bool has_calibration_result_ = false;
+    float calibration_sin_ = 0.0f;
+    float calibration_cos_ = 0.0f;
+    float calibration_elapsed_ = 0.0f;
+    double last_timestamp_ = 0.0;
+
+    /**
+     * Polynomial sine and cosine for |angle| <= pi / 2, which covers every clamped
+     * relative yaw. Accurate to about 2e-4, far below the resolution of the input.
+     */
+    static float SinApprox(float angle)
+    {
+        float a2 = angle * angle;
+        return angle * (1.0f - a2 * (1.0f / 6.0f - a2 * (1.0f / 120.0f - a2 * (1.0f / 5040.0f))));
+    }
+
+    static float CosApprox(float angle)
+    {
+        float a2 = angle * angle;
+        return 1.0f - a2 * (0.5f - a2 * (1.0f / 24.0f - a2 * (1.0f / 720.0f - a2 * (1.0f / 40320.0f))));
+    }
+};
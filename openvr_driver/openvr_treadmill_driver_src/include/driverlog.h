@@ -4,6 +4,13 @@
 #include <string>
 #include <openvr_driver.h>
 
+// Starts the background thread writing the log messages to vrserver. Until then and after
+// CleanupDriverLog() the messages are written synchronously.
+extern void InitDriverLog();
+
+// Writes the queued messages and stops the background thread.
+extern void CleanupDriverLog();
+
 extern void DriverLog( const char *pchFormat, ... );
 
 extern void DebugDriverLog( const char *pchFormat, ... );
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The binary protocol of the load cell module, an alternative to the text lines. Every
+ * value is a frame of 6 bytes: the sync byte 0xA5, the value as a little endian 32 bit
+ * float and a CRC-8 (polynomial 0x07) of the 4 value bytes.
+ *
+ * The sync byte never appears in the text lines, so the line parser tells both protocols
+ * apart by the first byte and a module may use either of them.
+ */
+class FrameCodec
+{
+public:
+    static constexpr uint8_t SYNC_BYTE = 0xA5;
+    static constexpr size_t FRAME_SIZE = 6;
+
+    /**
+     * Writes the frame of the given value into the FRAME_SIZE bytes of frame.
+     */
+    static void Encode(float value, uint8_t* frame);
+
+    /**
+     * Returns the value of the FRAME_SIZE bytes of frame, or NaN if the sync byte or the
+     * checksum is wrong or the value is not finite.
+     */
+    static float Decode(const uint8_t* frame);
+
+    static uint8_t Crc8(const uint8_t* data, size_t size);
+};
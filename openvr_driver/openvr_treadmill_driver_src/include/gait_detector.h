@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The movement phases the gait detector distinguishes.
+ */
+enum class GaitPhase
+{
+    IDLE,
+    WALKING,
+    RUNNING
+};
+
+/**
+ * Tuning parameters of the gait detector. All force values are given in the
+ * normalized 0-1 range the load cell module sends, all times in seconds.
+ */
+struct GaitDetectorSettings
+{
+    // Time constant of the slow force trend used for the walk/run classification.
+    float trend_time_constant = 1.5f;
+
+    // A force peak counts as a step once the force fell this far below it, and the
+    // next peak is searched for once the force rose this far above the trough.
+    float step_prominence = 0.02f;
+    // Steps closer together than this are treated as noise (240 steps/min).
+    float min_step_interval = 0.25f;
+    // Steps further apart than this do not contribute to the cadence.
+    float max_step_interval = 2.0f;
+
+    // A rise out of idle above this force and slope already counts as a step onset.
+    float onset_force = 0.04f;
+    float onset_slope = 0.02f;
+
+    // Falls back to idle when no step happened for this long and the trend is low.
+    float idle_timeout = 2.0f;
+    float idle_force = 0.03f;
+
+    // The cadence is only reported after this many consecutive step intervals.
+    uint32_t min_cadence_intervals = 2;
+
+    // Hysteresis of the walk/run classification. The validation recordings show one
+    // force peak per step at roughly 40 steps/min walking and 100+ steps/min running.
+    float run_cadence_enter = 100.0f;
+    float run_cadence_exit = 85.0f;
+    float run_force_enter = 0.6f;
+    float run_force_exit = 0.45f;
+
+    // The cadence range mapped linearly onto the cadence-derived speed.
+    float min_cadence = 30.0f;
+    float max_cadence = 150.0f;
+};
+
+/**
+ * The output of the gait detector after each sample.
+ */
+struct GaitState
+{
+    GaitPhase phase = GaitPhase::IDLE;
+    float cadence = 0.0f;
+    float cadence_speed = 0.0f;
+    float trend = 0.0f;
+    uint32_t step_count = 0;
+    bool step_event = false;
+    bool onset_event = false;
+};
+
+/**
+ * A streaming gait analyser working on the normalized load cell samples. The pull
+ * force on the tether oscillates with every stride, which is used to detect the
+ * individual steps, estimate the cadence and classify the movement into idle,
+ * walking and running. Needs O(1) memory and time per sample.
+ */
+class GaitDetector
+{
+public:
+    GaitDetector() = default;
+    explicit GaitDetector(const GaitDetectorSettings& settings);
+
+    /**
+     * Feeds the next sample with its capture timestamp in seconds into the
+     * detector and returns the updated gait state.
+     */
+    const GaitState& AddSample(float value, double timestamp);
+
+    /**
+     * Returns the gait state after the last added sample.
+     */
+    const GaitState& GetState() const;
+
+    /**
+     * Forgets the whole sample history. Used after a reconnect of the device.
+     */
+    void Reset();
+
+private:
+    GaitDetectorSettings settings_;
+    GaitState state_;
+
+    bool has_sample_ = false;
+    bool searching_peak_ = true;
+    // The step of the stride whose peak is searched was already counted at its onset.
+    bool onset_stride_ = false;
+    float extremum_ = 0.0f;
+    float last_value_ = 0.0f;
+    double last_timestamp_ = 0.0;
+    double last_step_timestamp_ = 0.0;
+    float step_interval_ = 0.0f;
+    uint32_t step_intervals_ = 0;
+
+    /**
+     * Registers a detected step at the given timestamp and updates the cadence.
+     */
+    void RegisterStep(double timestamp);
+
+    /**
+     * Applies the hysteresis rules of the idle/walk/run classification.
+     */
+    void UpdatePhase(double timestamp);
+};
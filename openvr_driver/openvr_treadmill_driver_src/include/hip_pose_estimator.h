@@ -0,0 +1,78 @@
+#pragma once
+
+#include "openvr_driver.h"
+
+/**
+ * The part of the tracking state the hip pose is derived from, captured once per frame
+ * on the frame thread.
+ */
+struct TrackingState
+{
+    // The HMD position and horizontal velocity in the tracking space, and its yaw
+    // in the convention of DirectionMapper::GetYaw().
+    bool hmd_valid = false;
+    float hmd_x = 0.0f;
+    float hmd_y = 0.0f;
+    float hmd_z = 0.0f;
+    float hmd_velocity_x = 0.0f;
+    float hmd_velocity_z = 0.0f;
+    float hmd_yaw = 0.0f;
+
+    // The calibrated rope geometry, see AnchorEstimate.
+    bool has_anchor = false;
+    float anchor_x = 0.0f;
+    float anchor_z = 0.0f;
+    float rope_length = 0.0f;
+    float stretch = 0.0f;
+};
+
+/**
+ * Tuning parameters of the hip pose estimation.
+ */
+struct HipPoseSettings
+{
+    // Height of the belt below the HMD, in meters.
+    float hip_offset = 0.7f;
+
+    // The hip faces the tether forward direction, turned towards the HMD yaw by at most
+    // this angle in radians. The head turns far more than the hips.
+    float max_hip_angle = 0.5f;
+};
+
+/**
+ * Estimates the pose of the belt the rope is fixed to. The belt sits on the line from
+ * the anchor to the HMD, at the rope length plus the stretch caused by the measured
+ * force. Its velocity combines the sideways velocity of the HMD with the radial velocity
+ * derived from the change of the force, which reacts faster than the head position.
+ *
+ * The pose is updated on every frame with the HMD state of that frame and the latest
+ * force sample, so it describes the present and needs no time offset.
+ */
+class HipPoseEstimator
+{
+public:
+    HipPoseEstimator() = default;
+    explicit HipPoseEstimator(const HipPoseSettings& settings);
+
+    /**
+     * Computes the pose of the current frame from its tracking state and the latest force
+     * sample, which was measured at sample_timestamp in seconds on the steady clock. The
+     * force rate is only updated when a new sample arrives. Returns an invalid pose
+     * without tracking or anchor.
+     */
+    vr::DriverPose_t Update(const TrackingState& tracking, float force, double sample_timestamp);
+
+    /**
+     * Returns the pose sent while nothing is known, which is the previous behavior of
+     * the driver.
+     */
+    static vr::DriverPose_t GetInvalidPose();
+
+private:
+    HipPoseSettings settings_;
+
+    bool has_previous_ = false;
+    float previous_force_ = 0.0f;
+    double previous_timestamp_ = 0.0;
+    float force_rate_ = 0.0f;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_codec.h"
+
+/**
+ * Splits the byte stream of the load cell module into lines. The module ends every
+ * value with "\r\n", a carriage return ends a line and line feeds are ignored.
+ *
+ * Bytes are fed one at a time together with the time they were received, so that the
+ * parser works with any chunking of the stream and keeps the arrival of the first byte
+ * and the end of every line.
+ *
+ * A sync byte of the binary protocol at the start of a line begins a binary frame
+ * instead, which counts as a line of its own once its last byte arrived.
+ */
+class LineParser
+{
+public:
+    // Longer lines are no values of the module, e.g. noise while it restarts.
+    static constexpr size_t MAX_LINE_LENGTH = 128;
+
+    /**
+     * Feeds the next received byte. Returns true if the byte ended a line or the line
+     * got too long, the line is then available until the next call.
+     */
+    bool Push(char ch, double time);
+
+    /**
+     * Forgets a partially received line, e.g. after a read error.
+     */
+    void Reset();
+
+    /**
+     * Returns the text of the last ended line without the line end, or an empty text if
+     * it got too long.
+     */
+    const char* GetLine() const;
+
+    size_t GetLength() const;
+
+    /**
+     * Returns true if the last line was discarded for being too long.
+     */
+    bool IsOverflow() const;
+
+    /**
+     * Returns true if the last line was a binary frame, GetLine() is empty then.
+     */
+    bool IsBinary() const;
+
+    /**
+     * Returns the value of the last line, or NaN if it is no valid text line or frame.
+     */
+    float GetValue() const;
+
+    /**
+     * Returns the receive time of the first byte of the last line. Equals the end time
+     * for an empty line.
+     */
+    double GetFirstByteTime() const;
+
+    double GetEndTime() const;
+
+    /**
+     * Returns the finite number at the start of the given line, or NaN if it does not
+     * start with one.
+     */
+    static float ParseValue(const char* line);
+
+private:
+    char buffer_[MAX_LINE_LENGTH + 1] = { 0 };
+    size_t length_ = 0;
+    bool complete_ = false;
+    bool overflow_ = false;
+    double first_byte_time_ = 0.0;
+    double end_time_ = 0.0;
+
+    uint8_t frame_[FrameCodec::FRAME_SIZE] = { 0 };
+    size_t frame_length_ = 0;
+    bool binary_ = false;
+};
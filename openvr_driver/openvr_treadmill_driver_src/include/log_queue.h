@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Tuning parameters of the log queue.
+ */
+struct LogQueueSettings
+{
+    // Repetitions of a message within this time after it was written are only counted
+    // and summarized once the time is up, e.g. "Failed to open serial port ×37".
+    float repeat_window = 30.0f;
+    // The longest time a message waits in the queue before the flusher writes it.
+    float flush_interval = 0.25f;
+};
+
+/**
+ * Decouples the threads of the driver from the log output of vrserver, which may block
+ * on file I/O. Any thread formats its message into a slot of a bounded lock free queue,
+ * a background flusher writes the messages to the sink. The flusher collapses repeated
+ * messages, so that a retry loop does not flood the log.
+ *
+ * Enqueue never blocks and never allocates. A message arriving while the queue is full is
+ * dropped and counted, the flusher reports the number of dropped messages.
+ */
+class LogQueue
+{
+public:
+    /**
+     * Receives the finished log lines on the flusher thread.
+     */
+    using Sink = void (*)(const char* message);
+
+    static constexpr size_t CAPACITY = 256;
+    static constexpr size_t MAX_MESSAGE_LENGTH = 512;
+
+    LogQueue();
+    explicit LogQueue(const LogQueueSettings& settings);
+    ~LogQueue();
+
+    /**
+     * Starts the flusher thread writing to the given sink. Messages enqueued before are
+     * written first.
+     */
+    void Start(Sink sink);
+
+    /**
+     * Writes all queued messages and pending repeat counts and stops the flusher thread.
+     * Waits for the calls of EnqueueWhileRunning() in progress, so that none of their
+     * messages stays behind in the queue.
+     */
+    void Stop();
+
+    bool IsRunning() const;
+
+    /**
+     * Formats a message into the queue. Safe to call from any number of threads at once.
+     * Returns false if the queue was full and the message was dropped.
+     */
+    bool Enqueue(const char* format, va_list args);
+
+    /**
+     * Like Enqueue(), but only while the flusher runs. Returns false without using the
+     * arguments once the queue is stopped, the caller then writes the message itself.
+     * A message dropped on a full queue counts as taken.
+     */
+    bool EnqueueWhileRunning(const char* format, va_list args);
+
+    /**
+     * Returns the number of messages dropped since the start.
+     */
+    uint64_t GetDroppedCount() const;
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<size_t> sequence;
+        char message[MAX_MESSAGE_LENGTH];
+    };
+
+    /**
+     * A message written recently, whose repetitions are counted instead of written.
+     */
+    struct RecentMessage
+    {
+        // An empty message is a message as well, so a slot is marked as taken.
+        bool in_use = false;
+        std::string message;
+        std::chrono::steady_clock::time_point window_start;
+        uint32_t repetitions = 0;
+    };
+
+    static constexpr size_t RECENT_MESSAGES = 16;
+
+    LogQueueSettings settings_;
+
+    // Bounded multi producer queue after Dmitry Vyukov. The sequence number of a slot
+    // tells the producers and the consumer whose turn it is.
+    std::array<Slot, CAPACITY> slots_;
+    alignas(64) std::atomic<size_t> enqueue_position_{ 0 };
+    alignas(64) size_t dequeue_position_ = 0;
+
+    std::atomic<uint64_t> dropped_{ 0 };
+    uint64_t reported_dropped_ = 0;
+
+    // Only used by the flusher thread.
+    std::array<RecentMessage, RECENT_MESSAGES> recent_;
+
+    Sink sink_ = nullptr;
+    std::atomic<bool> running_{ false };
+    // The calls of EnqueueWhileRunning() that saw the queue running and are not done yet.
+    std::atomic<uint32_t> producers_{ 0 };
+    std::thread flusher_thread_;
+    std::mutex wait_lock_;
+    std::condition_variable wakeup_;
+
+    /**
+     * The loop of the flusher thread.
+     */
+    void FlusherLoop();
+
+    /**
+     * Writes all queued messages. With final set, the pending repeat counts are written
+     * regardless of their window.
+     */
+    void Flush(bool final);
+
+    /**
+     * Writes a message unless it repeats a recent one.
+     */
+    void Write(const char* message, std::chrono::steady_clock::time_point now);
+
+    /**
+     * Writes the repeat count of a recent message and restarts its window.
+     */
+    void WriteRepetitions(RecentMessage& recent, std::chrono::steady_clock::time_point now);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+/**
+ * Tuning parameters of the noise floor estimator. Force values are given in the
+ * normalized 0-1 range, rates per second and times in seconds.
+ */
+struct NoiseFloorSettings
+{
+    // Disables the whole stage, so that the values pass unchanged.
+    bool enabled = true;
+
+    // The user has to be idle this long before the estimates are updated.
+    float confidence_time = 1.0f;
+
+    // Idle samples further than this above the baseline are not treated as idle
+    // load, but as a deliberate pull. While idle, the output starts at this edge.
+    float idle_band = 0.15f;
+
+    // Maximum speed the baseline follows the idle load with.
+    float baseline_rate = 0.05f;
+    // The baseline is never moved above this, a stronger constant pull is real input.
+    float max_baseline = 0.3f;
+
+    // Time constant of the noise level estimate.
+    float noise_time_constant = 2.0f;
+
+    // The deadzone is this many noise levels wide, but at least min_deadzone
+    // and at most max_deadzone.
+    float deadzone_factor = 4.0f;
+    float min_deadzone = 0.01f;
+    float max_deadzone = 0.1f;
+};
+
+/**
+ * Continuously estimates the idle baseline and noise level of the pull force and
+ * derives a re-zeroed, deadzoned value from it. Leaning into the rope or breathing
+ * while standing then no longer leak through as a slow creep in game.
+ *
+ * The baseline follows the idle load with a rate limited median tracker, which
+ * ignores outliers, and the noise level is an exponentially weighted mean absolute
+ * deviation around it. Both are only updated while the user is confidently idle.
+ */
+class NoiseFloorEstimator
+{
+public:
+    NoiseFloorEstimator() = default;
+    explicit NoiseFloorEstimator(const NoiseFloorSettings& settings);
+
+    /**
+     * Feeds the next sample with the idle classification of the gait detector and
+     * returns the re-zeroed value.
+     */
+    float Process(float value, bool idle, double timestamp);
+
+    /**
+     * Forgets the estimates. Used after a reconnect of the device.
+     */
+    void Reset();
+
+    /**
+     * Returns the current idle baseline.
+     */
+    float GetBaseline() const;
+
+    /**
+     * Returns the current deadzone above the baseline.
+     */
+    float GetDeadzone() const;
+
+private:
+    NoiseFloorSettings settings_;
+
+    float baseline_ = 0.0f;
+    float noise_ = 0.0f;
+    float deadzone_ = 0.0f;
+
+    bool has_timestamp_ = false;
+    double last_timestamp_ = 0.0;
+    bool was_idle_ = false;
+    double idle_since_ = 0.0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Streaming estimator of a single quantile with the P-squared algorithm by Jain and
+ * Chlamtac. Keeps five markers whose heights are adjusted with a piecewise
+ * parabolic fit, so memory and time per sample are constant no matter how long
+ * the stream is.
+ */
+class P2QuantileEstimator
+{
+public:
+    /**
+     * Creates an estimator for the given quantile between 0 and 1.
+     */
+    explicit P2QuantileEstimator(double quantile = 0.5);
+
+    /**
+     * Adds the next observation.
+     */
+    void Add(double value);
+
+    /**
+     * Returns the current estimate. Exact as long as fewer than five observations
+     * were added, 0 without any observation.
+     */
+    double GetEstimate() const;
+
+    /**
+     * Returns the number of added observations.
+     */
+    size_t GetCount() const;
+
+    /**
+     * Forgets all observations.
+     */
+    void Reset();
+
+private:
+    double quantile_;
+    size_t count_ = 0;
+
+    std::array<double, 5> heights_{};
+    std::array<double, 5> positions_{};
+    std::array<double, 5> desired_positions_{};
+    std::array<double, 5> increments_{};
+
+    /**
+     * Returns the parabolic prediction of marker i moved by d positions.
+     */
+    double Parabolic(size_t i, double d) const;
+
+    /**
+     * Returns the linear prediction of marker i moved by d positions.
+     */
+    double Linear(size_t i, int d) const;
+};
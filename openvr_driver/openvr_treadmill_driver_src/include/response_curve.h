@@ -0,0 +1,207 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+/**
+ * The response curves available in the settings. The built-in curves are baked
+ * into lookup tables at compile time, GAMMA and CUSTOM are sampled at load time.
+ */
+enum class ResponseCurveType
+{
+    LINEAR,
+    GAMMA_SOFT,
+    GAMMA_HARD,
+    S_CURVE,
+    GAMMA,
+    CUSTOM
+};
+
+/**
+ * Number of linear segments a curve is approximated with. The table holds one
+ * more entry than segments, so that the interpolation never needs a bounds check.
+ * The smooth curves stay within 2e-4 of their function. The steep start of x^0.6 is
+ * the worst case: it is off by up to 1.6e-2 in the first segment and by up to 1.5e-3
+ * above it, well below what a pull on the rope can resolve near rest.
+ */
+static constexpr size_t RESPONSE_CURVE_SEGMENTS = 64;
+
+/**
+ * The sampled curve. Aligned to a cache line and padded to a multiple of 16 floats,
+ * so that the table can be streamed with aligned vector loads.
+ */
+struct alignas(64) ResponseCurveTable
+{
+    std::array<float, RESPONSE_CURVE_SEGMENTS + 16> values{};
+};
+
+namespace response_curve_detail
+{
+    /**
+     * Natural logarithm usable in constant expressions. Reduces the argument into
+     * [0.5, 1) and then uses the quickly converging atanh series.
+     */
+    constexpr double Log(double x)
+    {
+        if (x <= 0.0)
+            return -1.0e300;
+
+        const double ln2 = 0.69314718055994530942;
+        int exponent = 0;
+        while (x < 0.5)
+        {
+            x *= 2.0;
+            exponent--;
+        }
+        while (x >= 1.0)
+        {
+            x *= 0.5;
+            exponent++;
+        }
+
+        double y = (x - 1.0) / (x + 1.0);
+        double y2 = y * y;
+        double term = y;
+        double sum = 0.0;
+        for (int n = 1; n < 60; n += 2)
+        {
+            sum += term / n;
+            term *= y2;
+        }
+        return 2.0 * sum + exponent * ln2;
+    }
+
+    /**
+     * Exponential function usable in constant expressions. Halves the argument
+     * until the Taylor series converges quickly and squares the result back up.
+     */
+    constexpr double Exp(double x)
+    {
+        int squarings = 0;
+        while (x > 0.5 || x < -0.5)
+        {
+            x *= 0.5;
+            squarings++;
+        }
+
+        double sum = 1.0;
+        double term = 1.0;
+        for (int n = 1; n < 20; n++)
+        {
+            term *= x / n;
+            sum += term;
+        }
+        for (int i = 0; i < squarings; i++)
+            sum *= sum;
+        return sum;
+    }
+
+    constexpr double Pow(double base, double exponent)
+    {
+        return base <= 0.0 ? 0.0 : Exp(exponent * Log(base));
+    }
+
+    /**
+     * Samples the given curve function at the segment borders of the table.
+     */
+    template <typename Function>
+    constexpr ResponseCurveTable MakeTable(Function function)
+    {
+        ResponseCurveTable table{};
+        for (size_t i = 0; i <= RESPONSE_CURVE_SEGMENTS; i++)
+        {
+            double x = static_cast<double>(i) / RESPONSE_CURVE_SEGMENTS;
+            table.values[i] = static_cast<float>(function(x));
+        }
+        for (size_t i = RESPONSE_CURVE_SEGMENTS + 1; i < table.values.size(); i++)
+            table.values[i] = table.values[RESPONSE_CURVE_SEGMENTS];
+        return table;
+    }
+}
+
+/**
+ * The lookup tables of the built-in curves, generated by the compiler.
+ */
+static constexpr ResponseCurveTable LINEAR_CURVE_TABLE =
+    response_curve_detail::MakeTable([](double x) { return x; });
+static constexpr ResponseCurveTable GAMMA_SOFT_CURVE_TABLE =
+    response_curve_detail::MakeTable([](double x) { return response_curve_detail::Pow(x, 0.6); });
+static constexpr ResponseCurveTable GAMMA_HARD_CURVE_TABLE =
+    response_curve_detail::MakeTable([](double x) { return response_curve_detail::Pow(x, 2.0); });
+static constexpr ResponseCurveTable S_CURVE_TABLE =
+    response_curve_detail::MakeTable([](double x) { return x * x * (3.0 - 2.0 * x); });
+
+/**
+ * Maps the normalized pull force onto the stick deflection sent to SteamVR.
+ * All curves are evaluated through a lookup table with linear interpolation,
+ * so the cost per sample is independent of the curve.
+ */
+class ResponseCurve
+{
+public:
+    /**
+     * Creates the linear identity curve.
+     */
+    ResponseCurve();
+
+    /**
+     * Creates the curve of the given type. GAMMA uses the given exponent, CUSTOM
+     * falls back to the linear curve and has to be created with FromPoints().
+     * A GAMMA exponent that is not positive gives the linear curve, whose type is
+     * then LINEAR as well.
+     */
+    explicit ResponseCurve(ResponseCurveType type, float gamma = 1.0f);
+
+    /**
+     * Parses the curve type name used in the settings. Returns false on an unknown name.
+     */
+    static bool ParseType(const std::string& name, ResponseCurveType& type);
+
+    /**
+     * Returns the settings name of the given curve type.
+     */
+    static const char* GetTypeName(ResponseCurveType type);
+
+    /**
+     * Creates a piecewise linear curve from a settings string of "x:y" pairs
+     * separated by commas, e.g. "0:0,0.2:0.05,1:1". The points are sorted by x and
+     * both coordinates must lie inside [0, 1]. Returns false and leaves the curve
+     * untouched if the description is malformed.
+     */
+    bool FromPoints(const std::string& description);
+
+    /**
+     * Maps a single normalized value. Values outside [0, 1] and NaN are clamped.
+     */
+    float Evaluate(float value) const
+    {
+        // The comparisons are written so that NaN ends up at 0.
+        float x = value > 0.0f ? value : 0.0f;
+        x = x < 1.0f ? x : 1.0f;
+
+        float position = x * RESPONSE_CURVE_SEGMENTS;
+        size_t index = static_cast<size_t>(position);
+        index = index < RESPONSE_CURVE_SEGMENTS - 1 ? index : RESPONSE_CURVE_SEGMENTS - 1;
+        float fraction = position - static_cast<float>(index);
+
+        float low = this->table_.values[index];
+        float high = this->table_.values[index + 1];
+        return low + fraction * (high - low);
+    }
+
+    /**
+     * Maps a whole block of values. Kept free of branches, so that the compiler
+     * can vectorize the loop.
+     */
+    void EvaluateBlock(const float* values, float* results, size_t count) const;
+
+    /**
+     * Returns the type the curve was created with.
+     */
+    ResponseCurveType GetType() const;
+
+private:
+    ResponseCurveType type_;
+    ResponseCurveTable table_;
+};
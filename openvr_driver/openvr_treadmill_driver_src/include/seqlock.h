@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Publishes a small trivially copyable value from a single writer thread to any number
+ * of reader threads without a lock.
+ *
+ * The writer never waits. A reader copies the value and retries if the sequence counter
+ * tells that a write happened in between, which is only the case during the few
+ * nanoseconds the writer needs to copy the value. The value is stored in atomic words,
+ * so that the concurrent copy is not a data race.
+ */
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a trivially copyable type");
+    static_assert(std::is_default_constructible<T>::value, "Seqlock needs a default constructible type");
+
+public:
+    Seqlock()
+    {
+        this->Store(T());
+    }
+
+    /**
+     * Publishes a new value. Must only be called from one thread at a time.
+     */
+    void Store(const T& value)
+    {
+        std::array<uint64_t, WORDS> buffer{};
+        std::memcpy(buffer.data(), &value, sizeof(T));
+
+        uint64_t sequence = this->sequence_.load(std::memory_order_relaxed);
+        this->sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; i++)
+            this->words_[i].store(buffer[i], std::memory_order_relaxed);
+
+        this->sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * Returns a consistent copy of the last published value.
+     */
+    T Load() const
+    {
+        std::array<uint64_t, WORDS> buffer;
+        uint64_t sequence;
+        do
+        {
+            sequence = this->sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++)
+                buffer[i] = this->words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) != 0 || sequence != this->sequence_.load(std::memory_order_relaxed));
+
+        // The bytes are copied over a default constructed value. T may have default member
+        // initializers, which make it non-trivial, but being trivially copyable it is
+        // fully described by its bytes.
+        T value;
+        std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence_{ 0 };
+    std::array<std::atomic<uint64_t>, WORDS> words_;
+};
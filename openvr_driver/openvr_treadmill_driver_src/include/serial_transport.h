@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * The byte stream between the capture and the load cell module. Hides the serial port
+ * API of the operating system, so that the capture engine itself is platform
+ * independent and can also run against simulated devices.
+ *
+ * Read() runs on the capture thread. CancelRead() may be called from any other thread,
+ * all other methods are called by the capture thread only.
+ */
+class SerialTransport
+{
+public:
+    virtual ~SerialTransport() = default;
+
+    /**
+     * Creates the serial port transport of the platform the driver is built for.
+     */
+    static std::unique_ptr<SerialTransport> Create();
+
+    /**
+     * Returns the first present port whose device name contains the given text and that
+     * is not in the excluded set, or an empty string if there is none.
+     */
+    virtual std::string FindPort(const std::string& name_match, const std::set<std::string>& excluded) = 0;
+
+    /**
+     * Opens the given port with 8N1 framing. Returns false if the port cannot be opened.
+     */
+    virtual bool Open(const std::string& port, uint32_t baud_rate) = 0;
+
+    virtual void Close() = 0;
+
+    virtual bool IsOpen() const = 0;
+
+    /**
+     * Sets how long Read() waits for the first byte.
+     */
+    virtual void SetReadTimeout(uint32_t milliseconds) = 0;
+
+    /**
+     * Waits until bytes arrived or the read timeout elapsed and reads up to the given
+     * number of bytes. Returns the number of bytes read, 0 on a timeout or a cancelled
+     * read and -1 if the connection failed.
+     */
+    virtual int Read(char* buffer, size_t size) = 0;
+
+    /**
+     * Writes the given bytes. Returns false if not all of them could be written.
+     */
+    virtual bool Write(const char* data, size_t size) = 0;
+
+    /**
+     * Makes a pending Read() return early. A read starting right after the call may
+     * still wait for its full timeout.
+     */
+    virtual void CancelRead() = 0;
+
+    /**
+     * Discards all buffered data and raises the DTR and RTS lines, which restarts
+     * Arduino boards.
+     */
+    virtual void Reset() = 0;
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class SessionRecordType : uint16_t
+{
+    // A line of the load cell module. flags: gait phase in bits 0 and 1, bit 2 for a
+    // step, bit 3 for a binary frame.
+    SAMPLE = 1,
+    // A read that timed out, failed or returned an invalid line.
+    READ_ERROR = 2,
+    // An attempt to open the port. flags: 1 if it succeeded. raw_value: baud rate.
+    CONNECT = 3,
+    DISCONNECT = 4,
+    // The capture starts over after too many errors. raw_value: the error count.
+    RECONNECT = 5,
+    // flags: 1 when entering the standby, 0 when leaving it.
+    STANDBY = 6,
+    CALIBRATION_START = 7,
+    // The normalization bounds in use. flags: 1 if they come from a calibration session.
+    // raw_value and value: lower and upper bound.
+    CONFIG = 8
+};
+
+/**
+ * A record of the session log, 32 bytes little endian without padding. All times are
+ * seconds on the clock of the capture. The load cell module has no clock, the device
+ * time of a sample is the arrival of the first byte of its line, one byte time after
+ * the module started to send it.
+ */
+struct SessionRecord
+{
+    // The capture timestamp of a sample, the one the signal pipeline saw, or the time
+    // of an event.
+    double host_time;
+    double device_time;
+    // Increases by one with every record, also with the ones lost on a full ring buffer.
+    uint32_t sequence;
+    uint16_t type;
+    uint16_t flags;
+    // The value of a sample as sent by the module and after the signal pipeline.
+    float raw_value;
+    float value;
+};
+
+static_assert(sizeof(SessionRecord) == 32, "The session record layout must not change by accident");
+
+/**
+ * The start of a session log. The metadata is text of "key=value" lines.
+ */
+struct SessionFileHeader
+{
+    static constexpr uint32_t MAGIC = 0x53534D54; // "TMSS"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t SIZE = 4096;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t chunk_size;
+    uint32_t record_size;
+    // Set when the log was closed, a log without it ends with a crash.
+    uint32_t closed;
+    // The capture clock and the calendar time in seconds since 1970 at the start.
+    double start_host_time;
+    double start_unix_time;
+    // The records lost on a full ring buffer or a failed write, set on closing. The
+    // sequence numbers only show the ones lost before the last written record.
+    uint64_t lost_records;
+    char metadata[SIZE - 48];
+};
+
+static_assert(sizeof(SessionFileHeader) == SessionFileHeader::SIZE, "The session header must fill its page");
+
+/**
+ * The first record slot of every chunk.
+ */
+struct SessionChunkHeader
+{
+    static constexpr uint32_t MAGIC = 0x4B484354; // "TCHK"
+
+    uint32_t magic;
+    uint32_t index;
+    // The records of the chunk that are completely written. Stored after the records,
+    // a reader only trusts these.
+    uint32_t record_count;
+    uint32_t reserved;
+    uint64_t first_sequence;
+    uint64_t reserved_2;
+};
+
+static_assert(sizeof(SessionChunkHeader) == sizeof(SessionRecord), "The chunk header takes the first record slot");
+
+/**
+ * Records a capture session into an append-only log file, so that real sessions can be
+ * replayed offline, e.g. to tune the filters.
+ *
+ * Record() is called by the capture thread only and costs a single push into a lock free
+ * ring buffer, without a lock, a system call or an allocation. A background writer moves
+ * the records into chunks of a memory mapped file. A chunk stores its record count after
+ * its records, so the file stays readable up to the last flush when the driver crashes:
+ * the mapped pages belong to the page cache and reach the file even if the process dies.
+ * Completed chunks and, once per second, the current one are also flushed to the disk
+ * against a crash of the system. The space of a chunk is reserved before it is mapped,
+ * so that a full disk fails the recording instead of the process.
+ */
+class SessionRecorder
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    static constexpr size_t RECORDS_PER_CHUNK = CHUNK_SIZE / sizeof(SessionRecord) - 1;
+    static constexpr size_t RING_CAPACITY = 8192;
+
+    SessionRecorder() = default;
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    /**
+     * Creates the log file, replacing an existing one, and starts the writer. Returns
+     * false if the file cannot be created. Must not be called while the producer records.
+     */
+    bool Open(const std::string& file, double start_host_time, const std::string& metadata);
+
+    /**
+     * Writes the remaining records, marks the log as closed and stops the writer. Must
+     * not be called while the producer records.
+     */
+    void Close();
+
+    bool IsOpen() const;
+
+    /**
+     * Queues a record. Returns false if the recorder is not open or the ring buffer is
+     * full, the record is lost then.
+     */
+    bool Record(SessionRecordType type, uint16_t flags, double host_time, double device_time = 0.0,
+        float raw_value = 0.0f, float value = 0.0f);
+
+    /**
+     * Returns the number of records written into the file.
+     */
+    uint64_t GetWrittenCount() const;
+
+    /**
+     * Returns the number of records lost on a full ring buffer or a failed write.
+     */
+    uint64_t GetLostCount() const;
+
+private:
+    /**
+     * A mapped range of the log file, aligned down to the mapping granularity.
+     */
+    struct MappedRegion
+    {
+        void* base = nullptr;
+        size_t length = 0;
+        uint8_t* data = nullptr;
+    };
+
+    std::unique_ptr<SessionRecord[]> ring_;
+    alignas(64) std::atomic<size_t> write_position_{ 0 };
+    alignas(64) std::atomic<size_t> read_position_{ 0 };
+    // Only used by the producer.
+    alignas(64) uint32_t next_sequence_ = 0;
+    std::atomic<bool> open_{ false };
+    std::atomic<uint64_t> written_{ 0 };
+    std::atomic<uint64_t> lost_{ 0 };
+
+    // Only used by the writer thread while open.
+#ifdef _WIN32
+    void* file_ = nullptr;
+#else
+    int file_ = -1;
+#endif
+    uint64_t file_size_ = 0;
+    MappedRegion header_region_;
+    MappedRegion chunk_region_;
+    SessionChunkHeader* chunk_ = nullptr;
+    uint32_t chunk_index_ = 0;
+    uint32_t chunk_records_ = 0;
+    bool failed_ = false;
+
+    std::thread writer_thread_;
+    std::atomic<bool> running_{ false };
+    std::mutex wait_lock_;
+    std::condition_variable wakeup_;
+
+    /**
+     * The loop of the writer thread.
+     */
+    void WriterLoop();
+
+    /**
+     * Moves all queued records into the file and commits them.
+     */
+    void Drain();
+
+    /**
+     * Publishes the record count of the current chunk after its records.
+     */
+    void CommitChunk();
+
+    /**
+     * Flushes and unmaps the current chunk and maps a new one at the end of the file.
+     */
+    bool NextChunk();
+
+    /**
+     * Grows the file to the given size with allocated space.
+     */
+    bool Reserve(uint64_t size);
+
+    bool MapRegion(uint64_t offset, size_t length, MappedRegion& region);
+    void UnmapRegion(MappedRegion& region);
+
+    /**
+     * Writes the mapped pages of the region to the file, with wait set also to the disk.
+     */
+    void FlushRegion(const MappedRegion& region, bool wait);
+
+    void CloseFile();
+};
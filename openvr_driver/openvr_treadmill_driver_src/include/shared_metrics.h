@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "seqlock.h"
+
+/**
+ * The live state of a treadmill device as seen by external monitoring tools. The layout
+ * is fixed and free of padding, so that tools in any language can decode it. All times
+ * are seconds on the steady clock of the driver, i.e. QueryPerformanceCounter on Windows
+ * and CLOCK_MONOTONIC on Linux.
+ */
+struct SharedMetricsValues
+{
+    double timestamp = 0.0;
+    double first_byte_time = 0.0;
+    double publish_time = 0.0;
+    // When the driver wrote this state.
+    double write_time = 0.0;
+
+    uint64_t sample_sequence = 0;
+    uint64_t samples = 0;
+    uint64_t read_errors = 0;
+    uint64_t reconnects = 0;
+    uint64_t removed_spikes = 0;
+    uint64_t frames = 0;
+    uint64_t input_updates = 0;
+    uint64_t consumed_samples = 0;
+
+    // The conditioned load cell value, the force after the response curve and the
+    // joystick axes sent to SteamVR.
+    float value = 0.0f;
+    float force = 0.0f;
+    float axis_x = 0.0f;
+    float axis_y = 0.0f;
+    float cadence = 0.0f;
+    uint32_t gait_phase = 0;
+    uint32_t connected = 0;
+    uint32_t standby = 0;
+};
+
+static_assert(sizeof(SharedMetricsValues) == 128, "The shared metrics layout must not change by accident");
+
+/**
+ * The shared memory block. The header never changes after the block was created, the
+ * values follow on their own cache line as a seqlock: a 64 bit sequence number, odd
+ * while the driver writes, followed by the values. A reader copies the values and
+ * retries if the sequence was odd or changed meanwhile.
+ */
+struct alignas(64) SharedMetricsBlock
+{
+    static constexpr uint32_t MAGIC = 0x54454D54; // "TMET"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t process_id;
+
+    alignas(64) Seqlock<SharedMetricsValues> metrics;
+};
+
+static_assert(offsetof(SharedMetricsBlock, metrics) == 64, "The values must start on the second cache line");
+
+/**
+ * Publishes the live state of a device in a named shared memory block, a file mapping
+ * named "Local\<name>" on Windows and the POSIX shared memory object "/<name>" on Linux.
+ * Publishing is a plain seqlock store without any system call, tools read the block at
+ * any rate without calling into the driver or vrserver.
+ */
+class SharedMetrics
+{
+public:
+    SharedMetrics() = default;
+    ~SharedMetrics();
+
+    SharedMetrics(const SharedMetrics&) = delete;
+    SharedMetrics& operator=(const SharedMetrics&) = delete;
+
+    /**
+     * Creates or reopens the block of the given name and initializes its header.
+     * Returns false if the shared memory is not available.
+     */
+    bool Open(const std::string& name);
+
+    /**
+     * Unmaps the block. On Linux the name is removed as well.
+     */
+    void Close();
+
+    bool IsOpen() const;
+
+    /**
+     * Writes the given state into the block. Must only be called from one thread at a
+     * time, does nothing if the block is not open.
+     */
+    void Publish(const SharedMetricsValues& values);
+
+private:
+    SharedMetricsBlock* block_ = nullptr;
+    std::string name_;
+
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "auto_calibration.h"
+#include "gait_detector.h"
+#include "noise_floor.h"
+#include "spike_filter.h"
+
+/**
+ * The settings of all stages of the signal pipeline.
+ */
+struct SignalPipelineSettings
+{
+    CalibrationProfile calibration;
+    AutoCalibrationSettings auto_calibration;
+    SpikeFilterSettings spike_filter;
+    GaitDetectorSettings gait_detector;
+    NoiseFloorSettings noise_floor;
+};
+
+/**
+ * A treadmill sample after it went through the signal pipeline.
+ */
+struct ConditionedSample
+{
+    float value = 0.0f;
+    GaitState gait;
+};
+
+/**
+ * The host side signal conditioning of the load cell samples. Runs on the capture
+ * thread for every received sample, so every stage has to stay O(1) per sample.
+ */
+class SignalPipeline
+{
+public:
+    SignalPipeline() = default;
+    explicit SignalPipeline(const SignalPipelineSettings& settings);
+
+    /**
+     * Runs a raw sample with its capture timestamp in seconds through all stages
+     * and returns the conditioned result.
+     */
+    const ConditionedSample& Process(float raw_value, double timestamp);
+
+    /**
+     * Returns the result of the last processed sample.
+     */
+    const ConditionedSample& GetOutput() const;
+
+    /**
+     * Resets all stages. Used after a reconnect of the device.
+     */
+    void Reset();
+
+    /**
+     * Starts a calibration session. Once it collected enough walking and running
+     * samples, its bounds replace the current calibration profile.
+     */
+    void StartCalibration();
+
+    /**
+     * Returns true exactly once after a calibration session replaced the profile
+     * and writes the new profile into the given one, so that it can be stored.
+     */
+    bool TakeCalibrationResult(CalibrationProfile& profile);
+
+    /**
+     * Returns the settings in use, including the calibration profile of the last
+     * calibration session.
+     */
+    const SignalPipelineSettings& GetSettings() const;
+
+    /**
+     * Returns the automatic calibration for its continuously suggested bounds.
+     */
+    const AutoCalibrator& GetAutoCalibrator() const;
+
+    /**
+     * Returns the spike filter stage for its statistics.
+     */
+    const SpikeFilter& GetSpikeFilter() const;
+
+    /**
+     * Returns the noise floor stage for its current baseline and deadzone.
+     */
+    const NoiseFloorEstimator& GetNoiseFloor() const;
+
+private:
+    SignalPipelineSettings settings_;
+    AutoCalibrator auto_calibrator_;
+    bool has_calibration_result_ = false;
+    SpikeFilter spike_filter_;
+    GaitDetector gait_detector_;
+    NoiseFloorEstimator noise_floor_;
+    ConditionedSample output_;
+
+    /**
+     * Maps a received value onto 0-1 with the current calibration profile.
+     */
+    float Normalize(float value) const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Tuning parameters of the spike filter.
+ */
+struct SpikeFilterSettings
+{
+    // Number of past samples the median and MAD are computed over. Odd values
+    // between 3 and 11 are supported, 0 disables the filter.
+    size_t window = 5;
+
+    // A sample deviating more than this many (scaled) MADs from the median is a
+    // spike candidate.
+    float threshold = 3.0f;
+
+    // Lower bound of the allowed deviation. Without it, a window of identical idle
+    // values has a MAD of 0 and every tiny change would be a candidate.
+    float min_deviation = 0.1f;
+};
+
+/**
+ * A streaming Hampel filter removing isolated spikes of the load cell signal.
+ *
+ * Samples close to the median of the recent window or to their predecessor pass
+ * without delay, so that steady ramps are never touched. A sample jumping away
+ * from both is held back for one sample: if the next sample confirms the new
+ * level it was a real onset and the signal continues from there, otherwise it
+ * was an isolated spike and is replaced by the median. This limits the added
+ * latency to a single sample and only for samples that look suspicious.
+ */
+class SpikeFilter
+{
+public:
+    static constexpr size_t MAX_WINDOW = 11;
+
+    SpikeFilter() = default;
+    explicit SpikeFilter(const SpikeFilterSettings& settings);
+
+    /**
+     * Feeds the next raw sample into the filter and returns the value to publish.
+     */
+    float Process(float value);
+
+    /**
+     * Forgets the sample history and a held back candidate.
+     */
+    void Reset();
+
+    /**
+     * Returns how many spikes were replaced since the last reset.
+     */
+    size_t GetRemovedSpikes() const;
+
+    /**
+     * Returns how many candidates turned out to be real onsets and were therefore
+     * delayed by one sample since the last reset.
+     */
+    size_t GetDelayedOnsets() const;
+
+private:
+    SpikeFilterSettings settings_;
+
+    std::array<float, MAX_WINDOW> history_{};
+    size_t history_size_ = 0;
+    size_t history_index_ = 0;
+
+    bool has_candidate_ = false;
+    float candidate_ = 0.0f;
+    float last_input_ = 0.0f;
+    float last_output_ = 0.0f;
+
+    size_t removed_spikes_ = 0;
+    size_t delayed_onsets_ = 0;
+
+    /**
+     * Appends a value to the circular sample history.
+     */
+    void PushHistory(float value);
+
+    /**
+     * Computes the median and the allowed deviation around it from the history.
+     */
+    void ComputeBand(float& median, float& deviation) const;
+};
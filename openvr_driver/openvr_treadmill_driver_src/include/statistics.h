@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A log bucketed histogram of durations in microseconds in the style of an HDR histogram.
+ * Every power of two range is split into 8 linear sub-buckets, so a value is known to
+ * within 12.5% from 16 us up to 16 s, below 16 us exactly. Recording is a few relaxed
+ * atomic operations without a loop over the buckets, so it can be used from any thread
+ * at any rate.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t SUB_BUCKETS = 8;
+    // Values below this are counted in buckets of 1 us.
+    static constexpr uint64_t LINEAR_RANGE = 2 * SUB_BUCKETS;
+    // Power of two ranges above the linear range, the last bucket also counts all larger values.
+    static constexpr size_t RANGES = 20;
+    static constexpr size_t BUCKETS = LINEAR_RANGE + RANGES * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    /**
+     * Counts a single duration.
+     */
+    void Record(uint64_t microseconds);
+
+    /**
+     * Counts a single duration given in seconds. Negative durations count as 0.
+     */
+    void RecordSeconds(double seconds);
+
+    /**
+     * Returns the count of the given bucket.
+     */
+    uint64_t GetCount(size_t bucket) const;
+
+    /**
+     * Returns the number of recorded values.
+     */
+    uint64_t GetTotalCount() const;
+
+    /**
+     * Returns the largest recorded value.
+     */
+    uint64_t GetMax() const;
+
+    /**
+     * Returns the largest value of the bucket holding the given quantile (0 to 1), i.e.
+     * an upper estimate within the bucket resolution. Returns 0 if the histogram is empty.
+     */
+    uint64_t GetPercentile(double quantile) const;
+
+    /**
+     * Returns the bucket counting the given value.
+     */
+    static size_t GetBucket(uint64_t microseconds);
+
+    /**
+     * Returns the smallest value counted by the given bucket in microseconds.
+     */
+    static uint64_t GetLowerBound(size_t bucket);
+
+    /**
+     * Returns the exclusive upper bound of the given bucket in microseconds.
+     */
+    static uint64_t GetUpperBound(size_t bucket);
+
+    /**
+     * Sets all buckets back to 0.
+     */
+    void Reset();
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_;
+    std::atomic<uint64_t> total_count_;
+    std::atomic<uint64_t> max_;
+};
+
+/**
+ * Counters of the capture thread. Written by the capture thread only, read by anyone.
+ */
+struct CaptureStatistics
+{
+    std::atomic<uint64_t> samples{ 0 };
+    std::atomic<uint64_t> read_errors{ 0 };
+    std::atomic<uint64_t> reconnects{ 0 };
+    std::atomic<uint64_t> removed_spikes{ 0 };
+    // Returns of the blocking serial reads, i.e. how often the capture thread woke up.
+    std::atomic<uint64_t> wakeups{ 0 };
+
+    // Time from the arrival of the first byte of a line until its line end, i.e. the
+    // transfer of the line over the serial connection.
+    LatencyHistogram line_latency;
+    // Time from the line end until the sample was published, i.e. parsing and the
+    // signal pipeline.
+    LatencyHistogram processing_latency;
+
+    /**
+     * Sets all counters and histograms back to 0.
+     */
+    void Reset();
+};
+
+/**
+ * Counters of the frame and publishing path of the driver.
+ */
+struct DriverStatistics
+{
+    std::atomic<uint64_t> frames{ 0 };
+    std::atomic<uint64_t> input_updates{ 0 };
+    std::atomic<uint64_t> consumed_samples{ 0 };
+    // Returns of the sample waits of the publisher thread.
+    std::atomic<uint64_t> publisher_wakeups{ 0 };
+
+    // Time from the publication of a sample on the capture thread until the driver
+    // mapped it onto the input components.
+    LatencyHistogram sample_latency;
+    // Time from the arrival of the first byte of a line until the driver mapped the
+    // sample onto the input components.
+    LatencyHistogram total_latency;
+
+    /**
+     * Sets all counters and histograms back to 0.
+     */
+    void Reset();
+};
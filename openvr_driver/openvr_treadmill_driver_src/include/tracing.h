@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * The traced events. Every id has a name in the written trace.
+ */
+enum class TraceEventId : uint16_t
+{
+    SERIAL_READ,
+    PARSE,
+    PIPELINE,
+    PUBLISH,
+    STANDBY,
+    RECONNECT,
+    FIND_PORT,
+    OPEN_PORT,
+    RUN_FRAME,
+    PUBLISH_INPUTS,
+    COUNT
+};
+
+/**
+ * The event types, named after the phase letters of the Chrome trace format.
+ */
+enum class TracePhase : uint8_t
+{
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+};
+
+/**
+ * A timeline of what the capture, frame and publisher threads did, for stutter that
+ * averages and histograms cannot explain.
+ *
+ * Every thread records into its own ring buffer of fixed size binary events, so
+ * recording never waits for another thread and never allocates after the first event
+ * of a thread. Old events are overwritten. The buffer of a finished thread keeps its
+ * events until a new thread takes it over, so that threads restarted on reconnects do
+ * not add a buffer each time. Tracing is switched on and off at runtime,
+ * while it is off an event costs a single load and a well predicted branch. The buffers
+ * are converted to the Chrome trace JSON format on request, which chrome://tracing and
+ * Perfetto open.
+ */
+class Tracer
+{
+public:
+    // Events kept per thread, about 20 seconds of the capture thread at full rate.
+    static constexpr size_t EVENTS_PER_THREAD = 16384;
+
+    // Buffers of 256 KB that exist at most. Further threads running at the same time
+    // record nothing.
+    static constexpr size_t MAX_THREADS = 16;
+
+    /**
+     * Starts recording. Events recorded before are not written anymore.
+     */
+    static void Start();
+
+    /**
+     * Stops recording. The recorded events stay available for WriteChromeTrace().
+     */
+    static void Stop();
+
+    static bool IsEnabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Names the calling thread in the written trace. The name must be a string literal
+     * or live as long as the driver.
+     */
+    static void SetThreadName(const char* name);
+
+    /**
+     * Records an event on the calling thread. Use TraceEvent(), which skips the call
+     * while tracing is off.
+     */
+    static void Record(TraceEventId id, TracePhase phase, uint32_t argument);
+
+    /**
+     * Writes the events of all threads since the last Start() as a Chrome trace JSON
+     * file. Can be called while the threads keep recording. Returns false if the file
+     * could not be written.
+     */
+    static bool WriteChromeTrace(const std::string& file);
+
+    /**
+     * Returns the number of thread buffers allocated so far.
+     */
+    static size_t GetBufferCount();
+
+private:
+    static inline std::atomic<bool> enabled_{ false };
+};
+
+/**
+ * Records an event if tracing is on.
+ */
+inline void TraceEvent(TraceEventId id, TracePhase phase, uint32_t argument = 0)
+{
+    if (Tracer::IsEnabled())
+        Tracer::Record(id, phase, argument);
+}
+
+/**
+ * Records the begin and end event of a scope.
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(TraceEventId id)
+        : id_(id)
+    {
+        TraceEvent(id, TracePhase::BEGIN);
+    }
+
+    ~TraceScope()
+    {
+        TraceEvent(this->id_, TracePhase::END);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceEventId id_;
+};
@@ -1,10 +1,42 @@
 #pragma once
 
-#include <Windows.h>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <set>
+
+#include "clock.h"
+#include "line_parser.h"
+#include "seqlock.h"
+#include "serial_transport.h"
+#include "session_recorder.h"
+#include "signal_pipeline.h"
+#include "statistics.h"
+
+/**
+ * A published treadmill sample. The sequence number increases with every
+ * published sample, so that consumers can tell a new sample from a repeated one.
+ */
+struct TreadmillSample
+{
+    float value = 0.0f;
+    GaitState gait;
+    uint64_t sequence = 0;
+    // Publication time in seconds on the clock of the capture, the steady clock unless
+    // another one was given.
+    double timestamp = 0.0;
+    // Arrival of the first byte of the line the sample was parsed from and the moment
+    // the sample became visible to the readers, on the same clock. The first byte time
+    // is 0 for the sample of a read error.
+    double first_byte_time = 0.0;
+    double publish_time = 0.0;
+};
 
 /**
  * The main class responsible for connecting to the treadmill load cell
@@ -19,9 +51,44 @@ public:
      * We do not rely on object lifetime here to have more possibilities
      * in the use of the driver.
      */
-    TreadmillCapture() = default;
+    TreadmillCapture();
     ~TreadmillCapture() = default;
 
+    /**
+     * Reads from the given transport instead of the serial port of the platform, e.g.
+     * from a simulated load cell module. All timestamps and waits of the capture use the
+     * given clock, which must outlive the capture.
+     */
+    explicit TreadmillCapture(std::unique_ptr<SerialTransport> transport, Clock& clock = Clock::GetSteadyClock());
+
+    /**
+     * Sets up the signal pipeline the received samples are conditioned with and the
+     * substring of the serial device name the capture connects to. Must be called
+     * before the background capture is started.
+     */
+    void Configure(const SignalPipelineSettings& settings, const std::string& port_match);
+
+    /**
+     * Calls the given function on the capture thread with every published sample, e.g.
+     * to check a replay on simulated time sample by sample. Must be set before the
+     * background capture is started.
+     */
+    void SetSampleListener(std::function<void(const TreadmillSample&)> listener);
+
+    /**
+     * Records every raw sample with its timestamps and the connection, standby and
+     * calibration events into the given session log, see SessionRecorder. The metadata
+     * lines are stored in the header next to the pipeline settings. Must be called
+     * before the background capture is started, the recording ends when it is stopped.
+     * Returns false if the log cannot be created.
+     */
+    bool StartRecording(const std::string& file, const std::string& metadata);
+
+    /**
+     * Returns true if the session is recorded.
+     */
+    bool isRecording();
+
     /**
      * Sets up the serial connection by actively seraching for the correct device
      * and starts the whole background capture thread.
@@ -34,11 +101,66 @@ public:
     void StopBackgroundCapture();
 
     /**
-     * Returns the last read treadmill value. Only thing it does is holding a very
-     * brief lock, so that it keeps to be as cheap as possible.
+     * Returns the last read treadmill value. Never takes a lock, so that it keeps
+     * to be as cheap as possible and never blocks the frame of any device.
      */
     float GetTreadmillValue();
+
+    /**
+     * Returns the last published sample including its gait state and sequence
+     * number. Lock free like GetTreadmillValue().
+     */
+    TreadmillSample GetTreadmillSample();
+
+    /**
+     * Blocks until a sample with a sequence number other than the given one was
+     * published, the timeout elapsed or the capture was stopped. Returns true and
+     * writes the sample if a new one arrived.
+     */
+    bool WaitForSample(uint64_t last_sequence, std::chrono::milliseconds timeout, TreadmillSample& sample);
     
+    /**
+     * Requests a calibration session of the normalization bounds. The session runs on
+     * the capture thread and ends after enough walking and running samples.
+     */
+    void StartCalibration();
+
+    /**
+     * Returns true exactly once after a calibration session finished and writes the
+     * new profile, which is already in use, into the given one.
+     */
+    bool TakeCalibrationResult(CalibrationProfile& profile);
+
+    /**
+     * Returns the calibration profile in use, the configured one or the result of the
+     * last calibration session.
+     */
+    CalibrationProfile GetCalibration();
+
+    /**
+     * Writes the normalization bounds suggested from all samples seen so far into the
+     * given profile. Returns false if there were not enough samples yet.
+     */
+    bool GetCalibrationSuggestion(CalibrationProfile& profile);
+
+    /**
+     * Switches between full rate streaming and the standby mode, in which the load
+     * cell module only sends a heartbeat and the capture thread blocks in long reads.
+     * Leaving the standby interrupts the pending read, so that full rate streaming
+     * resumes with the next sample of the module.
+     */
+    void SetStandby(bool standby);
+
+    /**
+     * Returns true if the standby mode is requested.
+     */
+    bool isStandby();
+
+    /**
+     * Returns the counters of the capture thread.
+     */
+    CaptureStatistics& GetStatistics();
+
     /**
      * Returns true if the background thread is currently active.
      */
@@ -51,38 +173,85 @@ public:
     bool isConnected();
 
 private:
-    HANDLE serial_handle_ = INVALID_HANDLE_VALUE;
-    std::wstring com_port_ = L"";
-    DWORD errors_;
-    COMSTAT status_;
+    std::unique_ptr<SerialTransport> transport_;
+    Clock& clock_;
+    std::string com_port_ = "";
 
     std::thread update_loop_thread_;
     std::mutex serial_lock_;
     std::mutex value_lock_;
+    std::mutex wait_lock_;
+    std::condition_variable sample_published_;
 
-    bool active_ = false;
+    std::atomic<bool> active_{ false };
     bool is_connected_ = false;
-    char buffer_[256] = { 0 };
-    float treadmill_value_ = 0.0f;
+    // The bytes of the last read not yet fed into the line parser and their arrival time.
+    char receive_buffer_[64] = { 0 };
+    size_t receive_position_ = 0;
+    size_t receive_length_ = 0;
+    double receive_time_ = 0.0;
+    LineParser line_parser_;
+    // Arrival times of the first byte and the line end of the last line read.
+    double line_start_time_ = 0.0;
+    double line_end_time_ = 0.0;
+    bool line_binary_ = false;
+    std::string port_match_ = "Arduino";
+
+    // Written by the capture thread only. Readers on the frame and publisher threads
+    // never wait for it.
+    Seqlock<TreadmillSample> sample_;
+    uint64_t sequence_ = 0;
+    std::function<void(const TreadmillSample&)> sample_listener_;
+    // Read errors since the last line, a reconnect follows after too many of them.
+    int consecutive_errors_ = 0;
+
+    // The ports opened by any capture, so that several devices matching the same name
+    // do not try to open each other's port.
+    static std::mutex claimed_ports_lock_;
+    static std::set<std::string> claimed_ports_;
+
+    SignalPipeline pipeline_;
+    CaptureStatistics statistics_;
+    // Written by the capture thread only, or by any thread while it does not run.
+    SessionRecorder recorder_;
+
+    std::atomic<bool> standby_requested_{ false };
+    bool standby_applied_ = false;
+
+    std::atomic<bool> calibration_requested_{ false };
+    std::atomic<bool> has_calibration_result_{ false };
+    CalibrationProfile calibration_result_;
+    CalibrationProfile calibration_;
+    CalibrationProfile calibration_suggestion_;
+    bool has_calibration_suggestion_ = false;
 
     /**
      * Returns the com port id string of the first connected USB serial device
-     * which contains the given substring in its device name.
+     * which contains the given substring in its device name and is not opened
+     * by another capture.
      * The names of all currently connected devices can be listed on Windows with
      * the powershell command:
      *      Get-CimInstance Win32_SerialPort | Select-Object Name, DeviceID, Description
+     * and on Linux with:
+     *      ls /dev/serial/by-id
      */
-    std::wstring FindSerialPort(std::wstring device_substring);
+    std::string FindSerialPort(const std::string& device_substring);
 
     /**
-     * Extracts the port id of a full com port name string. Used in FindSerialPort.
+     * Opens a serial connection to the given com port with the given baud rate.
      */
-    static std::wstring ExtractSerialPortFromName(std::wstring serial_name);
+    int OpenDevice(const std::string& com_port, uint32_t baud_rate);
 
     /**
-     * Opens a serial connection to the given com port with the given baud rate.
+     * Restarts the load cell module and discards everything it sent before.
+     */
+    void ResetDevice();
+
+    /**
+     * Sends the rate command of the given mode to the load cell module and adapts
+     * the read timeouts to its output rate.
      */
-    int OpenDevice(std::wstring com_port, DWORD baud_rate);
+    int ApplyStandby(bool standby);
 
     /**
      * Starts the update loop thread.
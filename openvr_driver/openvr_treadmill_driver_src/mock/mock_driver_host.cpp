@@ -0,0 +1,829 @@
+#include "mock_driver_host.h"
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+/**
+ * Returns the current time in seconds on the steady clock.
+ */
+static double GetSteadyTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * The driver manager only has to exist, the driver never calls it.
+ */
+class MockDriverManager : public vr::IVRDriverManager
+{
+public:
+    uint32_t GetDriverCount() const override { return 1; }
+    uint32_t GetDriverName(vr::DriverId_t, char* pchValue, uint32_t unBufferSize) override
+    {
+        return static_cast<uint32_t>(snprintf(pchValue, unBufferSize, "CustomTreadmill")) + 1;
+    }
+    vr::DriverHandle_t GetDriverHandle(const char*) override { return 1; }
+    bool IsEnabled(vr::DriverId_t) const override { return true; }
+};
+
+static MockDriverManager mock_driver_manager;
+
+/**
+ * Reads the JSON of a .vrsettings file: an object of sections, which are objects of
+ * bool, number and string values. Nothing else occurs in settings files.
+ */
+class SettingsReader
+{
+public:
+    explicit SettingsReader(const std::string& text)
+        : text_(text)
+    {
+    }
+
+    /**
+     * Calls the given function with every value. Returns false on a syntax error.
+     */
+    template <typename Function>
+    bool Read(Function store)
+    {
+        if (!this->Accept('{'))
+            return false;
+        if (this->Accept('}'))
+            return true;
+        do
+        {
+            std::string section;
+            if (!this->ReadString(section) || !this->Accept(':') || !this->Accept('{'))
+                return false;
+            if (this->Accept('}'))
+                continue;
+            do
+            {
+                std::string key;
+                if (!this->ReadString(key) || !this->Accept(':'))
+                    return false;
+                if (!this->ReadValue(section, key, store))
+                    return false;
+            } while (this->Accept(','));
+            if (!this->Accept('}'))
+                return false;
+        } while (this->Accept(','));
+        return this->Accept('}');
+    }
+
+private:
+    const std::string& text_;
+    size_t position_ = 0;
+
+    void SkipSpace()
+    {
+        while (this->position_ < this->text_.size() && std::isspace(static_cast<unsigned char>(this->text_[this->position_])))
+            this->position_++;
+    }
+
+    bool Accept(char ch)
+    {
+        this->SkipSpace();
+        if (this->position_ < this->text_.size() && this->text_[this->position_] == ch)
+        {
+            this->position_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ReadString(std::string& value)
+    {
+        if (!this->Accept('"'))
+            return false;
+        value.clear();
+        while (this->position_ < this->text_.size())
+        {
+            char ch = this->text_[this->position_++];
+            if (ch == '"')
+                return true;
+            if (ch == '\\' && this->position_ < this->text_.size())
+                ch = this->text_[this->position_++];
+            value += ch;
+        }
+        return false;
+    }
+
+    template <typename Function>
+    bool ReadValue(const std::string& section, const std::string& key, Function& store)
+    {
+        this->SkipSpace();
+        if (this->text_.compare(this->position_, 4, "true") == 0 || this->text_.compare(this->position_, 5, "false") == 0)
+        {
+            bool value = this->text_[this->position_] == 't';
+            this->position_ += value ? 4 : 5;
+            store(section, key, value);
+            return true;
+        }
+        if (this->position_ < this->text_.size() && this->text_[this->position_] == '"')
+        {
+            std::string value;
+            if (!this->ReadString(value))
+                return false;
+            store(section, key, value);
+            return true;
+        }
+
+        const char* start = this->text_.c_str() + this->position_;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start)
+            return false;
+        this->position_ += static_cast<size_t>(end - start);
+        store(section, key, value);
+        return true;
+    }
+};
+
+MockDriverHost::MockDriverHost()
+{
+    // The HMD and the devices share the index space, the HMD comes first.
+    this->devices_.emplace_back();
+    this->devices_[0].device_class = vr::TrackedDeviceClass_HMD;
+    this->SetHmdPose(0.0f, 0.0f, 1.7f, 0.0f);
+
+    // Minutes of input updates fit without growing, so that the recording does not show
+    // up in the allocation counts of benchmarks.
+    this->input_updates_.reserve(1 << 16);
+}
+
+MockDriverHost::~MockDriverHost()
+{
+    vr::CleanupDriverContext();
+}
+
+bool MockDriverHost::LoadSettings(const std::string& file)
+{
+    std::ifstream input(file);
+    if (!input)
+        return false;
+    std::stringstream text;
+    text << input.rdbuf();
+    std::string content = text.str();
+
+    SettingsReader reader(content);
+    return reader.Read([this](const std::string& section, const std::string& key, auto value) {
+        using Type = decltype(value);
+        SettingValue setting;
+        if constexpr (std::is_same<Type, bool>::value)
+        {
+            setting.type = SettingValue::Type::BOOL;
+            setting.number = value ? 1.0 : 0.0;
+        }
+        else if constexpr (std::is_same<Type, double>::value)
+        {
+            setting.type = SettingValue::Type::NUMBER;
+            setting.number = value;
+        }
+        else
+        {
+            setting.type = SettingValue::Type::STRING;
+            setting.text = value;
+        }
+        this->StoreSetting(section, key, setting);
+    });
+}
+
+void MockDriverHost::SetBoolSetting(const std::string& section, const std::string& key, bool value)
+{
+    SettingValue setting;
+    setting.type = SettingValue::Type::BOOL;
+    setting.number = value ? 1.0 : 0.0;
+    this->StoreSetting(section, key, setting);
+}
+
+void MockDriverHost::SetIntSetting(const std::string& section, const std::string& key, int32_t value)
+{
+    SettingValue setting;
+    setting.number = value;
+    this->StoreSetting(section, key, setting);
+}
+
+void MockDriverHost::SetFloatSetting(const std::string& section, const std::string& key, float value)
+{
+    SettingValue setting;
+    setting.number = value;
+    this->StoreSetting(section, key, setting);
+}
+
+void MockDriverHost::SetStringSetting(const std::string& section, const std::string& key, const std::string& value)
+{
+    SettingValue setting;
+    setting.type = SettingValue::Type::STRING;
+    setting.text = value;
+    this->StoreSetting(section, key, setting);
+}
+
+void MockDriverHost::StoreSetting(const std::string& section, const std::string& key, const SettingValue& value)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->settings_[section][key] = value;
+}
+
+void MockDriverHost::SetHmdPose(float yaw, float x, float y, float z, bool valid)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+
+    // A rotation about the vertical axis. Turning right is a negative rotation.
+    float c = std::cos(-yaw);
+    float s = std::sin(-yaw);
+    vr::HmdMatrix34_t& m = this->hmd_pose_.mDeviceToAbsoluteTracking;
+    m.m[0][0] = c;    m.m[0][1] = 0.0f; m.m[0][2] = s;    m.m[0][3] = x;
+    m.m[1][0] = 0.0f; m.m[1][1] = 1.0f; m.m[1][2] = 0.0f; m.m[1][3] = y;
+    m.m[2][0] = -s;   m.m[2][1] = 0.0f; m.m[2][2] = c;    m.m[2][3] = z;
+    this->hmd_pose_.bPoseIsValid = valid;
+    this->hmd_pose_.bDeviceIsConnected = true;
+    this->hmd_pose_.eTrackingResult = valid ? vr::TrackingResult_Running_OK : vr::TrackingResult_Running_OutOfRange;
+}
+
+void MockDriverHost::SetHmdVelocity(float x, float y, float z)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->hmd_pose_.vVelocity.v[0] = x;
+    this->hmd_pose_.vVelocity.v[1] = y;
+    this->hmd_pose_.vVelocity.v[2] = z;
+}
+
+void MockDriverHost::SetEcho(bool echo)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->echo_ = echo;
+}
+
+void MockDriverHost::SetRecording(bool recording)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->recording_ = recording;
+}
+
+void MockDriverHost::ClearRecording()
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->calls_.clear();
+    this->input_updates_.clear();
+    this->input_update_count_ = 0;
+    this->pose_update_count_ = 0;
+    this->frame_cost_.Reset();
+    this->frame_count_ = 0;
+}
+
+void MockDriverHost::RunFrames(vr::IServerTrackedDeviceProvider& provider, double refresh_rate, size_t frames)
+{
+    std::chrono::steady_clock::time_point next_frame = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration frame_interval = refresh_rate > 0.0
+        ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / refresh_rate))
+        : std::chrono::steady_clock::duration::zero();
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        if (refresh_rate > 0.0)
+        {
+            std::this_thread::sleep_until(next_frame);
+            next_frame += frame_interval;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        provider.RunFrame();
+        std::chrono::steady_clock::duration cost = std::chrono::steady_clock::now() - start;
+
+        // Only this thread writes the frame statistics, the histogram is atomic anyway.
+        this->frame_cost_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(cost).count()));
+        std::lock_guard<std::mutex> lock(this->lock_);
+        this->frame_count_++;
+    }
+}
+
+const LatencyHistogram& MockDriverHost::GetFrameCost() const
+{
+    return this->frame_cost_;
+}
+
+size_t MockDriverHost::GetFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->frame_count_;
+}
+
+std::vector<MockCall> MockDriverHost::GetCalls() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->calls_;
+}
+
+std::vector<MockCall> MockDriverHost::GetCalls(MockCallType type) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    std::vector<MockCall> calls;
+    for (const MockCall& call : this->calls_)
+    {
+        if (call.type == type)
+            calls.push_back(call);
+    }
+    return calls;
+}
+
+std::vector<MockInputUpdate> MockDriverHost::GetInputUpdates() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->input_updates_;
+}
+
+std::vector<MockInputUpdate> MockDriverHost::GetInputUpdates(vr::VRInputComponentHandle_t component) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    std::vector<MockInputUpdate> updates;
+    for (const MockInputUpdate& update : this->input_updates_)
+    {
+        if (update.component == component)
+            updates.push_back(update);
+    }
+    return updates;
+}
+
+size_t MockDriverHost::GetInputUpdateCount() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->input_update_count_;
+}
+
+size_t MockDriverHost::GetPoseUpdateCount() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->pose_update_count_;
+}
+
+uint32_t MockDriverHost::GetDeviceCount() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return static_cast<uint32_t>(this->devices_.size() - 1);
+}
+
+vr::ITrackedDeviceServerDriver* MockDriverHost::GetDevice(vr::TrackedDeviceIndex_t index) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return index < this->devices_.size() ? this->devices_[index].driver : nullptr;
+}
+
+vr::TrackedDeviceIndex_t MockDriverHost::FindDevice(const std::string& serial_number) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    for (size_t i = 1; i < this->devices_.size(); i++)
+    {
+        if (this->devices_[i].serial_number == serial_number)
+            return static_cast<vr::TrackedDeviceIndex_t>(i);
+    }
+    return vr::k_unTrackedDeviceIndexInvalid;
+}
+
+vr::VRInputComponentHandle_t MockDriverHost::FindComponent(vr::TrackedDeviceIndex_t index, const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    for (size_t i = 0; i < this->components_.size(); i++)
+    {
+        if (this->components_[i].container == index && this->components_[i].path == path)
+            return static_cast<vr::VRInputComponentHandle_t>(i + 1);
+    }
+    return vr::k_ulInvalidInputComponentHandle;
+}
+
+std::string MockDriverHost::GetComponentPath(vr::VRInputComponentHandle_t component) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    if (component == vr::k_ulInvalidInputComponentHandle || component > this->components_.size())
+        return "";
+    return this->components_[component - 1].path;
+}
+
+std::string MockDriverHost::GetPropertyData(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty property) const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    if (index >= this->devices_.size())
+        return "";
+    auto found = this->devices_[index].properties.find(property);
+    return found != this->devices_[index].properties.end() ? found->second : "";
+}
+
+std::string MockDriverHost::GetStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty property) const
+{
+    // The driver writes strings with their terminating null.
+    std::string data = this->GetPropertyData(index, property);
+    return std::string(data.c_str());
+}
+
+int32_t MockDriverHost::GetInt32Property(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty property) const
+{
+    std::string data = this->GetPropertyData(index, property);
+    int32_t value = 0;
+    if (data.size() == sizeof(value))
+        std::memcpy(&value, data.data(), sizeof(value));
+    return value;
+}
+
+void MockDriverHost::Record(MockCallType type, uint64_t handle, const std::string& text)
+{
+    if (this->echo_)
+        printf("[mock host] %d %llu %s\n", static_cast<int>(type), static_cast<unsigned long long>(handle), text.c_str());
+    if (!this->recording_)
+        return;
+
+    MockCall call;
+    call.type = type;
+    call.time = GetSteadyTime();
+    call.handle = handle;
+    call.text = text;
+    this->calls_.push_back(std::move(call));
+}
+
+vr::EVRInputError MockDriverHost::RecordInputUpdate(vr::VRInputComponentHandle_t component, float value, double time_offset, bool is_boolean)
+{
+    double time = GetSteadyTime();
+    std::lock_guard<std::mutex> lock(this->lock_);
+    if (component == vr::k_ulInvalidInputComponentHandle || component > this->components_.size())
+        return vr::VRInputError_InvalidHandle;
+
+    this->input_update_count_++;
+    if (this->recording_)
+    {
+        MockInputUpdate update;
+        update.time = time;
+        update.component = component;
+        update.value = value;
+        update.time_offset = time_offset;
+        update.is_boolean = is_boolean;
+        this->input_updates_.push_back(update);
+    }
+    return vr::VRInputError_None;
+}
+
+const MockDriverHost::SettingValue* MockDriverHost::FindSetting(const char* section, const char* key, vr::EVRSettingsError* error) const
+{
+    const SettingValue* value = nullptr;
+    auto found_section = this->settings_.find(section);
+    if (found_section != this->settings_.end())
+    {
+        auto found_key = found_section->second.find(key);
+        if (found_key != found_section->second.end())
+            value = &found_key->second;
+    }
+
+    if (error != nullptr)
+        *error = value != nullptr ? vr::VRSettingsError_None : vr::VRSettingsError_UnsetSettingHasNoDefault;
+    return value;
+}
+
+MockDriverHost::Device* MockDriverHost::FindContainer(vr::PropertyContainerHandle_t container)
+{
+    // The container of a device is its index.
+    if (container == vr::k_ulInvalidPropertyContainer || container >= this->devices_.size())
+        return nullptr;
+    return &this->devices_[static_cast<size_t>(container)];
+}
+
+vr::VRInputComponentHandle_t MockDriverHost::AddComponent(vr::PropertyContainerHandle_t container, const char* path, vr::VRInputComponentHandle_t* handle)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    Component component;
+    component.container = container;
+    component.path = path != nullptr ? path : "";
+    this->components_.push_back(component);
+    *handle = static_cast<vr::VRInputComponentHandle_t>(this->components_.size());
+    this->Record(MockCallType::COMPONENT_CREATED, *handle, component.path);
+    return *handle;
+}
+
+void* MockDriverHost::GetGenericInterface(const char* pchInterfaceVersion, vr::EVRInitError* peError)
+{
+    void* result = nullptr;
+    if (std::strcmp(pchInterfaceVersion, vr::IVRSettings_Version) == 0)
+        result = static_cast<vr::IVRSettings*>(this);
+    else if (std::strcmp(pchInterfaceVersion, vr::IVRProperties_Version) == 0)
+        result = static_cast<vr::IVRProperties*>(this);
+    else if (std::strcmp(pchInterfaceVersion, vr::IVRDriverInput_Version) == 0)
+        result = static_cast<vr::IVRDriverInput*>(this);
+    else if (std::strcmp(pchInterfaceVersion, vr::IVRDriverLog_Version) == 0)
+        result = static_cast<vr::IVRDriverLog*>(this);
+    else if (std::strcmp(pchInterfaceVersion, vr::IVRServerDriverHost_Version) == 0)
+        result = static_cast<vr::IVRServerDriverHost*>(this);
+    else if (std::strcmp(pchInterfaceVersion, vr::IVRResources_Version) == 0)
+        result = static_cast<vr::IVRResources*>(this);
+    else if (std::strcmp(pchInterfaceVersion, vr::IVRDriverManager_Version) == 0)
+        result = static_cast<vr::IVRDriverManager*>(&mock_driver_manager);
+
+    if (peError != nullptr)
+        *peError = result != nullptr ? vr::VRInitError_None : vr::VRInitError_Init_InterfaceNotFound;
+    return result;
+}
+
+vr::DriverHandle_t MockDriverHost::GetDriverHandle()
+{
+    return 1;
+}
+
+const char* MockDriverHost::GetSettingsErrorNameFromEnum(vr::EVRSettingsError eError)
+{
+    return eError == vr::VRSettingsError_None ? "None" : "UnsetSettingHasNoDefault";
+}
+
+void MockDriverHost::SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, vr::EVRSettingsError* peError)
+{
+    this->SetBoolSetting(pchSection, pchSettingsKey, bValue);
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->Record(MockCallType::SETTING_WRITTEN, 0, std::string(pchSection) + "/" + pchSettingsKey + "=" + (bValue ? "true" : "false"));
+    if (peError != nullptr)
+        *peError = vr::VRSettingsError_None;
+}
+
+void MockDriverHost::SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, vr::EVRSettingsError* peError)
+{
+    this->SetIntSetting(pchSection, pchSettingsKey, nValue);
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->Record(MockCallType::SETTING_WRITTEN, 0, std::string(pchSection) + "/" + pchSettingsKey + "=" + std::to_string(nValue));
+    if (peError != nullptr)
+        *peError = vr::VRSettingsError_None;
+}
+
+void MockDriverHost::SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, vr::EVRSettingsError* peError)
+{
+    this->SetFloatSetting(pchSection, pchSettingsKey, flValue);
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->Record(MockCallType::SETTING_WRITTEN, 0, std::string(pchSection) + "/" + pchSettingsKey + "=" + std::to_string(flValue));
+    if (peError != nullptr)
+        *peError = vr::VRSettingsError_None;
+}
+
+void MockDriverHost::SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, vr::EVRSettingsError* peError)
+{
+    this->SetStringSetting(pchSection, pchSettingsKey, pchValue);
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->Record(MockCallType::SETTING_WRITTEN, 0, std::string(pchSection) + "/" + pchSettingsKey + "=" + pchValue);
+    if (peError != nullptr)
+        *peError = vr::VRSettingsError_None;
+}
+
+bool MockDriverHost::GetBool(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    const SettingValue* value = this->FindSetting(pchSection, pchSettingsKey, peError);
+    return value != nullptr && value->type != SettingValue::Type::STRING && value->number != 0.0;
+}
+
+int32_t MockDriverHost::GetInt32(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    const SettingValue* value = this->FindSetting(pchSection, pchSettingsKey, peError);
+    return value != nullptr && value->type != SettingValue::Type::STRING ? static_cast<int32_t>(value->number) : 0;
+}
+
+float MockDriverHost::GetFloat(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    const SettingValue* value = this->FindSetting(pchSection, pchSettingsKey, peError);
+    return value != nullptr && value->type != SettingValue::Type::STRING ? static_cast<float>(value->number) : 0.0f;
+}
+
+void MockDriverHost::GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, vr::EVRSettingsError* peError)
+{
+    if (unValueLen == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(this->lock_);
+    const SettingValue* value = this->FindSetting(pchSection, pchSettingsKey, peError);
+    snprintf(pchValue, unValueLen, "%s", value != nullptr && value->type == SettingValue::Type::STRING ? value->text.c_str() : "");
+}
+
+void MockDriverHost::RemoveSection(const char* pchSection, vr::EVRSettingsError* peError)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->settings_.erase(pchSection);
+    if (peError != nullptr)
+        *peError = vr::VRSettingsError_None;
+}
+
+void MockDriverHost::RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    auto found = this->settings_.find(pchSection);
+    if (found != this->settings_.end())
+        found->second.erase(pchSettingsKey);
+    if (peError != nullptr)
+        *peError = vr::VRSettingsError_None;
+}
+
+vr::ETrackedPropertyError MockDriverHost::ReadPropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyRead_t* pBatch, uint32_t unBatchEntryCount)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    Device* device = this->FindContainer(ulContainerHandle);
+    if (device == nullptr)
+        return vr::TrackedProp_InvalidContainer;
+
+    for (uint32_t i = 0; i < unBatchEntryCount; i++)
+    {
+        vr::PropertyRead_t& read = pBatch[i];
+        auto found = device->properties.find(read.prop);
+        if (found == device->properties.end())
+        {
+            read.eError = vr::TrackedProp_UnknownProperty;
+            continue;
+        }
+
+        read.unRequiredBufferSize = static_cast<uint32_t>(found->second.size());
+        if (read.unBufferSize < found->second.size())
+        {
+            read.eError = vr::TrackedProp_BufferTooSmall;
+            continue;
+        }
+        std::memcpy(read.pvBuffer, found->second.data(), found->second.size());
+        read.eError = vr::TrackedProp_Success;
+    }
+    return vr::TrackedProp_Success;
+}
+
+vr::ETrackedPropertyError MockDriverHost::WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t* pBatch, uint32_t unBatchEntryCount)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    Device* device = this->FindContainer(ulContainerHandle);
+    if (device == nullptr)
+        return vr::TrackedProp_InvalidContainer;
+
+    for (uint32_t i = 0; i < unBatchEntryCount; i++)
+    {
+        vr::PropertyWrite_t& write = pBatch[i];
+        if (write.writeType == vr::PropertyWrite_Set)
+            device->properties[write.prop] = std::string(static_cast<const char*>(write.pvBuffer), write.unBufferSize);
+        else
+            device->properties.erase(write.prop);
+        write.eError = vr::TrackedProp_Success;
+        write.eSetError = vr::TrackedProp_Success;
+        this->Record(MockCallType::PROPERTY_WRITTEN, write.prop, write.writeType == vr::PropertyWrite_Set
+            ? std::string(static_cast<const char*>(write.pvBuffer), write.unBufferSize) : std::string());
+    }
+    return vr::TrackedProp_Success;
+}
+
+const char* MockDriverHost::GetPropErrorNameFromEnum(vr::ETrackedPropertyError error)
+{
+    return error == vr::TrackedProp_Success ? "Success" : "Error";
+}
+
+vr::PropertyContainerHandle_t MockDriverHost::TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return nDevice < this->devices_.size() ? static_cast<vr::PropertyContainerHandle_t>(nDevice) : vr::k_ulInvalidPropertyContainer;
+}
+
+vr::EVRInputError MockDriverHost::CreateBooleanComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle)
+{
+    this->AddComponent(ulContainer, pchName, pHandle);
+    return vr::VRInputError_None;
+}
+
+vr::EVRInputError MockDriverHost::UpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset)
+{
+    return this->RecordInputUpdate(ulComponent, bNewValue ? 1.0f : 0.0f, fTimeOffset, true);
+}
+
+vr::EVRInputError MockDriverHost::CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle, vr::EVRScalarType, vr::EVRScalarUnits)
+{
+    this->AddComponent(ulContainer, pchName, pHandle);
+    return vr::VRInputError_None;
+}
+
+vr::EVRInputError MockDriverHost::UpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset)
+{
+    return this->RecordInputUpdate(ulComponent, fNewValue, fTimeOffset, false);
+}
+
+vr::EVRInputError MockDriverHost::CreateHapticComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle)
+{
+    this->AddComponent(ulContainer, pchName, pHandle);
+    return vr::VRInputError_None;
+}
+
+vr::EVRInputError MockDriverHost::CreateSkeletonComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, const char*, const char*, vr::EVRSkeletalTrackingLevel, const vr::VRBoneTransform_t*, uint32_t, vr::VRInputComponentHandle_t* pHandle)
+{
+    this->AddComponent(ulContainer, pchName, pHandle);
+    return vr::VRInputError_None;
+}
+
+vr::EVRInputError MockDriverHost::UpdateSkeletonComponent(vr::VRInputComponentHandle_t ulComponent, vr::EVRSkeletalMotionRange, const vr::VRBoneTransform_t*, uint32_t)
+{
+    return this->RecordInputUpdate(ulComponent, 0.0f, 0.0, false);
+}
+
+void MockDriverHost::Log(const char* pchLogMessage)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->Record(MockCallType::LOG, 0, pchLogMessage != nullptr ? pchLogMessage : "");
+}
+
+bool MockDriverHost::TrackedDeviceAdded(const char* pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass, vr::ITrackedDeviceServerDriver* pDriver)
+{
+    vr::TrackedDeviceIndex_t index;
+    {
+        std::lock_guard<std::mutex> lock(this->lock_);
+        for (const Device& device : this->devices_)
+        {
+            if (device.serial_number == pchDeviceSerialNumber)
+                return false;
+        }
+
+        Device device;
+        device.serial_number = pchDeviceSerialNumber;
+        device.device_class = eDeviceClass;
+        device.driver = pDriver;
+        this->devices_.push_back(device);
+        index = static_cast<vr::TrackedDeviceIndex_t>(this->devices_.size() - 1);
+        this->Record(MockCallType::DEVICE_ADDED, index, pchDeviceSerialNumber);
+    }
+
+    // The driver calls back into the host while it activates, so the lock is released.
+    return pDriver->Activate(index) == vr::VRInitError_None;
+}
+
+void MockDriverHost::TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t)
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->pose_update_count_++;
+    if (this->echo_ || this->recording_)
+    {
+        char text[128];
+        snprintf(text, sizeof(text), "%.3f %.3f %.3f%s", newPose.vecPosition[0], newPose.vecPosition[1], newPose.vecPosition[2],
+            newPose.poseIsValid ? "" : " invalid");
+        this->Record(MockCallType::POSE_UPDATED, unWhichDevice, text);
+    }
+}
+
+void MockDriverHost::VsyncEvent(double)
+{
+}
+
+void MockDriverHost::VendorSpecificEvent(uint32_t, vr::EVREventType, const vr::VREvent_Data_t&, double)
+{
+}
+
+bool MockDriverHost::IsExiting()
+{
+    return false;
+}
+
+bool MockDriverHost::PollNextEvent(vr::VREvent_t*, uint32_t)
+{
+    return false;
+}
+
+void MockDriverHost::GetRawTrackedDevicePoses(float, vr::TrackedDevicePose_t* pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount)
+{
+    if (unTrackedDevicePoseArrayCount < 1)
+        return;
+
+    std::lock_guard<std::mutex> lock(this->lock_);
+    pTrackedDevicePoseArray[0] = this->hmd_pose_;
+    for (uint32_t i = 1; i < unTrackedDevicePoseArrayCount; i++)
+        pTrackedDevicePoseArray[i] = vr::TrackedDevicePose_t();
+}
+
+void MockDriverHost::RequestRestart(const char*, const char*, const char*, const char*)
+{
+}
+
+uint32_t MockDriverHost::GetFrameTimings(vr::Compositor_FrameTiming*, uint32_t)
+{
+    return 0;
+}
+
+void MockDriverHost::SetDisplayEyeToHead(uint32_t, const vr::HmdMatrix34_t&, const vr::HmdMatrix34_t&)
+{
+}
+
+void MockDriverHost::SetDisplayProjectionRaw(uint32_t, const vr::HmdRect2_t&, const vr::HmdRect2_t&)
+{
+}
+
+void MockDriverHost::SetRecommendedRenderTargetSize(uint32_t, uint32_t, uint32_t)
+{
+}
+
+uint32_t MockDriverHost::LoadSharedResource(const char*, char*, uint32_t)
+{
+    return 0;
+}
+
+uint32_t MockDriverHost::GetResourceFullPath(const char*, const char*, char* pchPathBuffer, uint32_t unBufferLen)
+{
+    if (unBufferLen > 0)
+        pchPathBuffer[0] = '\0';
+    return 0;
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "openvr_driver.h"
+#include "statistics.h"
+
+/**
+ * The kinds of calls of the driver into the mock host, apart from the input updates,
+ * which are recorded separately.
+ */
+enum class MockCallType
+{
+    DEVICE_ADDED,
+    POSE_UPDATED,
+    PROPERTY_WRITTEN,
+    COMPONENT_CREATED,
+    SETTING_WRITTEN,
+    LOG
+};
+
+/**
+ * A recorded call. The text is the serial number, component path, settings key or log
+ * message, the handle the device index, property or component handle.
+ */
+struct MockCall
+{
+    MockCallType type;
+    // Seconds on the steady clock, the time base of the driver's samples.
+    double time = 0.0;
+    uint64_t handle = 0;
+    std::string text;
+};
+
+/**
+ * A recorded update of an input component. Boolean updates have the value 0 or 1.
+ */
+struct MockInputUpdate
+{
+    double time = 0.0;
+    vr::VRInputComponentHandle_t component = vr::k_ulInvalidInputComponentHandle;
+    float value = 0.0f;
+    double time_offset = 0.0;
+    bool is_boolean = false;
+};
+
+/**
+ * A stand-in for vrserver, so that the device provider and the device drivers run without
+ * SteamVR, e.g. in benchmarks and tests of the full driver stack.
+ *
+ * It is the driver context handed to MyDeviceProvider::Init() and implements the settings,
+ * properties, driver input, log and server driver host interfaces the driver uses. Every
+ * call is recorded with its time on the steady clock. Settings come from a .vrsettings
+ * file or are set directly. Added devices are activated right away, as vrserver does it
+ * after TrackedDeviceAdded(). The HMD pose returned to the driver is set by the caller.
+ *
+ * The interfaces may be called from any thread of the driver. The driver context is
+ * global to the module, so only one host can be in use at a time.
+ */
+class MockDriverHost
+    : public vr::IVRDriverContext
+    , public vr::IVRSettings
+    , public vr::IVRProperties
+    , public vr::IVRDriverInput
+    , public vr::IVRDriverLog
+    , public vr::IVRServerDriverHost
+    , public vr::IVRResources
+{
+public:
+    MockDriverHost();
+
+    /**
+     * Detaches the driver from the host, so that a later host starts with a fresh context.
+     */
+    ~MockDriverHost();
+
+    MockDriverHost(const MockDriverHost&) = delete;
+    MockDriverHost& operator=(const MockDriverHost&) = delete;
+
+    /**
+     * Reads the settings of a .vrsettings file, e.g. the default settings of the driver,
+     * in addition to the ones already set. Returns false if the file cannot be read or
+     * parsed.
+     */
+    bool LoadSettings(const std::string& file);
+
+    void SetBoolSetting(const std::string& section, const std::string& key, bool value);
+    void SetIntSetting(const std::string& section, const std::string& key, int32_t value);
+    void SetFloatSetting(const std::string& section, const std::string& key, float value);
+    void SetStringSetting(const std::string& section, const std::string& key, const std::string& value);
+
+    /**
+     * Sets the HMD pose handed out by GetRawTrackedDevicePoses(). The HMD turns by the
+     * given yaw about the vertical axis and stands at the given position.
+     */
+    void SetHmdPose(float yaw, float x, float y, float z, bool valid = true);
+
+    /**
+     * Sets the velocity of the HMD pose in meters per second.
+     */
+    void SetHmdVelocity(float x, float y, float z);
+
+    /**
+     * Writes the calls and log messages to stdout as they happen.
+     */
+    void SetEcho(bool echo);
+
+    /**
+     * Switches the recording of the calls and input updates on or off. They are still
+     * counted while it is off, so that benchmarks can measure without the growing
+     * recording.
+     */
+    void SetRecording(bool recording);
+
+    /**
+     * Forgets the recorded calls and input updates, the frame costs and the counters.
+     */
+    void ClearRecording();
+
+    /**
+     * Calls RunFrame() of the provider the given number of times and paces the frames at
+     * the given refresh rate like vrserver does. A refresh rate of 0 runs the frames back
+     * to back. The duration of every RunFrame() is counted in the frame cost histogram.
+     */
+    void RunFrames(vr::IServerTrackedDeviceProvider& provider, double refresh_rate, size_t frames);
+
+    /**
+     * Returns the durations of the frames run so far.
+     */
+    const LatencyHistogram& GetFrameCost() const;
+
+    size_t GetFrameCount() const;
+
+    std::vector<MockCall> GetCalls() const;
+
+    std::vector<MockCall> GetCalls(MockCallType type) const;
+
+    std::vector<MockInputUpdate> GetInputUpdates() const;
+
+    /**
+     * Returns the recorded updates of a single component.
+     */
+    std::vector<MockInputUpdate> GetInputUpdates(vr::VRInputComponentHandle_t component) const;
+
+    /**
+     * Returns the number of input updates, also of the ones made while recording was off.
+     */
+    size_t GetInputUpdateCount() const;
+
+    /**
+     * Returns the number of pose updates, also of the ones made while recording was off.
+     */
+    size_t GetPoseUpdateCount() const;
+
+    /**
+     * Returns the number of added devices. The devices have the indices 1 to the count,
+     * index 0 is the HMD.
+     */
+    uint32_t GetDeviceCount() const;
+
+    /**
+     * Returns the added device with the given index, or null if there is none.
+     */
+    vr::ITrackedDeviceServerDriver* GetDevice(vr::TrackedDeviceIndex_t index) const;
+
+    /**
+     * Returns the index of the device with the given serial number, or
+     * k_unTrackedDeviceIndexInvalid if there is none.
+     */
+    vr::TrackedDeviceIndex_t FindDevice(const std::string& serial_number) const;
+
+    /**
+     * Returns the handle of the component the device created under the given path, e.g.
+     * "/input/trigger/value", or k_ulInvalidInputComponentHandle if there is none.
+     */
+    vr::VRInputComponentHandle_t FindComponent(vr::TrackedDeviceIndex_t index, const std::string& path) const;
+
+    std::string GetComponentPath(vr::VRInputComponentHandle_t component) const;
+
+    /**
+     * Returns the raw bytes the device wrote into the given property, or an empty string.
+     */
+    std::string GetPropertyData(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty property) const;
+
+    std::string GetStringProperty(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty property) const;
+
+    int32_t GetInt32Property(vr::TrackedDeviceIndex_t index, vr::ETrackedDeviceProperty property) const;
+
+    // IVRDriverContext
+    void* GetGenericInterface(const char* pchInterfaceVersion, vr::EVRInitError* peError = nullptr) override;
+    vr::DriverHandle_t GetDriverHandle() override;
+
+    // IVRSettings
+    const char* GetSettingsErrorNameFromEnum(vr::EVRSettingsError eError) override;
+    void SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, vr::EVRSettingsError* peError = nullptr) override;
+    void SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, vr::EVRSettingsError* peError = nullptr) override;
+    void SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, vr::EVRSettingsError* peError = nullptr) override;
+    void SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, vr::EVRSettingsError* peError = nullptr) override;
+    bool GetBool(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+    int32_t GetInt32(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+    float GetFloat(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+    void GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, vr::EVRSettingsError* peError = nullptr) override;
+    void RemoveSection(const char* pchSection, vr::EVRSettingsError* peError = nullptr) override;
+    void RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError = nullptr) override;
+
+    // IVRProperties
+    vr::ETrackedPropertyError ReadPropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyRead_t* pBatch, uint32_t unBatchEntryCount) override;
+    vr::ETrackedPropertyError WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t* pBatch, uint32_t unBatchEntryCount) override;
+    const char* GetPropErrorNameFromEnum(vr::ETrackedPropertyError error) override;
+    vr::PropertyContainerHandle_t TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice) override;
+
+    // IVRDriverInput
+    vr::EVRInputError CreateBooleanComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override;
+    vr::EVRInputError UpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) override;
+    vr::EVRInputError CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle, vr::EVRScalarType eType, vr::EVRScalarUnits eUnits) override;
+    vr::EVRInputError UpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) override;
+    vr::EVRInputError CreateHapticComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override;
+    vr::EVRInputError CreateSkeletonComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, const char* pchSkeletonPath, const char* pchBasePosePath, vr::EVRSkeletalTrackingLevel eSkeletalTrackingLevel, const vr::VRBoneTransform_t* pGripLimitTransforms, uint32_t unGripLimitTransformCount, vr::VRInputComponentHandle_t* pHandle) override;
+    vr::EVRInputError UpdateSkeletonComponent(vr::VRInputComponentHandle_t ulComponent, vr::EVRSkeletalMotionRange eMotionRange, const vr::VRBoneTransform_t* pTransforms, uint32_t unTransformCount) override;
+
+    // IVRDriverLog
+    void Log(const char* pchLogMessage) override;
+
+    // IVRServerDriverHost
+    bool TrackedDeviceAdded(const char* pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass, vr::ITrackedDeviceServerDriver* pDriver) override;
+    void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize) override;
+    void VsyncEvent(double vsyncTimeOffsetSeconds) override;
+    void VendorSpecificEvent(uint32_t unWhichDevice, vr::EVREventType eventType, const vr::VREvent_Data_t& eventData, double eventTimeOffset) override;
+    bool IsExiting() override;
+    bool PollNextEvent(vr::VREvent_t* pEvent, uint32_t uncbVREvent) override;
+    void GetRawTrackedDevicePoses(float fPredictedSecondsFromNow, vr::TrackedDevicePose_t* pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount) override;
+    void RequestRestart(const char* pchLocalizedReason, const char* pchExecutableToStart, const char* pchArguments, const char* pchWorkingDirectory) override;
+    uint32_t GetFrameTimings(vr::Compositor_FrameTiming* pTiming, uint32_t nFrames) override;
+    void SetDisplayEyeToHead(uint32_t unWhichDevice, const vr::HmdMatrix34_t& eyeToHeadLeft, const vr::HmdMatrix34_t& eyeToHeadRight) override;
+    void SetDisplayProjectionRaw(uint32_t unWhichDevice, const vr::HmdRect2_t& eyeLeft, const vr::HmdRect2_t& eyeRight) override;
+    void SetRecommendedRenderTargetSize(uint32_t unWhichDevice, uint32_t nWidth, uint32_t nHeight) override;
+
+    // IVRResources
+    uint32_t LoadSharedResource(const char* pchResourceName, char* pchBuffer, uint32_t unBufferLen) override;
+    uint32_t GetResourceFullPath(const char* pchResourceName, const char* pchResourceTypeDirectory, char* pchPathBuffer, uint32_t unBufferLen) override;
+
+private:
+    /**
+     * A settings value as vrserver keeps it, a JSON bool, number or string.
+     */
+    struct SettingValue
+    {
+        enum class Type { BOOL, NUMBER, STRING } type = Type::NUMBER;
+        double number = 0.0;
+        std::string text;
+    };
+
+    struct Device
+    {
+        std::string serial_number;
+        vr::ETrackedDeviceClass device_class = vr::TrackedDeviceClass_Invalid;
+        vr::ITrackedDeviceServerDriver* driver = nullptr;
+        std::map<vr::ETrackedDeviceProperty, std::string> properties;
+    };
+
+    struct Component
+    {
+        vr::PropertyContainerHandle_t container = vr::k_ulInvalidPropertyContainer;
+        std::string path;
+    };
+
+    mutable std::mutex lock_;
+    std::map<std::string, std::map<std::string, SettingValue>> settings_;
+    // Index 0 is the HMD, which the host only knows the pose of.
+    std::vector<Device> devices_;
+    // Component handles are the index into the list plus 1.
+    std::vector<Component> components_;
+    vr::TrackedDevicePose_t hmd_pose_ = {};
+
+    bool echo_ = false;
+    bool recording_ = true;
+    std::vector<MockCall> calls_;
+    std::vector<MockInputUpdate> input_updates_;
+    size_t input_update_count_ = 0;
+    size_t pose_update_count_ = 0;
+
+    LatencyHistogram frame_cost_;
+    size_t frame_count_ = 0;
+
+    /**
+     * Records a call. Expects the lock to be held.
+     */
+    void Record(MockCallType type, uint64_t handle, const std::string& text);
+
+    /**
+     * Records an input update. Expects the lock to be held.
+     */
+    vr::EVRInputError RecordInputUpdate(vr::VRInputComponentHandle_t component, float value, double time_offset, bool is_boolean);
+
+    /**
+     * Returns the settings value of the given key, or null if it is not set. Expects the
+     * lock to be held.
+     */
+    const SettingValue* FindSetting(const char* section, const char* key, vr::EVRSettingsError* error) const;
+
+    void StoreSetting(const std::string& section, const std::string& key, const SettingValue& value);
+
+    /**
+     * Returns the device of the given property container, or null. Expects the lock to
+     * be held.
+     */
+    Device* FindContainer(vr::PropertyContainerHandle_t container);
+
+    vr::VRInputComponentHandle_t AddComponent(vr::PropertyContainerHandle_t container, const char* path, vr::VRInputComponentHandle_t* handle);
+};
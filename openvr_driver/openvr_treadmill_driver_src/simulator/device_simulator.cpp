@@ -0,0 +1,227 @@
+#include "device_simulator.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Longest wait in a single poll, so that Stop() is noticed in time.
+static const int MAX_POLL_MILLISECONDS = 50;
+
+DeviceSimulator::DeviceSimulator(const SimulatorSettings& settings, std::vector<float> values)
+    : settings_(settings),
+      model_(settings, std::move(values))
+{
+}
+
+DeviceSimulator::~DeviceSimulator()
+{
+    this->Stop();
+}
+
+bool DeviceSimulator::Start()
+{
+    if (this->model_.GetValueCount() == 0 || this->settings_.rate <= 0.0 || !this->OpenTerminal())
+        return false;
+
+    this->running_ = true;
+    this->finished_ = false;
+    this->thread_ = std::thread(&DeviceSimulator::Run, this);
+    return true;
+}
+
+void DeviceSimulator::Stop()
+{
+    this->running_ = false;
+    if (this->thread_.joinable())
+        this->thread_.join();
+    this->CloseTerminal();
+}
+
+bool DeviceSimulator::IsFinished() const
+{
+    return this->finished_;
+}
+
+std::string DeviceSimulator::GetPort() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->settings_.link_path.empty() ? this->terminal_path_ : this->settings_.link_path;
+}
+
+SimulatorStatistics DeviceSimulator::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    return this->model_.GetStatistics();
+}
+
+bool DeviceSimulator::OpenTerminal()
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0)
+        return false;
+    const char* path = nullptr;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || (path = ptsname(master)) == nullptr)
+    {
+        close(master);
+        return false;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    fcntl(master, F_SETFD, FD_CLOEXEC);
+
+    // The terminal starts in canonical mode with echo. Until the capture switches it to
+    // raw mode, the values would come back as commands.
+    termios options = {};
+    if (tcgetattr(master, &options) == 0)
+    {
+        cfmakeraw(&options);
+        tcsetattr(master, TCSANOW, &options);
+    }
+
+    std::lock_guard<std::mutex> lock(this->lock_);
+    this->master_ = master;
+    this->terminal_path_ = path;
+
+    // Replaced by a rename, so that the link never is missing while the terminal is open.
+    if (!this->settings_.link_path.empty())
+    {
+        std::string new_link = this->settings_.link_path + ".new";
+        unlink(new_link.c_str());
+        if (symlink(this->terminal_path_.c_str(), new_link.c_str()) != 0 ||
+            rename(new_link.c_str(), this->settings_.link_path.c_str()) != 0)
+            printf("cannot link %s to %s\n", this->settings_.link_path.c_str(), this->terminal_path_.c_str());
+    }
+    return true;
+}
+
+void DeviceSimulator::CloseTerminal()
+{
+    std::lock_guard<std::mutex> lock(this->lock_);
+    if (this->master_ < 0)
+        return;
+
+    if (!this->settings_.link_path.empty())
+        unlink(this->settings_.link_path.c_str());
+    close(this->master_);
+    this->master_ = -1;
+    this->terminal_path_ = "";
+}
+
+void DeviceSimulator::Run()
+{
+    this->start_ = Clock::now();
+    ModuleLine line;
+
+    while (this->running_)
+    {
+        bool planned = false;
+        {
+            std::lock_guard<std::mutex> lock(this->lock_);
+            planned = this->model_.Next(line);
+        }
+        if (!planned)
+        {
+            this->finished_ = true;
+            break;
+        }
+
+        if (line.disconnect)
+        {
+            this->WaitUntil(line.time);
+            this->CloseTerminal();
+            while (this->running_ && this->GetTime() < line.reconnect_time)
+                std::this_thread::sleep_for(std::chrono::milliseconds(MAX_POLL_MILLISECONDS));
+            if (!this->running_ || !this->OpenTerminal())
+                break;
+            std::lock_guard<std::mutex> lock(this->lock_);
+            this->model_.Restart(this->GetTime());
+            continue;
+        }
+
+        // A rate command voids the planned line.
+        if (this->WaitUntil(line.time) || !this->running_)
+            continue;
+
+        // Without a reader the lines get lost, just like on the serial line of the module.
+        if (line.length > 0)
+            this->SendLine(line);
+    }
+}
+
+double DeviceSimulator::GetTime() const
+{
+    return std::chrono::duration<double>(Clock::now() - this->start_).count();
+}
+
+void DeviceSimulator::SendLine(const ModuleLine& line)
+{
+    if (this->settings_.baud_rate == 0)
+    {
+        ssize_t written = write(this->master_, line.bytes, line.length);
+        (void)written;
+        return;
+    }
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < line.length; i++)
+    {
+        ssize_t written = write(this->master_, line.bytes + i, 1);
+        (void)written;
+        std::this_thread::sleep_until(start +
+            std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(this->model_.GetTransferTime(i + 1))));
+    }
+}
+
+bool DeviceSimulator::WaitUntil(double time)
+{
+    Clock::time_point end = this->start_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(time));
+    while (this->running_)
+    {
+        Clock::duration remaining = end - Clock::now();
+        if (remaining <= Clock::duration::zero())
+            return false;
+
+        // poll() only waits whole milliseconds, the last one is slept precisely.
+        int milliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count());
+        if (milliseconds < 1)
+        {
+            std::this_thread::sleep_until(end);
+            return false;
+        }
+
+        pollfd master = { this->master_, POLLIN, 0 };
+        int result = poll(&master, 1, std::min(milliseconds, MAX_POLL_MILLISECONDS));
+        if (result > 0 && (master.revents & POLLHUP))
+        {
+            // Nobody has the terminal open, which the master reports until somebody does.
+            std::this_thread::sleep_for(std::min<Clock::duration>(remaining, std::chrono::milliseconds(10)));
+        }
+        else if (result > 0 && (master.revents & POLLIN))
+        {
+            if (this->HandleCommands())
+                return true;
+        }
+    }
+    return false;
+}
+
+bool DeviceSimulator::HandleCommands()
+{
+    bool changed = false;
+    char commands[16];
+    ssize_t count = 0;
+    while ((count = read(this->master_, commands, sizeof(commands))) > 0)
+    {
+        std::lock_guard<std::mutex> lock(this->lock_);
+        for (ssize_t i = 0; i < count; i++)
+        {
+            if (commands[i] == 'S' || commands[i] == 'F')
+                changed |= this->model_.SetStandby(commands[i] == 'S', this->GetTime());
+        }
+    }
+    return changed;
+}
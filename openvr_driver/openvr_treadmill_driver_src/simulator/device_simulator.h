@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "module_model.h"
+
+/**
+ * Plays the load cell module on the master side of a pseudo terminal, so that the capture
+ * and the driver can run against it without hardware. Sends a list of values, e.g. a
+ * recording of the validation folder or a synthetic gait profile, and reacts to the rate
+ * commands of the driver like the firmware does.
+ *
+ * Needs POSIX pseudo terminals.
+ */
+class DeviceSimulator
+{
+public:
+    DeviceSimulator(const SimulatorSettings& settings, std::vector<float> values);
+    ~DeviceSimulator();
+
+    /**
+     * Creates the pseudo terminal and starts sending. Returns false if no pseudo terminal
+     * could be created or there are no values.
+     */
+    bool Start();
+
+    void Stop();
+
+    /**
+     * Returns true once all values were sent without looping.
+     */
+    bool IsFinished() const;
+
+    /**
+     * Returns the path the capture opens: the link if there is one, the current pseudo
+     * terminal otherwise.
+     */
+    std::string GetPort() const;
+
+    SimulatorStatistics GetStatistics() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    SimulatorSettings settings_;
+    // Guarded by the lock, the statistics are read by other threads.
+    ModuleModel model_;
+    Clock::time_point start_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<bool> finished_{ false };
+
+    int master_ = -1;
+    std::string terminal_path_ = "";
+
+    mutable std::mutex lock_;
+
+    bool OpenTerminal();
+    void CloseTerminal();
+
+    /**
+     * Sends the values until stopped or finished.
+     */
+    void Run();
+
+    /**
+     * Returns the seconds since the start, the time axis of the model.
+     */
+    double GetTime() const;
+
+    /**
+     * Writes the line, paced with the baud rate.
+     */
+    void SendLine(const ModuleLine& line);
+
+    /**
+     * Waits until the given seconds since the start while handling the commands of the
+     * driver. Returns true early if the rate mode changed.
+     */
+    bool WaitUntil(double time);
+
+    /**
+     * Reads the pending rate commands. Returns true if the rate mode changed.
+     */
+    bool HandleCommands();
+};
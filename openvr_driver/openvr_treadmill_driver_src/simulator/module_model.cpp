@@ -0,0 +1,233 @@
+#include "module_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "frame_codec.h"
+
+static const double PI = 3.14159265358979;
+
+/**
+ * Returns the pull force of a gait at the given time without noise. Every step pulls
+ * the belt once, the pull force pulses with the cadence around a mean that rises with
+ * the speed. Walking has 40 steps/min, within the 30 to 41 of the walking validation
+ * recordings, and running 168, on both sides of the run cadence of the gait detector.
+ * Both fit a whole number of steps into the 30 s profiles, which loop without a jump.
+ */
+static float GetGaitForce(GaitProfile gait, double time)
+{
+    switch (gait)
+    {
+    case GaitProfile::WALK:
+        return static_cast<float>(0.45 + 0.2 * std::sin(2.0 * PI * (40.0 / 60.0) * time));
+    case GaitProfile::RUN:
+        return static_cast<float>(0.75 + 0.2 * std::sin(2.0 * PI * 2.8 * time));
+    default:
+        return 0.02f;
+    }
+}
+
+ModuleModel::ModuleModel(const SimulatorSettings& settings, std::vector<float> values)
+    : settings_(settings),
+      values_(std::move(values)),
+      random_(settings.seed)
+{
+}
+
+bool ModuleModel::Next(ModuleLine& line)
+{
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::normal_distribution<double> deviation(0.0, 1.0);
+
+    line = ModuleLine();
+    if (this->values_.empty() || this->settings_.rate <= 0.0)
+        return false;
+
+    double interval = this->standby_ ? this->settings_.standby_heartbeat : 1.0 / this->settings_.rate;
+
+    // Drawn for every line in the same order, so that the faults only depend on the seed.
+    double jitter = deviation(this->random_) * this->settings_.jitter;
+    bool drop = chance(this->random_) < this->settings_.drop_probability;
+    bool corrupt = chance(this->random_) < this->settings_.corrupt_probability;
+    bool stall = chance(this->random_) < this->settings_.stall_probability;
+
+    this->schedule_ += interval;
+    if (stall)
+        this->schedule_ += this->settings_.stall_duration;
+
+    // The connection hangs up right after the last line, sending starts over once the
+    // module is back.
+    if (this->settings_.disconnect_interval > 0.0 &&
+        this->schedule_ - this->connected_since_ >= this->settings_.disconnect_interval)
+    {
+        this->statistics_.disconnects++;
+        line.disconnect = true;
+        line.time = this->last_send_;
+        line.reconnect_time = line.time + this->settings_.disconnect_duration;
+        this->Restart(line.reconnect_time);
+        return true;
+    }
+
+    // The jitter moves a line around its slot, but never before the previous line.
+    line.time = std::max(this->last_send_, this->schedule_ + jitter);
+
+    if (!this->settings_.loop && this->index_ >= this->values_.size())
+        return false;
+    float value = this->values_[this->index_ % this->values_.size()];
+    // The module does not read the HX711 while it waits in standby. The amplifier keeps
+    // converting, so the next heartbeat skips the conversions of the wait.
+    this->index_ += this->standby_ ? std::max<size_t>(1, static_cast<size_t>(interval * this->settings_.rate)) : 1;
+
+    if (stall)
+        this->statistics_.stalls++;
+    this->statistics_.lines++;
+    if (drop)
+        this->statistics_.dropped++;
+    else if (corrupt)
+        this->statistics_.corrupted++;
+
+    if (!drop)
+        this->Encode(value, corrupt, line);
+    this->last_send_ = line.time + this->GetTransferTime(line.length);
+    return true;
+}
+
+bool ModuleModel::SetStandby(bool standby, double time)
+{
+    this->statistics_.commands++;
+    if (this->standby_ == standby)
+        return false;
+
+    // A rate command ends the current wait like it does on the module.
+    this->standby_ = standby;
+    this->statistics_.standby = standby;
+    this->schedule_ = time;
+    this->last_send_ = time;
+    return true;
+}
+
+bool ModuleModel::IsStandby() const
+{
+    return this->standby_;
+}
+
+void ModuleModel::Restart(double time)
+{
+    this->standby_ = false;
+    this->statistics_.standby = false;
+    this->schedule_ = time;
+    this->last_send_ = time;
+    this->connected_since_ = time;
+}
+
+double ModuleModel::GetTransferTime(size_t bytes) const
+{
+    if (this->settings_.baud_rate == 0)
+        return 0.0;
+    return bytes * 10.0 / this->settings_.baud_rate;
+}
+
+size_t ModuleModel::GetValueCount() const
+{
+    return this->values_.size();
+}
+
+const SimulatorStatistics& ModuleModel::GetStatistics() const
+{
+    return this->statistics_;
+}
+
+void ModuleModel::Encode(float value, bool corrupt, ModuleLine& line)
+{
+    if (this->settings_.protocol == SimulatorProtocol::BINARY)
+    {
+        FrameCodec::Encode(value, line.bytes);
+        line.length = FrameCodec::FRAME_SIZE;
+    }
+    else
+    {
+        int written = snprintf(reinterpret_cast<char*>(line.bytes), sizeof(line.bytes), "%.*f\r\n",
+            this->settings_.decimals, value);
+        line.length = std::min(sizeof(line.bytes) - 1, static_cast<size_t>(std::max(written, 0)));
+    }
+
+    if (corrupt && line.length > 0)
+    {
+        size_t position = std::uniform_int_distribution<size_t>(0, line.length - 1)(this->random_);
+        line.bytes[position] ^= static_cast<uint8_t>(1 << std::uniform_int_distribution<int>(0, 7)(this->random_));
+    }
+}
+
+bool ModuleModel::LoadRecording(const std::string& file, std::vector<float>& values)
+{
+    std::ifstream input(file);
+    if (!input)
+        return false;
+
+    values.clear();
+    std::string line;
+    while (std::getline(input, line))
+    {
+        char* end = nullptr;
+        float value = std::strtof(line.c_str(), &end);
+        if (end != line.c_str() && std::isfinite(value))
+            values.push_back(value);
+    }
+    return !values.empty();
+}
+
+std::vector<float> ModuleModel::MakeGaitProfile(GaitProfile profile, double rate, uint32_t seed)
+{
+    std::vector<std::pair<GaitProfile, double>> segments;
+    switch (profile)
+    {
+    case GaitProfile::IDLE:
+        segments = { { GaitProfile::IDLE, 10.0 } };
+        break;
+    case GaitProfile::WALK:
+        segments = { { GaitProfile::WALK, 30.0 } };
+        break;
+    case GaitProfile::RUN:
+        segments = { { GaitProfile::RUN, 30.0 } };
+        break;
+    case GaitProfile::MIXED:
+        segments = { { GaitProfile::IDLE, 5.0 }, { GaitProfile::WALK, 20.0 }, { GaitProfile::RUN, 10.0 },
+            { GaitProfile::WALK, 15.0 }, { GaitProfile::IDLE, 10.0 } };
+        break;
+    }
+
+    // The noise of the HX711 at the 10 Hz rate, relative to the calibrated range.
+    std::mt19937 random(seed);
+    std::normal_distribution<float> noise(0.0f, 0.005f);
+
+    std::vector<float> values;
+    double time = 0.0;
+    for (const std::pair<GaitProfile, double>& segment : segments)
+    {
+        size_t count = static_cast<size_t>(segment.second * rate);
+        for (size_t i = 0; i < count; i++)
+        {
+            values.push_back(std::max(0.0f, GetGaitForce(segment.first, time) + noise(random)));
+            time += 1.0 / rate;
+        }
+    }
+    return values;
+}
+
+bool ModuleModel::ParseGaitProfile(const std::string& name, GaitProfile& profile)
+{
+    if (name == "idle")
+        profile = GaitProfile::IDLE;
+    else if (name == "walk")
+        profile = GaitProfile::WALK;
+    else if (name == "run")
+        profile = GaitProfile::RUN;
+    else if (name == "mixed")
+        profile = GaitProfile::MIXED;
+    else
+        return false;
+    return true;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class SimulatorProtocol
+{
+    ASCII,
+    BINARY
+};
+
+enum class GaitProfile
+{
+    IDLE,
+    WALK,
+    RUN,
+    // Idle, walking, running, walking and idle again, a typical session in a minute.
+    MIXED
+};
+
+/**
+ * Timing and faults of the simulated load cell module. The probabilities apply to every
+ * line. All random decisions come from one generator seeded with seed, so the same
+ * settings send the same stream of lines and faults on every run.
+ */
+struct SimulatorSettings
+{
+    SimulatorProtocol protocol = SimulatorProtocol::ASCII;
+    // Lines per second at full rate, the module sends with the 10 Hz of the HX711.
+    double rate = 10.0;
+    // Standard deviation of the time between two lines in seconds.
+    double jitter = 0.0;
+    // Transfer rate of the serial connection with 10 bits per byte. 0 writes every line at once.
+    uint32_t baud_rate = 9600;
+    // Decimals of the values in text lines.
+    int decimals = 2;
+
+    double drop_probability = 0.0;
+    // A corrupted line has a single flipped bit, like noise on the serial line.
+    double corrupt_probability = 0.0;
+    double stall_probability = 0.0;
+    double stall_duration = 0.5;
+    // Seconds of sending between two hang ups of the connection, 0 never hangs up.
+    double disconnect_interval = 0.0;
+    double disconnect_duration = 2.0;
+
+    // Seconds between two values in standby, the heartbeat of the module.
+    double standby_heartbeat = 1.0;
+    // Starts over at the end of the values instead of finishing.
+    bool loop = true;
+    uint32_t seed = 1;
+    // A symbolic link kept pointing at the current pseudo terminal, whose path changes
+    // with every reconnect. Empty for none.
+    std::string link_path;
+};
+
+struct SimulatorStatistics
+{
+    // All values due for sending, including the dropped ones.
+    uint64_t lines = 0;
+    uint64_t dropped = 0;
+    uint64_t corrupted = 0;
+    uint64_t stalls = 0;
+    uint64_t disconnects = 0;
+    uint64_t commands = 0;
+    bool standby = false;
+};
+
+/**
+ * The next thing the module does: send a line or hang up the connection.
+ */
+struct ModuleLine
+{
+    // Seconds since the start of the module at which the first byte is sent or the
+    // connection hangs up.
+    double time = 0.0;
+    uint8_t bytes[64] = { 0 };
+    // 0 for a dropped line.
+    size_t length = 0;
+
+    bool disconnect = false;
+    // The module is present again after a hang up from this time on.
+    double reconnect_time = 0.0;
+};
+
+/**
+ * The output of the load cell module with its timing and faults, without any I/O. Plans
+ * one line after the other on a time axis starting at 0, so that it can be played in
+ * real time on a pseudo terminal as well as on simulated time inside the process.
+ */
+class ModuleModel
+{
+public:
+    ModuleModel(const SimulatorSettings& settings, std::vector<float> values);
+
+    /**
+     * Plans the line after the previous one. Returns false once all values were sent
+     * without looping.
+     */
+    bool Next(ModuleLine& line);
+
+    /**
+     * Applies a rate command that arrived at the given time. Returns true if the rate
+     * mode changed, the planned line then is void and the next one follows the command
+     * like on the module.
+     */
+    bool SetStandby(bool standby, double time);
+
+    bool IsStandby() const;
+
+    /**
+     * Starts sending again at full rate from the given time, like the module does after
+     * a reset or the end of a hang up.
+     */
+    void Restart(double time);
+
+    /**
+     * Returns the seconds the given number of bytes takes on the serial connection.
+     */
+    double GetTransferTime(size_t bytes) const;
+
+    size_t GetValueCount() const;
+
+    const SimulatorStatistics& GetStatistics() const;
+
+    /**
+     * Reads the values of a recording with one value per line, e.g. the CSV files of the
+     * validation folder. Lines without a number, like a header, are skipped.
+     */
+    static bool LoadRecording(const std::string& file, std::vector<float>& values);
+
+    /**
+     * Returns the pull force of the given gait sampled with the given rate, normalized to
+     * the 0 to 1 the module sends after its calibration.
+     */
+    static std::vector<float> MakeGaitProfile(GaitProfile profile, double rate, uint32_t seed);
+
+    static bool ParseGaitProfile(const std::string& name, GaitProfile& profile);
+
+private:
+    SimulatorSettings settings_;
+    std::vector<float> values_;
+    std::mt19937 random_;
+
+    double schedule_ = 0.0;
+    double last_send_ = 0.0;
+    double connected_since_ = 0.0;
+    size_t index_ = 0;
+    bool standby_ = false;
+
+    SimulatorStatistics statistics_;
+
+    /**
+     * Writes the line of the value, with a flipped bit if corrupted.
+     */
+    void Encode(float value, bool corrupt, ModuleLine& line);
+};
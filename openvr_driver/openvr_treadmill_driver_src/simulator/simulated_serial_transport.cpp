@@ -0,0 +1,174 @@
+#include "simulated_serial_transport.h"
+
+SimulatedSerialTransport::SimulatedSerialTransport(SimulatedClock& clock, const SimulatorSettings& settings, std::vector<float> values)
+    : clock_(clock),
+      model_(settings, std::move(values)),
+      start_time_(clock.Now())
+{
+}
+
+std::string SimulatedSerialTransport::FindPort(const std::string& name_match, const std::set<std::string>& excluded)
+{
+    std::string port = SimulatedSerialTransport::PORT_NAME;
+    if (this->clock_.Now() < this->absent_until_ || port.find(name_match) == std::string::npos || excluded.count(port) > 0)
+        return "";
+    return port;
+}
+
+bool SimulatedSerialTransport::Open(const std::string& port, uint32_t baud_rate)
+{
+    (void)baud_rate;
+    if (port != SimulatedSerialTransport::PORT_NAME || this->clock_.Now() < this->absent_until_)
+        return false;
+
+    this->open_ = true;
+    this->hung_up_ = false;
+    this->has_line_ = false;
+    this->model_.Restart(this->clock_.Now() - this->start_time_);
+    return true;
+}
+
+void SimulatedSerialTransport::Close()
+{
+    this->open_ = false;
+    this->hung_up_ = false;
+    this->has_line_ = false;
+}
+
+bool SimulatedSerialTransport::IsOpen() const
+{
+    return this->open_;
+}
+
+void SimulatedSerialTransport::SetReadTimeout(uint32_t milliseconds)
+{
+    this->read_timeout_ = milliseconds / 1000.0;
+}
+
+int SimulatedSerialTransport::Read(char* buffer, size_t size)
+{
+    if (!this->open_ || this->hung_up_ || size == 0)
+        return -1;
+    if (this->cancel_requested_.exchange(false))
+        return 0;
+
+    double deadline = this->clock_.Now() + this->read_timeout_;
+    this->PlanLine();
+    if (this->finished_)
+    {
+        this->clock_.AdvanceTo(deadline);
+        return 0;
+    }
+
+    if (this->line_.disconnect)
+    {
+        double time = this->start_time_ + this->line_.time;
+        if (time > deadline)
+        {
+            this->clock_.AdvanceTo(deadline);
+            return 0;
+        }
+        this->clock_.AdvanceTo(time);
+        this->hung_up_ = true;
+        this->absent_until_ = this->start_time_ + this->line_.reconnect_time;
+        this->has_line_ = false;
+        return -1;
+    }
+
+    double arrival = this->GetArrivalTime(this->line_position_);
+    if (arrival > deadline)
+    {
+        this->clock_.AdvanceTo(deadline);
+        return 0;
+    }
+    this->clock_.AdvanceTo(arrival);
+
+    // Everything of the line that arrived until now, at least the byte waited for even
+    // if the clock rounded its arrival time down.
+    double now = this->clock_.Now();
+    size_t count = 0;
+    while (count < size && this->line_position_ < this->line_.length &&
+        (count == 0 || this->GetArrivalTime(this->line_position_) <= now))
+    {
+        buffer[count++] = static_cast<char>(this->line_.bytes[this->line_position_++]);
+    }
+    if (this->line_position_ == this->line_.length)
+        this->has_line_ = false;
+    return static_cast<int>(count);
+}
+
+bool SimulatedSerialTransport::Write(const char* data, size_t size)
+{
+    if (!this->open_ || this->hung_up_)
+        return false;
+
+    double time = this->clock_.Now() - this->start_time_;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] != 'S' && data[i] != 'F')
+            continue;
+        // A line already on the wire is finished by the UART, a planned one is void.
+        if (this->model_.SetStandby(data[i] == 'S', time) && this->has_line_ &&
+            (this->line_.disconnect || this->line_position_ == 0))
+            this->has_line_ = false;
+    }
+    return true;
+}
+
+void SimulatedSerialTransport::CancelRead()
+{
+    this->cancel_requested_ = true;
+}
+
+void SimulatedSerialTransport::Reset()
+{
+    if (!this->open_ || this->hung_up_)
+        return;
+
+    // Drops the bytes that arrived so far, a hang up still happens.
+    double now = this->clock_.Now();
+    while (true)
+    {
+        this->PlanLine();
+        if (this->finished_ || this->line_.disconnect)
+            return;
+        while (this->line_position_ < this->line_.length && this->GetArrivalTime(this->line_position_) <= now)
+            this->line_position_++;
+        if (this->line_position_ < this->line_.length)
+            return;
+        this->has_line_ = false;
+    }
+}
+
+bool SimulatedSerialTransport::IsFinished() const
+{
+    return this->finished_;
+}
+
+SimulatorStatistics SimulatedSerialTransport::GetStatistics() const
+{
+    return this->model_.GetStatistics();
+}
+
+void SimulatedSerialTransport::PlanLine()
+{
+    if (this->has_line_ || this->finished_)
+        return;
+
+    // Dropped lines leave nothing on the wire.
+    while (this->model_.Next(this->line_))
+    {
+        if (this->line_.disconnect || this->line_.length > 0)
+        {
+            this->line_position_ = 0;
+            this->has_line_ = true;
+            return;
+        }
+    }
+    this->finished_ = true;
+}
+
+double SimulatedSerialTransport::GetArrivalTime(size_t position) const
+{
+    return this->start_time_ + this->line_.time + this->model_.GetTransferTime(position + 1);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "clock.h"
+#include "module_model.h"
+#include "serial_transport.h"
+
+/**
+ * A load cell module inside the process on simulated time. Reads do not wait, they move
+ * the clock forward to the arrival of the next byte or to the end of the read timeout.
+ * Together with a capture on the same clock, recorded sessions, hang ups and the
+ * reconnects of the capture replay as fast as the host can process them, and the same
+ * settings yield the same samples bit for bit on every run.
+ *
+ * The module is present as the port "simulated" except while it is hung up. Opening the
+ * port restarts it, like the reset of the Arduino board.
+ */
+class SimulatedSerialTransport : public SerialTransport
+{
+public:
+    static constexpr const char* PORT_NAME = "simulated";
+
+    /**
+     * The clock must outlive the transport and must not be moved by anyone else while
+     * the capture runs.
+     */
+    SimulatedSerialTransport(SimulatedClock& clock, const SimulatorSettings& settings, std::vector<float> values);
+
+    std::string FindPort(const std::string& name_match, const std::set<std::string>& excluded) override;
+
+    bool Open(const std::string& port, uint32_t baud_rate) override;
+
+    void Close() override;
+
+    bool IsOpen() const override;
+
+    void SetReadTimeout(uint32_t milliseconds) override;
+
+    int Read(char* buffer, size_t size) override;
+
+    bool Write(const char* data, size_t size) override;
+
+    void CancelRead() override;
+
+    void Reset() override;
+
+    /**
+     * Returns true once all values were sent without looping.
+     */
+    bool IsFinished() const;
+
+    /**
+     * Returns the statistics of the module. Only safe while the capture does not run.
+     */
+    SimulatorStatistics GetStatistics() const;
+
+private:
+    SimulatedClock& clock_;
+    ModuleModel model_;
+    // The clock time of the start of the module, the time axis of the model starts there.
+    double start_time_ = 0.0;
+
+    bool open_ = false;
+    // The module hung up and is absent until the given clock time. Reads of an open
+    // port fail until it is closed.
+    bool hung_up_ = false;
+    double absent_until_ = 0.0;
+    double read_timeout_ = 0.0;
+    std::atomic<bool> cancel_requested_{ false };
+
+    // The line on its way and the next of its bytes to read.
+    ModuleLine line_;
+    size_t line_position_ = 0;
+    bool has_line_ = false;
+    bool finished_ = false;
+
+    /**
+     * Plans the next line or hang up if there is none on its way.
+     */
+    void PlanLine();
+
+    /**
+     * Returns the clock time at which the given byte of the current line has arrived.
+     */
+    double GetArrivalTime(size_t position) const;
+};
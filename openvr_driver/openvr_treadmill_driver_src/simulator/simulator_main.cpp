@@ -0,0 +1,186 @@
+/**
+ * Plays a load cell module on a pseudo terminal, so that the driver or the capture can
+ * run without hardware. Streams a recording or a synthetic gait profile with the given
+ * timing and faults until stopped with Ctrl+C, then prints what it sent.
+ *
+ *     device_simulator --csv ../../load_cell_module/validation/data/02_walk_test.csv
+ *         --normalize --link /tmp/treadmill --drop 0.01 --disconnect-every 30
+ *
+ * The driver connects with the setting "port_match" set to the printed path.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "device_simulator.h"
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void RequestStop(int)
+{
+    stop_requested = 1;
+}
+
+static void PrintUsage()
+{
+    printf(
+        "usage: device_simulator [options]\n"
+        "  --csv FILE             replays a recording with one value per line\n"
+        "  --profile NAME         synthetic gait: idle, walk, run or mixed (default walk)\n"
+        "  --scale F, --offset F  maps the values to value * F + offset\n"
+        "  --normalize            maps the range of the recording to 0 to 1\n"
+        "  --protocol NAME        ascii or binary (default ascii)\n"
+        "  --rate HZ              lines per second (default 10)\n"
+        "  --jitter MS            standard deviation of the line times\n"
+        "  --baud N               transfer rate, 0 for none (default 9600)\n"
+        "  --decimals N           decimals of the text values (default 2)\n"
+        "  --drop P               probability of a lost line\n"
+        "  --corrupt P            probability of a flipped bit in a line\n"
+        "  --stall P              probability of a stall before a line\n"
+        "  --stall-ms MS          length of a stall (default 500)\n"
+        "  --disconnect-every S   seconds between hang ups, 0 for none\n"
+        "  --disconnect-for S     seconds until the terminal comes back (default 2)\n"
+        "  --link PATH            link that follows the pseudo terminal\n"
+        "  --seed N               seed of the faults and the gait noise (default 1)\n"
+        "  --once                 stops at the end of the values instead of looping\n"
+        "  --duration S           stops after the given seconds\n");
+}
+
+int main(int argc, char** argv)
+{
+    SimulatorSettings settings;
+    std::string csv_file = "";
+    std::string profile_name = "walk";
+    double scale = 1.0;
+    double offset = 0.0;
+    bool normalize = false;
+    double duration = 0.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--normalize")
+        {
+            normalize = true;
+            continue;
+        }
+        if (option == "--once")
+        {
+            settings.loop = false;
+            continue;
+        }
+        if (option == "--help" || i + 1 == argc)
+        {
+            PrintUsage();
+            return option == "--help" ? 0 : 1;
+        }
+
+        const char* value = argv[++i];
+        if (option == "--csv")
+            csv_file = value;
+        else if (option == "--profile")
+            profile_name = value;
+        else if (option == "--scale")
+            scale = std::atof(value);
+        else if (option == "--offset")
+            offset = std::atof(value);
+        else if (option == "--protocol" && (std::strcmp(value, "ascii") == 0 || std::strcmp(value, "binary") == 0))
+            settings.protocol = std::strcmp(value, "binary") == 0 ? SimulatorProtocol::BINARY : SimulatorProtocol::ASCII;
+        else if (option == "--rate")
+            settings.rate = std::atof(value);
+        else if (option == "--jitter")
+            settings.jitter = std::atof(value) / 1000.0;
+        else if (option == "--baud")
+            settings.baud_rate = static_cast<uint32_t>(std::atol(value));
+        else if (option == "--decimals")
+            settings.decimals = std::atoi(value);
+        else if (option == "--drop")
+            settings.drop_probability = std::atof(value);
+        else if (option == "--corrupt")
+            settings.corrupt_probability = std::atof(value);
+        else if (option == "--stall")
+            settings.stall_probability = std::atof(value);
+        else if (option == "--stall-ms")
+            settings.stall_duration = std::atof(value) / 1000.0;
+        else if (option == "--disconnect-every")
+            settings.disconnect_interval = std::atof(value);
+        else if (option == "--disconnect-for")
+            settings.disconnect_duration = std::atof(value);
+        else if (option == "--link")
+            settings.link_path = value;
+        else if (option == "--seed")
+            settings.seed = static_cast<uint32_t>(std::atol(value));
+        else if (option == "--duration")
+            duration = std::atof(value);
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    std::vector<float> values;
+    if (!csv_file.empty())
+    {
+        if (!ModuleModel::LoadRecording(csv_file, values))
+        {
+            printf("cannot read values from %s\n", csv_file.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        GaitProfile profile;
+        if (!ModuleModel::ParseGaitProfile(profile_name, profile))
+        {
+            printf("unknown gait profile %s\n", profile_name.c_str());
+            return 1;
+        }
+        values = ModuleModel::MakeGaitProfile(profile, settings.rate, settings.seed);
+    }
+
+    // The recordings of the validation folder are raw counts of the HX711.
+    if (normalize)
+    {
+        auto range = std::minmax_element(values.begin(), values.end());
+        float minimum = *range.first;
+        float span = *range.second - minimum;
+        for (float& value : values)
+            value = span > 0.0f ? (value - minimum) / span : 0.0f;
+    }
+    for (float& value : values)
+        value = static_cast<float>(value * scale + offset);
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+
+    DeviceSimulator simulator(settings, std::move(values));
+    if (!simulator.Start())
+    {
+        printf("cannot create a pseudo terminal\n");
+        return 1;
+    }
+    printf("simulating the load cell module on %s\n", simulator.GetPort().c_str());
+    fflush(stdout);
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(duration));
+    while (!stop_requested && !simulator.IsFinished() &&
+        (duration <= 0.0 || std::chrono::steady_clock::now() < end))
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    simulator.Stop();
+
+    SimulatorStatistics statistics = simulator.GetStatistics();
+    printf("lines %llu, dropped %llu, corrupted %llu, stalls %llu, disconnects %llu, commands %llu\n",
+        static_cast<unsigned long long>(statistics.lines), static_cast<unsigned long long>(statistics.dropped),
+        static_cast<unsigned long long>(statistics.corrupted), static_cast<unsigned long long>(statistics.stalls),
+        static_cast<unsigned long long>(statistics.disconnects), static_cast<unsigned long long>(statistics.commands));
+    return 0;
+}
@@ -0,0 +1,300 @@
+#include "anchor_calibrator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+AnchorCalibrator::AnchorCalibrator(const AnchorCalibrationSettings& settings)
+    : settings_(settings)
+{
+}
+
+AnchorCalibrator::~AnchorCalibrator()
+{
+    this->Stop();
+}
+
+void AnchorCalibrator::Start()
+{
+    this->Stop();
+    this->Reset();
+    this->queue_head_ = 0;
+    this->queue_tail_ = 0;
+    this->has_result_ = false;
+
+    this->running_ = true;
+    this->worker_ = std::thread(&AnchorCalibrator::WorkerLoop, this);
+
+#ifdef _WIN32
+    // The fit is not urgent at all, it must never take time from the frame or
+    // capture threads.
+    SetThreadPriority(this->worker_.native_handle(), THREAD_PRIORITY_LOWEST);
+#endif
+}
+
+void AnchorCalibrator::Stop()
+{
+    this->running_ = false;
+    if (this->worker_.joinable())
+        this->worker_.join();
+}
+
+bool AnchorCalibrator::IsRunning() const
+{
+    return this->running_;
+}
+
+void AnchorCalibrator::AddSample(float x, float z, float force)
+{
+    if (!this->running_ || !(force >= this->settings_.min_force))
+        return;
+
+    size_t head = this->queue_head_.load(std::memory_order_relaxed);
+    if (head - this->queue_tail_.load(std::memory_order_acquire) >= QUEUE_SIZE)
+        return;
+
+    this->queue_[head % QUEUE_SIZE] = { x, z, force };
+    this->queue_head_.store(head + 1, std::memory_order_release);
+}
+
+bool AnchorCalibrator::TakeResult(AnchorEstimate& estimate)
+{
+    if (!this->has_result_.exchange(false))
+        return false;
+
+    std::lock_guard<std::mutex> lock(this->result_lock_);
+    estimate = this->result_;
+    return true;
+}
+
+void AnchorCalibrator::WorkerLoop()
+{
+    const size_t SOLVE_INTERVAL = 50;
+    size_t next_solve = this->settings_.min_samples;
+
+    while (this->running_)
+    {
+        // The samples arrive with 10 Hz, waking up a few times per second is plenty.
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        size_t tail = this->queue_tail_.load(std::memory_order_relaxed);
+        size_t head = this->queue_head_.load(std::memory_order_acquire);
+        for (; tail != head; tail++)
+        {
+            const Sample& sample = this->queue_[tail % QUEUE_SIZE];
+            this->Accumulate(sample.x, sample.z, sample.force);
+        }
+        this->queue_tail_.store(tail, std::memory_order_release);
+
+        if (this->sample_count_ < next_solve)
+            continue;
+        next_solve = this->sample_count_ + SOLVE_INTERVAL;
+
+        AnchorEstimate estimate;
+        if (this->Solve(estimate))
+        {
+            std::lock_guard<std::mutex> lock(this->result_lock_);
+            this->result_ = estimate;
+            this->has_result_ = true;
+            this->running_ = false;
+        }
+    }
+}
+
+void AnchorCalibrator::Accumulate(float x, float z, float force)
+{
+    const double row[PARAMETERS] = { 2.0 * x, 2.0 * z, 1.0, force, static_cast<double>(force) * force };
+    const double target = static_cast<double>(x) * x + static_cast<double>(z) * z;
+
+    for (size_t i = 0; i < PARAMETERS; i++)
+    {
+        for (size_t j = 0; j < PARAMETERS; j++)
+            this->normal_matrix_[i][j] += row[i] * row[j];
+        this->normal_vector_[i] += row[i] * target;
+    }
+    size_t index = this->sample_count_++;
+
+    // The stored samples only serve the refinement and the plausibility checks. Every
+    // stride-th sample is stored. If there are too many, every second one is dropped
+    // and the stride doubles, so that the stored samples always cover the whole session
+    // evenly.
+    if (index % this->stride_ != 0)
+        return;
+    if (this->samples_.size() >= MAX_STORED_SAMPLES)
+    {
+        for (size_t i = 0; i < this->samples_.size() / 2; i++)
+            this->samples_[i] = this->samples_[2 * i];
+        this->samples_.resize(this->samples_.size() / 2);
+        this->stride_ *= 2;
+        if (index % this->stride_ != 0)
+            return;
+    }
+    this->samples_.push_back({ x, z, force });
+}
+
+/**
+ * Solves the linear system a x = b with Gaussian elimination and partial pivoting.
+ * Returns false if the system is singular.
+ */
+template <size_t N>
+static bool SolveLinearSystem(const double (&matrix)[N][N], const double (&vector)[N], double (&solution)[N])
+{
+    double a[N][N + 1];
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t j = 0; j < N; j++)
+            a[i][j] = matrix[i][j];
+        a[i][N] = vector[i];
+    }
+
+    for (size_t column = 0; column < N; column++)
+    {
+        size_t pivot = column;
+        for (size_t row = column + 1; row < N; row++)
+        {
+            if (std::fabs(a[row][column]) > std::fabs(a[pivot][column]))
+                pivot = row;
+        }
+        if (std::fabs(a[pivot][column]) < 1.0e-12)
+            return false;
+        std::swap(a[pivot], a[column]);
+
+        for (size_t row = 0; row < N; row++)
+        {
+            if (row == column)
+                continue;
+            double factor = a[row][column] / a[column][column];
+            for (size_t j = column; j <= N; j++)
+                a[row][j] -= factor * a[column][j];
+        }
+    }
+
+    for (size_t i = 0; i < N; i++)
+        solution[i] = a[i][N] / a[i][i];
+    return true;
+}
+
+bool AnchorCalibrator::Solve(AnchorEstimate& estimate) const
+{
+    if (this->sample_count_ < this->settings_.min_samples)
+        return false;
+
+    // The algebraic fit of the accumulated normal equations. A tiny ridge keeps the
+    // system solvable if the force barely varied, the force terms then stay small.
+    double normal_matrix[PARAMETERS][PARAMETERS];
+    double trace = 0.0;
+    for (size_t i = 0; i < PARAMETERS; i++)
+        trace += this->normal_matrix_[i][i];
+    for (size_t i = 0; i < PARAMETERS; i++)
+    {
+        for (size_t j = 0; j < PARAMETERS; j++)
+            normal_matrix[i][j] = this->normal_matrix_[i][j];
+        normal_matrix[i][i] += 1.0e-9 * trace;
+    }
+
+    double algebraic[PARAMETERS];
+    if (!SolveLinearSystem(normal_matrix, this->normal_vector_, algebraic))
+        return false;
+
+    double squared_length = algebraic[2] + algebraic[0] * algebraic[0] + algebraic[1] * algebraic[1];
+    if (!(squared_length > 0.0))
+        return false;
+
+    // The algebraic fit weights far samples stronger and is biased towards a smaller
+    // circle by the position noise. A few Gauss-Newton steps on the actual distance
+    // errors of the stored samples remove that, starting from the algebraic result.
+    double anchor_x = algebraic[0];
+    double anchor_z = algebraic[1];
+    double rope_length = std::sqrt(squared_length);
+    double stretch = algebraic[3] / (2.0 * rope_length);
+
+    double jacobian_product[4][4];
+    double squared_error = 0.0;
+    for (int iteration = 0; iteration < 10; iteration++)
+    {
+        double gradient[4] = {};
+        for (size_t i = 0; i < 4; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+                jacobian_product[i][j] = 0.0;
+        }
+        squared_error = 0.0;
+
+        for (const Sample& sample : this->samples_)
+        {
+            double dx = sample.x - anchor_x;
+            double dz = sample.z - anchor_z;
+            double distance = std::max(std::sqrt(dx * dx + dz * dz), 1.0e-6);
+            double error = distance - (rope_length + stretch * sample.force);
+            const double row[4] = { -dx / distance, -dz / distance, -1.0, -static_cast<double>(sample.force) };
+
+            for (size_t i = 0; i < 4; i++)
+            {
+                for (size_t j = 0; j < 4; j++)
+                    jacobian_product[i][j] += row[i] * row[j];
+                gradient[i] += row[i] * error;
+            }
+            squared_error += error * error;
+        }
+
+        double step[4];
+        if (!SolveLinearSystem(jacobian_product, gradient, step))
+            return false;
+
+        anchor_x -= step[0];
+        anchor_z -= step[1];
+        rope_length -= step[2];
+        stretch -= step[3];
+    }
+
+    if (rope_length < this->settings_.min_rope_length || rope_length > this->settings_.max_rope_length || stretch < 0.0)
+        return false;
+
+    // The fit must explain the samples, and the samples must pin down the anchor. On a
+    // short arc the anchor can slide along the radius without changing the error, which
+    // shows up as a large variance of the anchor position.
+    double residual = std::sqrt(squared_error / this->samples_.size());
+    if (residual > this->settings_.max_residual)
+        return false;
+
+    double variance = residual * residual;
+    double unit_x[4] = { 1.0, 0.0, 0.0, 0.0 };
+    double unit_z[4] = { 0.0, 1.0, 0.0, 0.0 };
+    double column_x[4];
+    double column_z[4];
+    if (!SolveLinearSystem(jacobian_product, unit_x, column_x) || !SolveLinearSystem(jacobian_product, unit_z, column_z))
+        return false;
+
+    // The stored samples are a thinned out subset, the uncertainty is scaled to the
+    // full number of samples.
+    double sample_ratio = static_cast<double>(this->samples_.size()) / this->sample_count_;
+    double anchor_error = std::sqrt(variance * (column_x[0] + column_z[1]) * sample_ratio);
+    if (anchor_error > this->settings_.max_anchor_error)
+        return false;
+
+    estimate.anchor_x = static_cast<float>(anchor_x);
+    estimate.anchor_z = static_cast<float>(anchor_z);
+    estimate.rope_length = static_cast<float>(rope_length);
+    estimate.stretch = static_cast<float>(stretch);
+    estimate.residual = static_cast<float>(residual);
+    estimate.samples = this->sample_count_;
+    return true;
+}
+
+void AnchorCalibrator::Reset()
+{
+    for (size_t i = 0; i < PARAMETERS; i++)
+    {
+        for (size_t j = 0; j < PARAMETERS; j++)
+            this->normal_matrix_[i][j] = 0.0;
+        this->normal_vector_[i] = 0.0;
+    }
+    this->sample_count_ = 0;
+    this->stride_ = 1;
+    this->samples_.clear();
+    this->samples_.reserve(MAX_STORED_SAMPLES);
+}
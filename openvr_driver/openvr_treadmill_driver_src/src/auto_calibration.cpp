@@ -0,0 +1,92 @@
+#include "auto_calibration.h"
+
+AutoCalibrator::AutoCalibrator()
+    : AutoCalibrator(AutoCalibrationSettings())
+{
+}
+
+AutoCalibrator::AutoCalibrator(const AutoCalibrationSettings& settings)
+    : settings_(settings),
+      lower_(settings.lower_quantile),
+      upper_(settings.upper_quantile),
+      session_lower_(settings.lower_quantile),
+      session_upper_(settings.upper_quantile),
+      session_peak_(settings.upper_quantile)
+{
+}
+
+void AutoCalibrator::Add(float value, bool idle)
+{
+    this->lower_.Add(value);
+    if (!idle)
+        this->upper_.Add(value);
+
+    if (!this->session_running_)
+        return;
+
+    if (this->IsSessionActive(value))
+        this->session_upper_.Add(value);
+    this->session_lower_.Add(value);
+    this->session_peak_.Add(value);
+
+    if (this->session_upper_.GetCount() >= this->settings_.session_active_samples)
+    {
+        this->session_running_ = false;
+        this->session_finished_ = true;
+    }
+}
+
+void AutoCalibrator::StartSession()
+{
+    this->session_lower_.Reset();
+    this->session_upper_.Reset();
+    this->session_peak_.Reset();
+    this->session_running_ = true;
+    this->session_finished_ = false;
+}
+
+bool AutoCalibrator::IsSessionRunning() const
+{
+    return this->session_running_;
+}
+
+bool AutoCalibrator::TakeSessionResult(CalibrationProfile& profile)
+{
+    if (!this->session_finished_)
+        return false;
+
+    this->session_finished_ = false;
+    return this->MakeProfile(this->session_lower_, this->session_upper_, profile);
+}
+
+bool AutoCalibrator::GetSuggestion(CalibrationProfile& profile) const
+{
+    return this->MakeProfile(this->lower_, this->upper_, profile);
+}
+
+bool AutoCalibrator::IsSessionActive(float value) const
+{
+    if (this->session_peak_.GetCount() < this->settings_.min_samples)
+        return false;
+
+    double idle_level = this->session_lower_.GetEstimate();
+    double peak_level = this->session_peak_.GetEstimate();
+    return peak_level > idle_level &&
+           value > idle_level + this->settings_.session_active_fraction * (peak_level - idle_level);
+}
+
+bool AutoCalibrator::MakeProfile(const P2QuantileEstimator& lower, const P2QuantileEstimator& upper,
+                                 CalibrationProfile& profile) const
+{
+    if (lower.GetCount() < this->settings_.min_samples || upper.GetCount() < this->settings_.min_samples)
+        return false;
+
+    float min_value = static_cast<float>(lower.GetEstimate());
+    float max_value = static_cast<float>(upper.GetEstimate());
+    if (!(max_value > min_value))
+        return false;
+
+    profile.min_value = min_value;
+    profile.max_value = max_value;
+    return true;
+}
@@ -0,0 +1,55 @@
+#include "clock.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+/**
+ * Returns the given seconds in whole nanoseconds.
+ */
+static int64_t ToNanoseconds(double seconds)
+{
+    return static_cast<int64_t>(std::llround(seconds * 1e9));
+}
+
+Clock& Clock::GetSteadyClock()
+{
+    static SteadyClock clock;
+    return clock;
+}
+
+double SteadyClock::Now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadyClock::SleepFor(double seconds)
+{
+    if (seconds > 0.0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+SimulatedClock::SimulatedClock(double start_time)
+    : nanoseconds_(ToNanoseconds(start_time))
+{
+}
+
+double SimulatedClock::Now()
+{
+    return this->nanoseconds_.load(std::memory_order_acquire) / 1e9;
+}
+
+void SimulatedClock::SleepFor(double seconds)
+{
+    if (seconds > 0.0)
+        this->nanoseconds_.fetch_add(ToNanoseconds(seconds), std::memory_order_acq_rel);
+}
+
+void SimulatedClock::AdvanceTo(double time)
+{
+    int64_t target = ToNanoseconds(time);
+    int64_t current = this->nanoseconds_.load(std::memory_order_acquire);
+    while (current < target && !this->nanoseconds_.compare_exchange_weak(current, target, std::memory_order_acq_rel))
+    {
+    }
+}
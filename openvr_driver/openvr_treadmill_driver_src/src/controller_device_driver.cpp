@@ -1,27 +1,129 @@
 #include "controller_device_driver.h"
 
-#include "driverlog.h"
-#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <vector>
 
-// Let's create some variables for strings used in getting settings.
-// "<my_driver>_<section>"
-static const char* treadmill_main_settings_section = "driver_CustomTreadmill";
+#include "driverlog.h"
+#include "tracing.h"
 
 // These are the keys we want to retrieve the values for in the settings
 static const char *treadmill_settings_key_model_number = "mycontroller_model_number";
+static const char *treadmill_settings_key_serial_number = "serial_number";
+static const char *treadmill_settings_key_role = "role";
+static const char *treadmill_settings_key_port_match = "port_match";
+static const char *treadmill_settings_key_input_profile = "input_profile";
+static const char *treadmill_settings_key_input_scale = "input_scale";
+static const char *treadmill_settings_key_response_curve = "response_curve";
+static const char *treadmill_settings_key_response_curve_gamma = "response_curve_gamma";
+static const char *treadmill_settings_key_response_curve_points = "response_curve_points";
+static const char *treadmill_settings_key_spike_filter_window = "spike_filter_window";
+static const char *treadmill_settings_key_spike_filter_threshold = "spike_filter_threshold";
+static const char *treadmill_settings_key_spike_filter_min_deviation = "spike_filter_min_deviation";
+static const char *treadmill_settings_key_auto_deadzone = "auto_deadzone";
+static const char *treadmill_settings_key_idle_band = "idle_band";
+static const char *treadmill_settings_key_max_idle_baseline = "max_idle_baseline";
+static const char *treadmill_settings_key_calibration_min = "calibration_min";
+static const char *treadmill_settings_key_calibration_max = "calibration_max";
+static const char *treadmill_settings_key_calibration_mode = "calibration_mode";
+static const char *treadmill_settings_key_input_keepalive_interval = "input_keepalive_interval";
+static const char *treadmill_settings_key_publish_mode = "publish_mode";
+static const char *treadmill_settings_key_direction_mode = "direction_mode";
+static const char *treadmill_settings_key_tether_yaw = "tether_yaw";
+static const char *treadmill_settings_key_direction_max_angle = "direction_max_angle";
+static const char *treadmill_settings_key_direction_calibration = "direction_calibration";
+static const char *treadmill_settings_key_anchor_calibration = "anchor_calibration";
+static const char *treadmill_settings_key_anchor_x = "anchor_x";
+static const char *treadmill_settings_key_anchor_z = "anchor_z";
+static const char *treadmill_settings_key_rope_length = "rope_length";
+static const char *treadmill_settings_key_rope_stretch = "rope_stretch";
+static const char *treadmill_settings_key_publish_hip_pose = "publish_hip_pose";
+static const char *treadmill_settings_key_hip_offset = "hip_offset";
+static const char *treadmill_settings_key_latency_dump_file = "latency_dump_file";
+static const char *treadmill_settings_key_shared_metrics = "shared_metrics";
+static const char *treadmill_settings_key_trace_file = "trace_file";
+static const char *treadmill_settings_key_session_recording_folder = "session_recording_folder";
+
+static const float DEGREES_TO_RADIANS = 0.017453293f;
+
+// The acceleration is sent in steps of this size, and smaller values are sent as 0.
+// Its trend input changes a little with every sample, unquantized it would be sent
+// with every sample, too.
+static const float ACCEL_STEP = 0.05f;
 
 
-TreadmillDeviceDriver::TreadmillDeviceDriver( vr::ETrackedControllerRole role )
+/**
+ * Parses the role names of the settings. Unknown names fall back to the treadmill role.
+ */
+static vr::ETrackedControllerRole ParseRole( const std::string &role )
+{
+	if ( role == "left_hand" )
+		return vr::TrackedControllerRole_LeftHand;
+	if ( role == "right_hand" )
+		return vr::TrackedControllerRole_RightHand;
+	if ( role == "opt_out" )
+		return vr::TrackedControllerRole_OptOut;
+	if ( !role.empty() && role != "treadmill" )
+		DriverLog( "Unknown role '%s', using treadmill", role.c_str() );
+	return vr::TrackedControllerRole_Treadmill;
+}
+
+TreadmillDeviceDriver::TreadmillDeviceDriver( const DeviceSettings &settings )
+	: settings_( settings )
 {
 	is_active_ = false;
-	treadmill_role_ = role;
+	treadmill_role_ = ParseRole( settings_.GetString( treadmill_settings_key_role ) );
 
 	// We have our model number and serial number stored in SteamVR settings. We need to get them and do so here.
-	char model_number[ 1024 ];
-	vr::VRSettings()->GetString(treadmill_main_settings_section, treadmill_settings_key_model_number, model_number, sizeof( model_number ) );
-	serial_number_ = model_number;
+	// The serial number has to be unique, so devices of the device list without their own one get their id appended.
+	model_number_ = settings_.GetString( treadmill_settings_key_model_number );
+	serial_number_ = settings_.GetString( treadmill_settings_key_serial_number );
+	if ( serial_number_.empty() )
+		serial_number_ = settings_.GetDeviceId().empty() ? model_number_ : model_number_ + "_" + settings_.GetDeviceId();
 
 	DriverLog( "Treadmill Serial Number: %s", serial_number_.c_str() );
+
+	input_profile_ = settings_.GetString( treadmill_settings_key_input_profile );
+	input_scale_ = settings_.GetFloat( treadmill_settings_key_input_scale );
+
+	LoadResponseCurve();
+	direction_mapper_ = DirectionMapper( LoadDirectionSettings() );
+	direction_settings_.Store( direction_mapper_.GetSettings() );
+	relative_yaw_ = 0.0f;
+	force_ = 0.0f;
+	last_trend_ = 0.0f;
+	last_sample_time_ = 0.0;
+	anchor_sequence_ = 0;
+
+	publish_hip_pose_ = settings_.GetBool( treadmill_settings_key_publish_hip_pose );
+	rope_length_ = settings_.GetFloat( treadmill_settings_key_rope_length );
+	rope_stretch_ = settings_.GetFloat( treadmill_settings_key_rope_stretch );
+	HipPoseSettings hip_pose_settings;
+	hip_pose_settings.hip_offset = settings_.GetFloat( treadmill_settings_key_hip_offset );
+	hip_pose_estimator_ = HipPoseEstimator( hip_pose_settings );
+	hip_pose_.Store( HipPoseEstimator::GetInvalidPose() );
+	pipeline_settings_ = LoadPipelineSettings();
+	treadmill_device_.Configure( pipeline_settings_, settings_.GetString( treadmill_settings_key_port_match ) );
+	statistics_reset_ticks_ = std::chrono::steady_clock::now().time_since_epoch().count();
+	latency_dump_file_ = settings_.GetFilePath( treadmill_settings_key_latency_dump_file );
+	publish_shared_metrics_ = settings_.GetBool( treadmill_settings_key_shared_metrics );
+
+	float keepalive_interval = settings_.GetFloat( treadmill_settings_key_input_keepalive_interval );
+	keepalive_interval_ = std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::duration< float >( keepalive_interval ) );
+
+	sample_driven_publishing_ = settings_.GetString( treadmill_settings_key_publish_mode ) == "sample";
+	is_publishing_ = false;
+
+	last_sequence_ = 0;
+	input_values_.fill( 0.0f );
+	published_values_.fill( 0.0f );
+	is_published_.fill( false );
 }
 
 vr::EVRInitError TreadmillDeviceDriver::Activate( uint32_t unObjectId )
@@ -29,13 +131,58 @@ vr::EVRInitError TreadmillDeviceDriver::Activate( uint32_t unObjectId )
 	is_active_ = true;
 	controller_index_ = unObjectId;
 
+	// The recording has to be set up before the capture runs.
+	std::string recording_folder = settings_.GetString( treadmill_settings_key_session_recording_folder );
+	if ( !recording_folder.empty() )
+	{
+		char start_time[32];
+		std::time_t now = std::time( nullptr );
+		std::tm local_time;
+#ifdef _WIN32
+		localtime_s( &local_time, &now );
+#else
+		localtime_r( &now, &local_time );
+#endif
+		std::strftime( start_time, sizeof( start_time ), "%Y%m%d_%H%M%S", &local_time );
+		std::string file = recording_folder + "/session_" + serial_number_ + "_" + start_time + ".tsession";
+		if ( this->treadmill_device_.StartRecording( file, "serial_number=" + serial_number_ + "\n" ) )
+			DriverLog( "Recording the session into %s", file.c_str() );
+		else
+			DriverLog( "Failed to create the session recording %s", file.c_str() );
+	}
+
 	this->treadmill_device_.StartBackgroundCapture();
 
+	if ( settings_.GetBool( treadmill_settings_key_calibration_mode ) )
+	{
+		DriverLog( "Calibration mode: walk and run for about 30 seconds to calibrate the force range" );
+		this->treadmill_device_.StartCalibration();
+	}
+
+	if ( direction_mapper_.GetSettings().mode != DirectionMode::FORWARD && settings_.GetBool( treadmill_settings_key_direction_calibration ) )
+	{
+		DriverLog( "Direction calibration: walk straight away from the rope anchor for a few seconds" );
+		direction_mapper_.StartCalibration();
+	}
+
+	// The anchor is estimated during normal use, it only needs the user to pull the rope
+	// from a few different directions.
+	bool needs_anchor = direction_mapper_.GetSettings().mode == DirectionMode::ANCHOR || publish_hip_pose_;
+	if ( needs_anchor && ( !direction_mapper_.GetSettings().has_anchor || settings_.GetBool( treadmill_settings_key_anchor_calibration ) ) )
+	{
+		DriverLog( "Anchor calibration: estimating the rope anchor while you walk" );
+		anchor_calibrator_.Start();
+	}
+	anchor_sequence_ = 0;
+
+	if ( publish_shared_metrics_ && !shared_metrics_.Open( "CustomTreadmill_" + serial_number_ ) )
+		DriverLog( "Failed to create the shared metrics block of %s", serial_number_.c_str() );
+
 	vr::PropertyContainerHandle_t container = vr::VRProperties()->TrackedDeviceToPropertyContainer(controller_index_);
 
-	vr::VRProperties()->SetStringProperty(container, vr::Prop_ModelNumber_String, serial_number_.c_str());
+	vr::VRProperties()->SetStringProperty(container, vr::Prop_ModelNumber_String, model_number_.c_str());
 	vr::VRProperties()->SetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, treadmill_role_);
-	vr::VRProperties()->SetStringProperty(container, vr::Prop_InputProfilePath_String, "{CustomTreadmill}/input/mycontroller_profile.json");
+	vr::VRProperties()->SetStringProperty(container, vr::Prop_InputProfilePath_String, input_profile_.c_str());
 
 	// Let's set up our trigger. We've defined it to have a value and click component.
 	vr::VRDriverInput()->CreateScalarComponent(container, "/input/trigger/value", &input_handles_[TreadmillComponents::TRIGGER_VALUE], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedOneSided);
@@ -44,6 +191,21 @@ vr::EVRInitError TreadmillDeviceDriver::Activate( uint32_t unObjectId )
 	vr::VRDriverInput()->CreateScalarComponent(container, "/input/trackpad/x", &input_handles_[TreadmillComponents::TRACKPAD_X], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedTwoSided);
 	vr::VRDriverInput()->CreateScalarComponent(container, "/input/joystick/x", &input_handles_[TreadmillComponents::JOYSTICK_X], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedTwoSided);
 
+	// The gait components, e.g. for binding sprinting or footstep sounds.
+	vr::VRDriverInput()->CreateScalarComponent(container, "/input/speed/value", &input_handles_[TreadmillComponents::SPEED_VALUE], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedOneSided);
+	vr::VRDriverInput()->CreateScalarComponent(container, "/input/accel/value", &input_handles_[TreadmillComponents::ACCEL_VALUE], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedTwoSided);
+	vr::VRDriverInput()->CreateBooleanComponent(container, "/input/walking/click", &input_handles_[TreadmillComponents::WALKING_CLICK]);
+	vr::VRDriverInput()->CreateBooleanComponent(container, "/input/running/click", &input_handles_[TreadmillComponents::RUNNING_CLICK]);
+
+	// The components are new, so every one of them has to be sent once.
+	is_published_.fill( false );
+	next_keepalive_ = std::chrono::steady_clock::time_point::min();
+
+	if ( sample_driven_publishing_ )
+	{
+		is_publishing_ = true;
+		publisher_thread_ = std::thread( &TreadmillDeviceDriver::PublisherLoop, this );
+	}
 
 	return vr::VRInitError_None;
 }
@@ -53,58 +215,628 @@ void * TreadmillDeviceDriver::GetComponent( const char *pchComponentNameAndVersi
 	return nullptr;
 }
 
+/**
+ * Appends printf style formatted text to a string.
+ */
+static void AppendFormat( std::string &target, const char *format, ... )
+{
+	char buffer[ 256 ];
+	va_list args;
+	va_start( args, format );
+	int length = vsnprintf( buffer, sizeof( buffer ), format, args );
+	va_end( args );
+
+	if ( length > 0 )
+		target.append( buffer, std::min( static_cast< size_t >( length ), sizeof( buffer ) - 1 ) );
+}
+
+/**
+ * Returns the JSON name of a gait phase.
+ */
+static const char *GetGaitPhaseName( GaitPhase phase )
+{
+	switch ( phase )
+	{
+	case GaitPhase::WALKING:
+		return "walking";
+	case GaitPhase::RUNNING:
+		return "running";
+	default:
+		return "idle";
+	}
+}
+
 void TreadmillDeviceDriver::DebugRequest( const char *pchRequest, char *pchResponseBuffer, uint32_t unResponseBufferSize )
 {
-	if ( unResponseBufferSize >= 1 )
-		pchResponseBuffer[ 0 ] = 0;
+	if ( unResponseBufferSize < 1 )
+		return;
+
+	// The commands are compared word by word, so that extra spaces do not matter and a
+	// command followed by arguments it does not take is unknown.
+	std::vector< std::string > words;
+	std::istringstream words_stream( pchRequest != nullptr ? pchRequest : "" );
+	for ( std::string word; words_stream >> word; )
+		words.push_back( word );
+
+	std::string request;
+	for ( const std::string &word : words )
+		request += ( request.empty() ? "" : " " ) + word;
+	std::string response;
+
+	if ( request == "stats" )
+	{
+		response = GetStatsJson();
+	}
+	else if ( request == "latency" )
+	{
+		response = GetLatencyJson();
+	}
+	else if ( request == "latency dump" )
+	{
+		// Debug requests can come from any client of vrserver, so they only ever write
+		// the file of the settings.
+		if ( latency_dump_file_.empty() )
+			response = "{\"error\":\"latency_dump_file not set\"}";
+		else if ( !WriteLatencyDump( latency_dump_file_ ) )
+			response = "{\"error\":\"cannot write the dump file\"}";
+		else
+			response = "{\"dumped\":true}";
+	}
+	else if ( request == "trace start" )
+	{
+		Tracer::Start();
+		response = "{\"tracing\":true}";
+	}
+	else if ( request == "trace stop" )
+	{
+		Tracer::Stop();
+		response = "{\"tracing\":false}";
+	}
+	else if ( request == "trace write" )
+	{
+		std::string file = settings_.GetFilePath( treadmill_settings_key_trace_file );
+		if ( file.empty() )
+			response = "{\"error\":\"trace_file not set\"}";
+		else if ( !Tracer::WriteChromeTrace( file ) )
+			response = "{\"error\":\"cannot write the trace file\"}";
+		else
+			response = "{\"written\":true}";
+	}
+	else if ( words.size() == 2 && words[ 0 ] == "histogram" && GetLatencyStage( words[ 1 ] ) != nullptr )
+	{
+		response = GetLatencyHistogramJson( words[ 1 ] );
+	}
+	else if ( request == "reset" )
+	{
+		statistics_.Reset();
+		treadmill_device_.GetStatistics().Reset();
+		statistics_reset_ticks_ = std::chrono::steady_clock::now().time_since_epoch().count();
+		response = "{\"reset\":true}";
+	}
+	else if ( request == "config" )
+	{
+		response = GetConfigJson();
+	}
+	else
+	{
+		response = "{\"error\":\"unknown command\",\"commands\":[\"stats\",\"latency\",\"latency dump\",\"histogram line\",\"histogram processing\","
+			"\"histogram delivery\",\"histogram total\",\"trace start\",\"trace stop\",\"trace write\",\"reset\",\"config\"]}";
+	}
+
+	// A cut off JSON object is useless for the caller, so a response that does not fit is
+	// replaced by an error telling the required size.
+	if ( response.size() >= unResponseBufferSize )
+	{
+		size_t required = response.size() + 1;
+		response.clear();
+		AppendFormat( response, "{\"error\":\"buffer too small\",\"required\":%zu}", required );
+		if ( response.size() >= unResponseBufferSize )
+			response.clear();
+	}
+
+	memcpy( pchResponseBuffer, response.c_str(), response.size() + 1 );
 }
 
-vr::DriverPose_t TreadmillDeviceDriver::GetPose()
+std::string TreadmillDeviceDriver::GetStatsJson()
+{
+	CaptureStatistics &capture = treadmill_device_.GetStatistics();
+	TreadmillSample sample = treadmill_device_.GetTreadmillSample();
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point reset_time( std::chrono::steady_clock::duration( statistics_reset_ticks_.load() ) );
+	double elapsed = std::chrono::duration< double >( now - reset_time ).count();
+	double now_seconds = std::chrono::duration< double >( now.time_since_epoch() ).count();
+	uint64_t samples = capture.samples.load( std::memory_order_relaxed );
+
+	std::string json;
+	AppendFormat( json, "{\"connected\":%s", treadmill_device_.isConnected() ? "true" : "false" );
+	AppendFormat( json, ",\"standby\":%s", treadmill_device_.isStandby() ? "true" : "false" );
+	AppendFormat( json, ",\"samples\":%llu", static_cast< unsigned long long >( samples ) );
+	AppendFormat( json, ",\"sample_rate_hz\":%.2f", elapsed > 0.0 ? samples / elapsed : 0.0 );
+	AppendFormat( json, ",\"sample_age_ms\":%.1f", sample.sequence > 0 ? ( now_seconds - sample.timestamp ) * 1000.0 : -1.0 );
+	AppendFormat( json, ",\"read_errors\":%llu", static_cast< unsigned long long >( capture.read_errors.load( std::memory_order_relaxed ) ) );
+	AppendFormat( json, ",\"reconnects\":%llu", static_cast< unsigned long long >( capture.reconnects.load( std::memory_order_relaxed ) ) );
+	AppendFormat( json, ",\"removed_spikes\":%llu", static_cast< unsigned long long >( capture.removed_spikes.load( std::memory_order_relaxed ) ) );
+	AppendFormat( json, ",\"frames\":%llu", static_cast< unsigned long long >( statistics_.frames.load( std::memory_order_relaxed ) ) );
+	AppendFormat( json, ",\"consumed_samples\":%llu", static_cast< unsigned long long >( statistics_.consumed_samples.load( std::memory_order_relaxed ) ) );
+	AppendFormat( json, ",\"input_updates\":%llu", static_cast< unsigned long long >( statistics_.input_updates.load( std::memory_order_relaxed ) ) );
+	AppendFormat( json, ",\"capture_wakeups_per_s\":%.1f", elapsed > 0.0 ? capture.wakeups.load( std::memory_order_relaxed ) / elapsed : 0.0 );
+	AppendFormat( json, ",\"publisher_wakeups_per_s\":%.1f", elapsed > 0.0 ? statistics_.publisher_wakeups.load( std::memory_order_relaxed ) / elapsed : 0.0 );
+	AppendFormat( json, ",\"value\":%.3f", sample.value );
+	AppendFormat( json, ",\"gait\":\"%s\",\"cadence\":%.1f}", GetGaitPhaseName( sample.gait.phase ), sample.gait.cadence );
+	return json;
+}
+
+/**
+ * The stages of the way of a sample from the serial line to the input components, in the
+ * order they happen. "total" spans all of them.
+ */
+static const char *latency_stage_names[] = { "line", "processing", "delivery", "total" };
+
+const LatencyHistogram *TreadmillDeviceDriver::GetLatencyStage( const std::string &stage )
+{
+	CaptureStatistics &capture = treadmill_device_.GetStatistics();
+	if ( stage == "line" )
+		return &capture.line_latency;
+	if ( stage == "processing" )
+		return &capture.processing_latency;
+	// "latency" is the name of the delivery histogram in the first telemetry version.
+	if ( stage == "delivery" || stage == "latency" )
+		return &statistics_.sample_latency;
+	if ( stage == "total" )
+		return &statistics_.total_latency;
+	return nullptr;
+}
+
+std::string TreadmillDeviceDriver::GetLatencyJson()
 {
-	vr::DriverPose_t pose = { 0 }; //This example doesn't use Pose, so this method is just returning a default Pose.
-	pose.poseIsValid = false;
-	pose.result = vr::TrackingResult_Calibrating_OutOfRange;
-	pose.deviceIsConnected = true;
+	std::string json = "{\"unit\":\"us\"";
+	for ( const char *stage : latency_stage_names )
+	{
+		const LatencyHistogram &histogram = *GetLatencyStage( stage );
+		AppendFormat( json, ",\"%s\":{\"count\":%llu,\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}", stage,
+			static_cast< unsigned long long >( histogram.GetTotalCount() ),
+			static_cast< unsigned long long >( histogram.GetPercentile( 0.5 ) ),
+			static_cast< unsigned long long >( histogram.GetPercentile( 0.99 ) ),
+			static_cast< unsigned long long >( histogram.GetPercentile( 0.999 ) ),
+			static_cast< unsigned long long >( histogram.GetMax() ) );
+	}
+	json += "}";
+	return json;
+}
 
-	vr::HmdQuaternion_t quat;
-	quat.w = 1;
-	quat.x = 0;
-	quat.y = 0;
-	quat.z = 0;
+std::string TreadmillDeviceDriver::GetLatencyHistogramJson( const std::string &stage )
+{
+	const LatencyHistogram &histogram = *GetLatencyStage( stage );
 
-	pose.qWorldFromDriverRotation = quat;
-	pose.qDriverFromHeadRotation = quat;
+	std::string json;
+	AppendFormat( json, "{\"histogram\":\"%s\",\"unit\":\"us\",\"buckets\":[", stage.c_str() );
+	bool first = true;
+	for ( size_t i = 0; i < LatencyHistogram::BUCKETS; i++ )
+	{
+		uint64_t count = histogram.GetCount( i );
+		if ( count == 0 )
+			continue;
 
-	return pose;
+		AppendFormat( json, "%s[%llu,%llu]", first ? "" : ",",
+			static_cast< unsigned long long >( LatencyHistogram::GetUpperBound( i ) ), static_cast< unsigned long long >( count ) );
+		first = false;
+	}
+	json += "]}";
+	return json;
+}
+
+bool TreadmillDeviceDriver::WriteLatencyDump( const std::string &file )
+{
+	std::ofstream dump( file );
+	if ( !dump )
+		return false;
+
+	dump << "stage,count,p50_us,p90_us,p99_us,p999_us,max_us\n";
+	for ( const char *stage : latency_stage_names )
+	{
+		const LatencyHistogram &histogram = *GetLatencyStage( stage );
+		dump << stage << "," << histogram.GetTotalCount() << "," << histogram.GetPercentile( 0.5 ) << ","
+			<< histogram.GetPercentile( 0.9 ) << "," << histogram.GetPercentile( 0.99 ) << ","
+			<< histogram.GetPercentile( 0.999 ) << "," << histogram.GetMax() << "\n";
+	}
+
+	dump << "\nstage,lower_us,upper_us,count\n";
+	for ( const char *stage : latency_stage_names )
+	{
+		const LatencyHistogram &histogram = *GetLatencyStage( stage );
+		for ( size_t i = 0; i < LatencyHistogram::BUCKETS; i++ )
+		{
+			uint64_t count = histogram.GetCount( i );
+			if ( count > 0 )
+				dump << stage << "," << LatencyHistogram::GetLowerBound( i ) << "," << LatencyHistogram::GetUpperBound( i ) << "," << count << "\n";
+		}
+	}
+
+	return static_cast< bool >( dump );
+}
+
+std::string TreadmillDeviceDriver::GetConfigJson()
+{
+	// The capture thread replaces the profile after a calibration session.
+	CalibrationProfile calibration = treadmill_device_.GetCalibration();
+	const SpikeFilterSettings &spike_filter = pipeline_settings_.spike_filter;
+
+	std::string json;
+	AppendFormat( json, "{\"serial_number\":\"%s\"", serial_number_.c_str() );
+	AppendFormat( json, ",\"publish_mode\":\"%s\"", sample_driven_publishing_ ? "sample" : "frame" );
+	AppendFormat( json, ",\"keepalive_interval_s\":%.3f", std::chrono::duration< double >( keepalive_interval_ ).count() );
+	AppendFormat( json, ",\"response_curve\":\"%s\"", ResponseCurve::GetTypeName( response_curve_.GetType() ) );
+	static const char *direction_mode_names[] = { "forward", "hmd_yaw", "anchor" };
+	DirectionSettings direction = direction_settings_.Load();
+	AppendFormat( json, ",\"direction_mode\":\"%s\"", direction_mode_names[ static_cast< int >( direction.mode ) ] );
+	if ( direction.has_anchor )
+		AppendFormat( json, ",\"anchor\":{\"x\":%.3f,\"z\":%.3f}", direction.anchor_x, direction.anchor_z );
+	AppendFormat( json, ",\"tether_yaw_deg\":%.1f", direction.tether_yaw / DEGREES_TO_RADIANS );
+	AppendFormat( json, ",\"calibration\":{\"min\":%g,\"max\":%g}", calibration.min_value, calibration.max_value );
+
+	CalibrationProfile suggestion;
+	if ( treadmill_device_.GetCalibrationSuggestion( suggestion ) )
+		AppendFormat( json, ",\"suggested_calibration\":{\"min\":%g,\"max\":%g}", suggestion.min_value, suggestion.max_value );
+	else
+		json += ",\"suggested_calibration\":null";
+
+	AppendFormat( json, ",\"spike_filter\":{\"window\":%zu,\"threshold\":%g,\"min_deviation\":%g}",
+		spike_filter.window, spike_filter.threshold, spike_filter.min_deviation );
+	AppendFormat( json, ",\"auto_deadzone\":%s}", pipeline_settings_.noise_floor.enabled ? "true" : "false" );
+	return json;
+}
+
+vr::DriverPose_t TreadmillDeviceDriver::GetPose()
+{
+	// Without the hip pose the device has no pose, so this method is just returning a default Pose.
+	return hip_pose_.Load();
 }
 
 void TreadmillDeviceDriver::EnterStandby()
 {
+	DriverLog( "Treadmill entering standby" );
+	this->treadmill_device_.SetStandby( true );
+}
+
+void TreadmillDeviceDriver::LeaveStandby()
+{
+	DriverLog( "Treadmill leaving standby" );
+	this->treadmill_device_.SetStandby( false );
 }
 
 void TreadmillDeviceDriver::Deactivate()
 { 
+	// The publisher thread calls into vrserver, so it has to be gone before the index is invalidated.
+	is_publishing_ = false;
+	if ( publisher_thread_.joinable() )
+		publisher_thread_.join();
+
 	// unassign our controller index (we don't want to be calling vrserver anymore after Deactivate() has been called
 	controller_index_ = vr::k_unTrackedDeviceIndexInvalid;
 
 	this->treadmill_device_.StopBackgroundCapture();
+	anchor_calibrator_.Stop();
+
+	// Tools watching the block see the device disconnect before the block goes away.
+	if ( shared_metrics_.IsOpen() )
+	{
+		PublishSharedMetrics( this->treadmill_device_.GetTreadmillSample(), 0.0f, 0.0f, false );
+		shared_metrics_.Close();
+	}
+
+	if ( !latency_dump_file_.empty() && !WriteLatencyDump( latency_dump_file_ ) )
+		DriverLog( "Failed to write the latency dump %s", latency_dump_file_.c_str() );
+}
+
+bool TreadmillDeviceDriver::UsesHmdPose() const
+{
+	return direction_mapper_.GetSettings().mode != DirectionMode::FORWARD || publish_hip_pose_;
+}
+
+void TreadmillDeviceDriver::RunTreadmillFrame( const vr::TrackedDevicePose_t *hmd_pose )
+{
+	statistics_.frames.fetch_add( 1, std::memory_order_relaxed );
+
+	TreadmillSample sample = this->treadmill_device_.GetTreadmillSample();
+
+	if ( hmd_pose != nullptr && UsesHmdPose() )
+	{
+		const vr::HmdMatrix34_t &matrix = hmd_pose->mDeviceToAbsoluteTracking;
+		bool valid = hmd_pose->bPoseIsValid && hmd_pose->eTrackingResult == vr::TrackingResult_Running_OK;
+		float hmd_yaw = valid ? DirectionMapper::GetYaw( matrix.m ) : 0.0f;
+		double timestamp = std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+		relative_yaw_.store( direction_mapper_.Update( hmd_yaw, matrix.m[ 0 ][ 3 ], matrix.m[ 2 ][ 3 ], valid, sample.gait.phase != GaitPhase::IDLE, timestamp ), std::memory_order_relaxed );
+
+		if ( publish_hip_pose_ && controller_index_ != vr::k_unTrackedDeviceIndexInvalid )
+		{
+			const DirectionSettings &direction = direction_mapper_.GetSettings();
+			TrackingState state;
+			state.hmd_valid = valid;
+			state.hmd_x = matrix.m[ 0 ][ 3 ];
+			state.hmd_y = matrix.m[ 1 ][ 3 ];
+			state.hmd_z = matrix.m[ 2 ][ 3 ];
+			state.hmd_velocity_x = hmd_pose->vVelocity.v[ 0 ];
+			state.hmd_velocity_z = hmd_pose->vVelocity.v[ 2 ];
+			state.hmd_yaw = hmd_yaw;
+			state.has_anchor = direction.has_anchor;
+			state.anchor_x = direction.anchor_x;
+			state.anchor_z = direction.anchor_z;
+			state.rope_length = rope_length_;
+			state.stretch = rope_stretch_;
+
+			// SteamVR expects a pose update on every frame. The belt follows the headset of
+			// this frame and the latest force, which the publisher thread delivers in the
+			// sample driven mode.
+			vr::DriverPose_t pose = hip_pose_estimator_.Update( state, sample.value, sample.timestamp );
+			hip_pose_.Store( pose );
+			vr::VRServerDriverHost()->TrackedDevicePoseUpdated( controller_index_, pose, sizeof( vr::DriverPose_t ) );
+		}
+
+		// Every force sample is paired with the headset position once, so that the fit
+		// does not weight a sample by the frame rate.
+		if ( valid && sample.sequence != anchor_sequence_ && anchor_calibrator_.IsRunning() )
+		{
+			anchor_sequence_ = sample.sequence;
+			anchor_calibrator_.AddSample( matrix.m[ 0 ][ 3 ], matrix.m[ 2 ][ 3 ], sample.value );
+		}
+	}
+
+	// The direction axes follow the headset on every frame. In the sample driven mode the
+	// publisher thread only wakes up with a new sample, so the frame sends them as well.
+	if ( !sample_driven_publishing_ || direction_mapper_.GetSettings().mode != DirectionMode::FORWARD )
+		PublishInputs( sample );
+
+	CalibrationProfile calibration;
+	if ( this->treadmill_device_.TakeCalibrationResult( calibration ) )
+	{
+		// The new profile is already active on the capture thread. Storing it makes it
+		// survive a restart of SteamVR.
+		settings_.SetFloat( treadmill_settings_key_calibration_min, calibration.min_value );
+		settings_.SetFloat( treadmill_settings_key_calibration_max, calibration.max_value );
+		settings_.SetBool( treadmill_settings_key_calibration_mode, false );
+		DriverLog( "Calibration finished: %f to %f", calibration.min_value, calibration.max_value );
+	}
+
+	float tether_yaw;
+	if ( direction_mapper_.TakeCalibrationResult( tether_yaw ) )
+	{
+		settings_.SetFloat( treadmill_settings_key_tether_yaw, tether_yaw / DEGREES_TO_RADIANS );
+		settings_.SetBool( treadmill_settings_key_direction_calibration, false );
+		direction_settings_.Store( direction_mapper_.GetSettings() );
+		DriverLog( "Direction calibration finished: tether yaw %f degrees", tether_yaw / DEGREES_TO_RADIANS );
+	}
+
+	AnchorEstimate anchor;
+	if ( anchor_calibrator_.TakeResult( anchor ) )
+	{
+		direction_mapper_.SetAnchor( anchor.anchor_x, anchor.anchor_z );
+		direction_settings_.Store( direction_mapper_.GetSettings() );
+		settings_.SetFloat( treadmill_settings_key_anchor_x, anchor.anchor_x );
+		settings_.SetFloat( treadmill_settings_key_anchor_z, anchor.anchor_z );
+		settings_.SetFloat( treadmill_settings_key_rope_length, anchor.rope_length );
+		settings_.SetFloat( treadmill_settings_key_rope_stretch, anchor.stretch );
+		rope_length_ = anchor.rope_length;
+		rope_stretch_ = anchor.stretch;
+		settings_.SetBool( treadmill_settings_key_anchor_calibration, false );
+		DriverLog( "Anchor calibration finished: anchor at %f, %f, rope length %f m, residual %f m from %d samples",
+			anchor.anchor_x, anchor.anchor_z, anchor.rope_length, anchor.residual, static_cast< int >( anchor.samples ) );
+	}
+}
+
+void TreadmillDeviceDriver::PublishInputs( const TreadmillSample &sample )
+{
+	if ( controller_index_ == vr::k_unTrackedDeviceIndexInvalid )
+		return;
+
+	TraceScope trace( TraceEventId::PUBLISH_INPUTS );
+	std::lock_guard< std::mutex > lock( publish_lock_ );
+
+	// The load cell only sends a new sample every 100 ms, so most frames see the same
+	// sample again and do not need to evaluate the response curve.
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	// The frame and the publisher thread may race for a sample, an older one than the
+	// last published only updates the direction.
+	bool is_new_sample = sample.sequence > last_sequence_;
+	if ( is_new_sample )
+	{
+		last_sequence_ = sample.sequence;
+
+		double now_seconds = std::chrono::duration< double >( now.time_since_epoch() ).count();
+		statistics_.consumed_samples.fetch_add( 1, std::memory_order_relaxed );
+		statistics_.sample_latency.RecordSeconds( now_seconds - sample.publish_time );
+		if ( sample.first_byte_time > 0.0 )
+			statistics_.total_latency.RecordSeconds( now_seconds - sample.first_byte_time );
+
+		force_ = response_curve_.Evaluate( sample.value );
+
+		// The acceleration follows the slow force trend of the gait detector, the raw force
+		// rises and falls with every step. A trend change of 1 per second is full scale.
+		// Standing still is no acceleration, whatever the force does.
+		float accel = 0.0f;
+		double dt = sample.timestamp - last_sample_time_;
+		if ( last_sample_time_ > 0.0 && dt > 0.0 && sample.gait.phase != GaitPhase::IDLE )
+		{
+			accel = std::min( std::max( static_cast< float >( ( sample.gait.trend - last_trend_ ) / dt ), -1.0f ), 1.0f );
+			accel = std::round( accel / ACCEL_STEP ) * ACCEL_STEP;
+		}
+		last_trend_ = sample.gait.trend;
+		last_sample_time_ = sample.timestamp;
+
+		input_values_[ TreadmillComponents::TRIGGER_VALUE ] = force_;
+		input_values_[ TreadmillComponents::SPEED_VALUE ] = sample.gait.cadence_speed;
+		input_values_[ TreadmillComponents::ACCEL_VALUE ] = accel;
+		input_values_[ TreadmillComponents::WALKING_CLICK ] = sample.gait.phase == GaitPhase::WALKING ? 1.0f : 0.0f;
+		input_values_[ TreadmillComponents::RUNNING_CLICK ] = sample.gait.phase == GaitPhase::RUNNING ? 1.0f : 0.0f;
+	}
+
+	// The direction changes with every frame, the split itself is a few multiplications.
+	// In the forward mode the relative yaw stays 0, which yields exactly x = 0 and y = force.
+	float x;
+	float y;
+	DirectionMapper::Split( force_, relative_yaw_.load( std::memory_order_relaxed ), x, y );
+
+	// The trigger is one-sided and always shows the force, the two-sided axes carry the
+	// direction of the device, e.g. -1 for a rope pulling backwards.
+	input_values_[ TreadmillComponents::TRACKPAD_Y ] = y * input_scale_;
+	input_values_[ TreadmillComponents::JOYSTICK_Y ] = y * input_scale_;
+	input_values_[ TreadmillComponents::TRACKPAD_X ] = x * input_scale_;
+	input_values_[ TreadmillComponents::JOYSTICK_X ] = x * input_scale_;
+
+	// Between two samples only the direction axes can change, so the remaining components
+	// are only looked at with a new sample or once the earliest keep-alive is due.
+	bool check_all = is_new_sample || now >= next_keepalive_;
+	int first = check_all ? 0 : TreadmillComponents::TRACKPAD_Y;
+	int last = check_all ? TreadmillComponents::MAX : TreadmillComponents::JOYSTICK_X + 1;
+
+	for ( int i = first; i < last; i++ )
+	{
+		bool changed = !is_published_[ i ] || input_values_[ i ] != published_values_[ i ];
+		bool keepalive_due = now - published_times_[ i ] >= keepalive_interval_;
+		if ( !changed && !keepalive_due )
+			continue;
+
+		if ( i >= TreadmillComponents::WALKING_CLICK )
+			vr::VRDriverInput()->UpdateBooleanComponent( input_handles_[ i ], input_values_[ i ] != 0.0f, 0 );
+		else
+			vr::VRDriverInput()->UpdateScalarComponent( input_handles_[ i ], input_values_[ i ], 0 );
+		statistics_.input_updates.fetch_add( 1, std::memory_order_relaxed );
+		published_values_[ i ] = input_values_[ i ];
+		published_times_[ i ] = now;
+		is_published_[ i ] = true;
+	}
+
+	if ( check_all )
+		next_keepalive_ = *std::min_element( published_times_.begin(), published_times_.end() ) + keepalive_interval_;
+
+	if ( is_new_sample && shared_metrics_.IsOpen() )
+		PublishSharedMetrics( sample, x * input_scale_, y * input_scale_, treadmill_device_.isConnected() );
+}
+
+void TreadmillDeviceDriver::PublishSharedMetrics( const TreadmillSample &sample, float axis_x, float axis_y, bool connected )
+{
+	CaptureStatistics &capture = treadmill_device_.GetStatistics();
+
+	SharedMetricsValues values;
+	values.timestamp = sample.timestamp;
+	values.first_byte_time = sample.first_byte_time;
+	values.publish_time = sample.publish_time;
+	values.write_time = std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	values.sample_sequence = sample.sequence;
+	values.samples = capture.samples.load( std::memory_order_relaxed );
+	values.read_errors = capture.read_errors.load( std::memory_order_relaxed );
+	values.reconnects = capture.reconnects.load( std::memory_order_relaxed );
+	values.removed_spikes = capture.removed_spikes.load( std::memory_order_relaxed );
+	values.frames = statistics_.frames.load( std::memory_order_relaxed );
+	values.input_updates = statistics_.input_updates.load( std::memory_order_relaxed );
+	values.consumed_samples = statistics_.consumed_samples.load( std::memory_order_relaxed );
+	values.value = sample.value;
+	values.force = force_;
+	values.axis_x = axis_x;
+	values.axis_y = axis_y;
+	values.cadence = sample.gait.cadence;
+	values.gait_phase = static_cast< uint32_t >( sample.gait.phase );
+	values.connected = connected ? 1 : 0;
+	values.standby = treadmill_device_.isStandby() ? 1 : 0;
+	shared_metrics_.Publish( values );
 }
 
-void TreadmillDeviceDriver::RunTreadmillFrame()
+void TreadmillDeviceDriver::PublisherLoop()
 {
-	float treadmill_value = this->treadmill_device_.GetTreadmillValue();
+	// The timeout bounds how long Deactivate() waits for the thread and keeps the
+	// keep-alive updates going while the device sends nothing. In standby only a
+	// heartbeat arrives, so the thread may sleep longer.
+	const std::chrono::milliseconds wait_timeout( 50 );
+	const std::chrono::milliseconds standby_wait_timeout( 500 );
+
+	Tracer::SetThreadName( "publisher" );
 
-	vr::VRDriverInput()->UpdateScalarComponent(input_handles_[TreadmillComponents::TRIGGER_VALUE], treadmill_value, 0);
-	vr::VRDriverInput()->UpdateScalarComponent(input_handles_[TreadmillComponents::TRACKPAD_Y], treadmill_value, 0);
-	vr::VRDriverInput()->UpdateScalarComponent(input_handles_[TreadmillComponents::JOYSTICK_Y], treadmill_value, 0);
-	vr::VRDriverInput()->UpdateScalarComponent(input_handles_[TreadmillComponents::TRACKPAD_X], 0.0f, 0);
-	vr::VRDriverInput()->UpdateScalarComponent(input_handles_[TreadmillComponents::JOYSTICK_X], 0.0f, 0);
+	TreadmillSample sample;
+	while ( is_publishing_ )
+	{
+		uint64_t last_sequence;
+		{
+			std::lock_guard< std::mutex > lock( publish_lock_ );
+			last_sequence = last_sequence_;
+		}
+		bool standby = this->treadmill_device_.isStandby();
+		this->treadmill_device_.WaitForSample( last_sequence, standby ? standby_wait_timeout : wait_timeout, sample );
+		statistics_.publisher_wakeups.fetch_add( 1, std::memory_order_relaxed );
+		PublishInputs( sample );
+	}
 }
 
 void TreadmillDeviceDriver::ProcessTreadmillEvent( const vr::VREvent_t &vrevent )
 {
 }
 
+SignalPipelineSettings TreadmillDeviceDriver::LoadPipelineSettings()
+{
+	SignalPipelineSettings settings;
+
+	settings.calibration.min_value = settings_.GetFloat( treadmill_settings_key_calibration_min );
+	settings.calibration.max_value = settings_.GetFloat( treadmill_settings_key_calibration_max );
+	if ( !( settings.calibration.max_value > settings.calibration.min_value ) )
+	{
+		DriverLog( "Invalid calibration range, using 0 to 1" );
+		settings.calibration = CalibrationProfile();
+	}
+
+	int32_t spike_filter_window = settings_.GetInt32( treadmill_settings_key_spike_filter_window );
+	settings.spike_filter.window = spike_filter_window > 0 ? static_cast< size_t >( spike_filter_window ) : 0;
+	settings.spike_filter.threshold = settings_.GetFloat( treadmill_settings_key_spike_filter_threshold );
+	settings.spike_filter.min_deviation = settings_.GetFloat( treadmill_settings_key_spike_filter_min_deviation );
+
+	settings.noise_floor.enabled = settings_.GetBool( treadmill_settings_key_auto_deadzone );
+	settings.noise_floor.idle_band = settings_.GetFloat( treadmill_settings_key_idle_band );
+	settings.noise_floor.max_baseline = settings_.GetFloat( treadmill_settings_key_max_idle_baseline );
+
+	return settings;
+}
+
+DirectionSettings TreadmillDeviceDriver::LoadDirectionSettings()
+{
+	DirectionSettings settings;
+
+	std::string mode_name = settings_.GetString( treadmill_settings_key_direction_mode );
+	if ( !mode_name.empty() && !DirectionMapper::ParseMode( mode_name, settings.mode ) )
+		DriverLog( "Unknown direction mode '%s', using forward", mode_name.c_str() );
+
+	settings.tether_yaw = settings_.GetFloat( treadmill_settings_key_tether_yaw ) * DEGREES_TO_RADIANS;
+	settings.max_angle = settings_.GetFloat( treadmill_settings_key_direction_max_angle ) * DEGREES_TO_RADIANS;
+
+	// A rope length of 0 marks an anchor that was never calibrated.
+	settings.has_anchor = settings_.GetFloat( treadmill_settings_key_rope_length ) > 0.0f;
+	settings.anchor_x = settings_.GetFloat( treadmill_settings_key_anchor_x );
+	settings.anchor_z = settings_.GetFloat( treadmill_settings_key_anchor_z );
+
+	return settings;
+}
+
+void TreadmillDeviceDriver::LoadResponseCurve()
+{
+	std::string curve_name = settings_.GetString( treadmill_settings_key_response_curve );
+
+	ResponseCurveType curve_type = ResponseCurveType::LINEAR;
+	if ( !curve_name.empty() && !ResponseCurve::ParseType( curve_name, curve_type ) )
+		DriverLog( "Unknown response curve '%s', using linear", curve_name.c_str() );
+
+	if ( curve_type == ResponseCurveType::CUSTOM )
+	{
+		std::string curve_points = settings_.GetString( treadmill_settings_key_response_curve_points );
+
+		if ( !response_curve_.FromPoints( curve_points ) )
+			DriverLog( "Invalid response curve points '%s', using linear", curve_points.c_str() );
+		return;
+	}
+
+	float gamma = settings_.GetFloat( treadmill_settings_key_response_curve_gamma );
+	response_curve_ = ResponseCurve( curve_type, gamma );
+	if ( response_curve_.GetType() != curve_type )
+		DriverLog( "Invalid response curve gamma %f, using linear", gamma );
+}
+
 const std::string & TreadmillDeviceDriver::GetSerialNumber()
 {
 	return serial_number_;
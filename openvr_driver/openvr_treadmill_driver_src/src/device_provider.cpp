@@ -1,21 +1,64 @@
 #include "device_provider.h"
 
+#include <sstream>
+
 #include "driverlog.h"
+#include "tracing.h"
+
+static const char *treadmill_settings_key_devices = "devices";
+static const char *treadmill_settings_key_tracing = "tracing";
+static const char *treadmill_settings_key_trace_file = "trace_file";
 
 
 vr::EVRInitError MyDeviceProvider::Init( vr::IVRDriverContext *pDriverContext )
 {
 	VR_INIT_SERVER_DRIVER_CONTEXT( pDriverContext );
+	InitDriverLog();
 
-	// Let's add our controllers to the system.
-	treadmill_device_ = std::make_unique< TreadmillDeviceDriver >(vr::TrackedControllerRole_Treadmill);
+	// Init runs on the thread that calls RunFrame later.
+	Tracer::SetThreadName( "vrserver frame" );
+	if ( vr::VRSettings()->GetBool( treadmill_main_settings_section, treadmill_settings_key_tracing ) )
+		Tracer::Start();
 
-	// Now we need to tell vrserver about our controllers.
-	if ( !vr::VRServerDriverHost()->TrackedDeviceAdded(treadmill_device_->GetSerialNumber().c_str(), vr::TrackedDeviceClass_Controller, treadmill_device_.get() ) )
+	// Without a device list the driver runs the single device configured in the main section.
+	std::vector< DeviceSettings > device_settings;
+	char device_list[ 1024 ] = { 0 };
+	vr::VRSettings()->GetString( treadmill_main_settings_section, treadmill_settings_key_devices, device_list, sizeof( device_list ) );
+
+	std::stringstream devices( device_list );
+	std::string device_id;
+	while ( std::getline( devices, device_id, ',' ) )
 	{
-		DriverLog( "Failed to create treadmill device!" );
-		return vr::VRInitError_Driver_Unknown;
+		device_id.erase( 0, device_id.find_first_not_of( ' ' ) );
+		device_id.erase( device_id.find_last_not_of( ' ' ) + 1 );
+		if ( !device_id.empty() )
+			device_settings.emplace_back( device_id );
 	}
+	if ( device_settings.empty() )
+		device_settings.emplace_back();
+
+	// Let's add our controllers to the system. The list is final after this, so that RunFrame
+	// never allocates.
+	treadmill_devices_.reserve( device_settings.size() );
+	for ( const DeviceSettings &settings : device_settings )
+	{
+		std::unique_ptr< TreadmillDeviceDriver > device = std::make_unique< TreadmillDeviceDriver >( settings );
+
+		// Now we need to tell vrserver about our controllers.
+		if ( !vr::VRServerDriverHost()->TrackedDeviceAdded( device->GetSerialNumber().c_str(), vr::TrackedDeviceClass_Controller, device.get() ) )
+		{
+			DriverLog( "Failed to create treadmill device %s!", device->GetSerialNumber().c_str() );
+			continue;
+		}
+		treadmill_devices_.push_back( std::move( device ) );
+	}
+
+	if ( treadmill_devices_.empty() )
+		return vr::VRInitError_Driver_Unknown;
+
+	needs_hmd_pose_ = false;
+	for ( const std::unique_ptr< TreadmillDeviceDriver > &device : treadmill_devices_ )
+		needs_hmd_pose_ = needs_hmd_pose_ || device->UsesHmdPose();
 
 	return vr::VRInitError_None;
 }
@@ -34,23 +77,56 @@ bool MyDeviceProvider::ShouldBlockStandbyMode()
 // *main driver loop*
 void MyDeviceProvider::RunFrame()
 {
+	TraceScope trace( TraceEventId::RUN_FRAME );
+
+	// The HMD pose is fetched once for all devices and only if any of them needs it.
+	vr::TrackedDevicePose_t hmd_pose = {};
+	const vr::TrackedDevicePose_t *hmd_pose_pointer = nullptr;
+	if (this->needs_hmd_pose_)
+	{
+		vr::VRServerDriverHost()->GetRawTrackedDevicePoses( 0.0f, &hmd_pose, 1 );
+		hmd_pose_pointer = &hmd_pose;
+	}
+
 	// call our devices to run a frame
-	if (this->treadmill_device_ != nullptr)
+	for (const std::unique_ptr< TreadmillDeviceDriver > &device : this->treadmill_devices_)
 	{
-		this->treadmill_device_->RunTreadmillFrame();
+		device->RunTreadmillFrame( hmd_pose_pointer );
 	}
 }
 
 void MyDeviceProvider::EnterStandby()
 {
+	for (const std::unique_ptr< TreadmillDeviceDriver > &device : this->treadmill_devices_)
+	{
+		device->EnterStandby();
+	}
 }
 
 void MyDeviceProvider::LeaveStandby()
 {
+	for (const std::unique_ptr< TreadmillDeviceDriver > &device : this->treadmill_devices_)
+	{
+		device->LeaveStandby();
+	}
 }
 
 void MyDeviceProvider::Cleanup()
 {
-	this->treadmill_device_->Deactivate();
-	this->treadmill_device_ = nullptr;
+	for (const std::unique_ptr< TreadmillDeviceDriver > &device : this->treadmill_devices_)
+	{
+		device->Deactivate();
+	}
+	this->treadmill_devices_.clear();
+
+	// A trace recorded during the session is written when SteamVR shuts down.
+	std::string trace_file = DeviceSettings().GetFilePath( treadmill_settings_key_trace_file );
+	if ( Tracer::IsEnabled() && !trace_file.empty() )
+	{
+		Tracer::Stop();
+		if ( !Tracer::WriteChromeTrace( trace_file ) )
+			DriverLog( "Failed to write the trace %s", trace_file.c_str() );
+	}
+
+	CleanupDriverLog();
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "device_settings.h"
+
+#include <cctype>
+
+#include "driverlog.h"
+
+DeviceSettings::DeviceSettings()
+	: section_( treadmill_main_settings_section )
+{
+}
+
+DeviceSettings::DeviceSettings( const std::string &device_id )
+	: device_id_( device_id ), section_( std::string( treadmill_main_settings_section ) + "_" + device_id )
+{
+}
+
+bool DeviceSettings::GetBool( const char *key ) const
+{
+	vr::EVRSettingsError error = vr::VRSettingsError_None;
+	bool value = vr::VRSettings()->GetBool( section_.c_str(), key, &error );
+	if ( error != vr::VRSettingsError_None )
+		value = vr::VRSettings()->GetBool( treadmill_main_settings_section, key );
+	return value;
+}
+
+int32_t DeviceSettings::GetInt32( const char *key ) const
+{
+	vr::EVRSettingsError error = vr::VRSettingsError_None;
+	int32_t value = vr::VRSettings()->GetInt32( section_.c_str(), key, &error );
+	if ( error != vr::VRSettingsError_None )
+		value = vr::VRSettings()->GetInt32( treadmill_main_settings_section, key );
+	return value;
+}
+
+float DeviceSettings::GetFloat( const char *key ) const
+{
+	vr::EVRSettingsError error = vr::VRSettingsError_None;
+	float value = vr::VRSettings()->GetFloat( section_.c_str(), key, &error );
+	if ( error != vr::VRSettingsError_None )
+		value = vr::VRSettings()->GetFloat( treadmill_main_settings_section, key );
+	return value;
+}
+
+std::string DeviceSettings::GetString( const char *key ) const
+{
+	char value[ 1024 ] = { 0 };
+	vr::EVRSettingsError error = vr::VRSettingsError_None;
+	vr::VRSettings()->GetString( section_.c_str(), key, value, sizeof( value ), &error );
+	if ( error != vr::VRSettingsError_None )
+		vr::VRSettings()->GetString( treadmill_main_settings_section, key, value, sizeof( value ) );
+	return value;
+}
+
+std::string DeviceSettings::GetFilePath( const char *key ) const
+{
+	std::string file = GetString( key );
+	if ( file.empty() || file[ 0 ] == '/' || file[ 0 ] == '\\' )
+		return file;
+	if ( file.size() > 2 && std::isalpha( static_cast< unsigned char >( file[ 0 ] ) ) && file[ 1 ] == ':' && ( file[ 2 ] == '\\' || file[ 2 ] == '/' ) )
+		return file;
+
+	DriverLog( "%s '%s' is not an absolute path, ignoring it", key, file.c_str() );
+	return std::string();
+}
+
+void DeviceSettings::SetBool( const char *key, bool value ) const
+{
+	vr::VRSettings()->SetBool( section_.c_str(), key, value );
+}
+
+void DeviceSettings::SetFloat( const char *key, float value ) const
+{
+	vr::VRSettings()->SetFloat( section_.c_str(), key, value );
+}
+
+const std::string &DeviceSettings::GetDeviceId() const
+{
+	return device_id_;
+}
+
+const std::string &DeviceSettings::GetSection() const
+{
+	return section_;
+}
@@ -0,0 +1,111 @@
+#include "direction_mapper.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const float PI = 3.14159265f;
+
+/**
+ * Wraps an angle into [-pi, pi).
+ */
+static float WrapAngle(float angle)
+{
+    angle = std::fmod(angle + PI, 2.0f * PI);
+    if (angle < 0.0f)
+        angle += 2.0f * PI;
+    return angle - PI;
+}
+
+DirectionMapper::DirectionMapper(const DirectionSettings& settings)
+    : settings_(settings)
+{
+    // The polynomial approximation of Split() is only valid up to a quarter turn.
+    this->settings_.max_angle = std::min(std::max(settings.max_angle, 0.0f), PI / 2.0f);
+}
+
+bool DirectionMapper::ParseMode(const std::string& name, DirectionMode& mode)
+{
+    if (name == "forward")
+        mode = DirectionMode::FORWARD;
+    else if (name == "hmd_yaw")
+        mode = DirectionMode::HMD_YAW;
+    else if (name == "anchor")
+        mode = DirectionMode::ANCHOR;
+    else
+        return false;
+    return true;
+}
+
+float DirectionMapper::GetYaw(const float (&matrix)[3][4])
+{
+    // The HMD looks along its -Z axis, the third column holds that axis in tracking space.
+    return std::atan2(-matrix[0][2], matrix[2][2]);
+}
+
+float DirectionMapper::Update(float hmd_yaw, float hmd_x, float hmd_z, bool valid, bool walking, double timestamp)
+{
+    float dt = static_cast<float>(timestamp - this->last_timestamp_);
+    this->last_timestamp_ = timestamp;
+
+    if (this->settings_.mode == DirectionMode::FORWARD || !valid)
+        return this->relative_yaw_;
+
+    if (this->calibrating_ && walking && dt > 0.0f && dt < 0.5f)
+    {
+        // The yaw is averaged as a unit vector, so that the wrap around at +-pi
+        // does not pull the mean to the opposite side.
+        this->calibration_sin_ += dt * std::sin(hmd_yaw);
+        this->calibration_cos_ += dt * std::cos(hmd_yaw);
+        this->calibration_elapsed_ += dt;
+
+        if (this->calibration_elapsed_ >= this->settings_.calibration_time)
+        {
+            this->settings_.tether_yaw = std::atan2(this->calibration_sin_, this->calibration_cos_);
+            this->calibrating_ = false;
+            this->has_calibration_result_ = true;
+        }
+    }
+
+    if (this->settings_.mode == DirectionMode::ANCHOR && this->settings_.has_anchor)
+    {
+        // Right above the anchor the direction is undefined, the last one is kept there.
+        float dx = hmd_x - this->settings_.anchor_x;
+        float dz = hmd_z - this->settings_.anchor_z;
+        if (dx * dx + dz * dz > 0.04f)
+            this->settings_.tether_yaw = std::atan2(dx, -dz);
+    }
+
+    float relative_yaw = WrapAngle(hmd_yaw - this->settings_.tether_yaw);
+    this->relative_yaw_ = std::min(std::max(relative_yaw, -this->settings_.max_angle), this->settings_.max_angle);
+    return this->relative_yaw_;
+}
+
+void DirectionMapper::SetAnchor(float anchor_x, float anchor_z)
+{
+    this->settings_.has_anchor = true;
+    this->settings_.anchor_x = anchor_x;
+    this->settings_.anchor_z = anchor_z;
+}
+
+void DirectionMapper::StartCalibration()
+{
+    this->calibrating_ = true;
+    this->calibration_sin_ = 0.0f;
+    this->calibration_cos_ = 0.0f;
+    this->calibration_elapsed_ = 0.0f;
+}
+
+bool DirectionMapper::TakeCalibrationResult(float& tether_yaw)
+{
+    if (!this->has_calibration_result_)
+        return false;
+
+    this->has_calibration_result_ = false;
+    tether_yaw = this->settings_.tether_yaw;
+    return true;
+}
+
+const DirectionSettings& DirectionMapper::GetSettings() const
+{
+    return this->settings_;
+}
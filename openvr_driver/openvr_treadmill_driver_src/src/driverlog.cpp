@@ -4,16 +4,39 @@
 #include <stdarg.h>
 #include <stdio.h>
 
-#if !defined( WIN32 )
-#define vsnprintf_s vsnprintf
-#endif
+#include "log_queue.h"
+
+// The capture and frame threads only format their messages into the queue, vrserver's log
+// I/O happens on the flusher thread.
+static LogQueue log_queue;
+
+static void WriteDriverLog( const char *pMessage )
+{
+	vr::VRDriverLog()->Log( pMessage );
+}
 
 static void DriverLogVarArgs( const char *pMsgFormat, va_list args )
 {
-	char buf[ 1024 ];
-	vsnprintf_s( buf, sizeof( buf ), pMsgFormat, args );
+	// Before the start and after the stop of the queue the message is written right away.
+	if ( log_queue.EnqueueWhileRunning( pMsgFormat, args ) )
+		return;
+
+	char buf[ LogQueue::MAX_MESSAGE_LENGTH ];
+	vsnprintf( buf, sizeof( buf ), pMsgFormat, args );
+
+	WriteDriverLog( buf );
+}
+
+
+void InitDriverLog()
+{
+	log_queue.Start( WriteDriverLog );
+}
+
 
-	vr::VRDriverLog()->Log( buf );
+void CleanupDriverLog()
+{
+	log_queue.Stop();
 }
 
 
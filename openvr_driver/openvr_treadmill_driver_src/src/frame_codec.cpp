@@ -0,0 +1,45 @@
+#include "frame_codec.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+void FrameCodec::Encode(float value, uint8_t* frame)
+{
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    frame[0] = SYNC_BYTE;
+    for (size_t i = 0; i < sizeof(bits); i++)
+        frame[1 + i] = static_cast<uint8_t>(bits >> (8 * i));
+    frame[5] = FrameCodec::Crc8(frame + 1, sizeof(bits));
+}
+
+float FrameCodec::Decode(const uint8_t* frame)
+{
+    if (frame[0] != SYNC_BYTE || FrameCodec::Crc8(frame + 1, 4) != frame[5])
+        return std::numeric_limits<float>::quiet_NaN();
+
+    uint32_t bits = 0;
+    for (size_t i = 0; i < sizeof(bits); i++)
+        bits |= static_cast<uint32_t>(frame[1 + i]) << (8 * i);
+
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    if (!std::isfinite(value))
+        return std::numeric_limits<float>::quiet_NaN();
+    return value;
+}
+
+uint8_t FrameCodec::Crc8(const uint8_t* data, size_t size)
+{
+    // Bitwise, a frame has 4 bytes and the module has no room for a table.
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+    }
+    return crc;
+}
@@ -0,0 +1,173 @@
+#include "gait_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+GaitDetector::GaitDetector(const GaitDetectorSettings& settings)
+    : settings_(settings)
+{
+}
+
+const GaitState& GaitDetector::AddSample(float value, double timestamp)
+{
+    this->state_.step_event = false;
+    this->state_.onset_event = false;
+
+    if (!this->has_sample_)
+    {
+        this->has_sample_ = true;
+        this->state_.trend = value;
+        this->last_value_ = value;
+        this->last_timestamp_ = timestamp;
+        return this->state_;
+    }
+
+    // The trend is an EMA with a time constant instead of a fixed alpha, so that
+    // irregular sample intervals of the serial connection do not distort it.
+    float dt = static_cast<float>(timestamp - this->last_timestamp_);
+    if (dt > 0.0f)
+    {
+        float alpha = 1.0f - std::exp(-dt / this->settings_.trend_time_constant);
+        this->state_.trend += alpha * (value - this->state_.trend);
+    }
+
+    float slope = value - this->last_value_;
+    bool step_allowed = (timestamp - this->last_step_timestamp_) >= this->settings_.min_step_interval;
+
+    if (this->state_.phase == GaitPhase::IDLE &&
+        value >= this->settings_.onset_force &&
+        slope >= this->settings_.onset_slope &&
+        step_allowed)
+    {
+        // The first push out of idle is reported immediately instead of waiting
+        // for the first stride peak to be confirmed.
+        this->state_.onset_event = true;
+        this->RegisterStep(timestamp);
+        this->searching_peak_ = true;
+        this->onset_stride_ = true;
+        this->extremum_ = value;
+    }
+    else if (this->searching_peak_)
+    {
+        // Every stride produces one force peak. It is confirmed once the force fell
+        // back by the prominence, which rejects the small ripples on the flanks.
+        if (value > this->extremum_)
+        {
+            this->extremum_ = value;
+        }
+        else if (value < this->extremum_ - this->settings_.step_prominence)
+        {
+            // The peak of the stride that started with the onset is no step of its own.
+            if (step_allowed && this->state_.phase != GaitPhase::IDLE && !this->onset_stride_)
+                this->RegisterStep(timestamp);
+            this->onset_stride_ = false;
+            this->searching_peak_ = false;
+            this->extremum_ = value;
+        }
+    }
+    else
+    {
+        if (value < this->extremum_)
+        {
+            this->extremum_ = value;
+        }
+        else if (value > this->extremum_ + this->settings_.step_prominence)
+        {
+            this->searching_peak_ = true;
+            this->extremum_ = value;
+        }
+    }
+
+    this->last_value_ = value;
+    this->last_timestamp_ = timestamp;
+    this->UpdatePhase(timestamp);
+    return this->state_;
+}
+
+const GaitState& GaitDetector::GetState() const
+{
+    return this->state_;
+}
+
+void GaitDetector::Reset()
+{
+    *this = GaitDetector(this->settings_);
+}
+
+void GaitDetector::RegisterStep(double timestamp)
+{
+    float interval = static_cast<float>(timestamp - this->last_step_timestamp_);
+    bool has_previous_step = this->state_.step_count > 0;
+
+    this->state_.step_event = true;
+    this->state_.step_count++;
+    this->last_step_timestamp_ = timestamp;
+
+    if (!has_previous_step || interval > this->settings_.max_step_interval)
+    {
+        this->step_intervals_ = 0;
+        return;
+    }
+
+    // Smooth the step interval rather than the cadence itself, which keeps the
+    // estimate unbiased when the intervals jitter by a sample period.
+    if (this->step_interval_ <= 0.0f)
+        this->step_interval_ = interval;
+    else
+        this->step_interval_ += 0.3f * (interval - this->step_interval_);
+
+    this->step_intervals_++;
+    if (this->step_intervals_ < this->settings_.min_cadence_intervals)
+        return;
+
+    this->state_.cadence = 60.0f / this->step_interval_;
+    float speed = (this->state_.cadence - this->settings_.min_cadence) /
+                  (this->settings_.max_cadence - this->settings_.min_cadence);
+    this->state_.cadence_speed = std::min(std::max(speed, 0.0f), 1.0f);
+}
+
+void GaitDetector::UpdatePhase(double timestamp)
+{
+    const GaitDetectorSettings& s = this->settings_;
+    float since_last_step = static_cast<float>(timestamp - this->last_step_timestamp_);
+    bool recent_step = this->state_.step_count > 0 && since_last_step < s.idle_timeout;
+
+    // When the steps stop, the cadence must not stay at its last value until the
+    // idle timeout. It is limited by the time since the last step instead.
+    if (this->state_.cadence > 0.0f && since_last_step > this->step_interval_)
+    {
+        this->state_.cadence = std::min(this->state_.cadence, 60.0f / since_last_step);
+        float speed = (this->state_.cadence - s.min_cadence) / (s.max_cadence - s.min_cadence);
+        this->state_.cadence_speed = std::min(std::max(speed, 0.0f), 1.0f);
+    }
+
+    switch (this->state_.phase)
+    {
+    case GaitPhase::IDLE:
+        if (this->state_.onset_event || this->state_.step_event)
+            this->state_.phase = GaitPhase::WALKING;
+        break;
+
+    case GaitPhase::WALKING:
+        if (!recent_step && this->state_.trend < s.idle_force)
+            this->state_.phase = GaitPhase::IDLE;
+        else if (this->state_.cadence >= s.run_cadence_enter || this->state_.trend >= s.run_force_enter)
+            this->state_.phase = GaitPhase::RUNNING;
+        break;
+
+    case GaitPhase::RUNNING:
+        if (!recent_step && this->state_.trend < s.idle_force)
+            this->state_.phase = GaitPhase::IDLE;
+        else if (this->state_.cadence < s.run_cadence_exit && this->state_.trend < s.run_force_exit)
+            this->state_.phase = GaitPhase::WALKING;
+        break;
+    }
+
+    if (this->state_.phase == GaitPhase::IDLE)
+    {
+        this->step_interval_ = 0.0f;
+        this->step_intervals_ = 0;
+        this->state_.cadence = 0.0f;
+        this->state_.cadence_speed = 0.0f;
+    }
+}
@@ -0,0 +1,90 @@
+#include "hip_pose_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+HipPoseEstimator::HipPoseEstimator(const HipPoseSettings& settings)
+    : settings_(settings)
+{
+}
+
+vr::DriverPose_t HipPoseEstimator::GetInvalidPose()
+{
+    vr::DriverPose_t pose = { 0 };
+    pose.poseIsValid = false;
+    pose.result = vr::TrackingResult_Calibrating_OutOfRange;
+    pose.deviceIsConnected = true;
+
+    vr::HmdQuaternion_t quat;
+    quat.w = 1;
+    quat.x = 0;
+    quat.y = 0;
+    quat.z = 0;
+
+    pose.qWorldFromDriverRotation = quat;
+    pose.qDriverFromHeadRotation = quat;
+    pose.qRotation = quat;
+    return pose;
+}
+
+vr::DriverPose_t HipPoseEstimator::Update(const TrackingState& tracking, float force, double sample_timestamp)
+{
+    // The force derivative needs two samples, a gap of more than a few samples
+    // restarts it. The frames between two samples keep the rate of the last one.
+    if (!this->has_previous_ || sample_timestamp != this->previous_timestamp_)
+    {
+        double dt = sample_timestamp - this->previous_timestamp_;
+        this->force_rate_ = 0.0f;
+        if (this->has_previous_ && dt > 0.0 && dt < 0.5)
+            this->force_rate_ = static_cast<float>((force - this->previous_force_) / dt);
+        this->has_previous_ = true;
+        this->previous_force_ = force;
+        this->previous_timestamp_ = sample_timestamp;
+    }
+    float force_rate = this->force_rate_;
+
+    vr::DriverPose_t pose = GetInvalidPose();
+    if (!tracking.hmd_valid || !tracking.has_anchor)
+        return pose;
+
+    float dx = tracking.hmd_x - tracking.anchor_x;
+    float dz = tracking.hmd_z - tracking.anchor_z;
+    float distance = std::sqrt(dx * dx + dz * dz);
+    if (distance < 0.05f)
+        return pose;
+
+    // Unit vector pointing away from the anchor.
+    float ux = dx / distance;
+    float uz = dz / distance;
+    float radius = tracking.rope_length + tracking.stretch * std::max(force, 0.0f);
+
+    pose.vecPosition[0] = tracking.anchor_x + ux * radius;
+    pose.vecPosition[1] = tracking.hmd_y - this->settings_.hip_offset;
+    pose.vecPosition[2] = tracking.anchor_z + uz * radius;
+
+    float radial_velocity = tracking.stretch * force_rate;
+    float hmd_radial_velocity = tracking.hmd_velocity_x * ux + tracking.hmd_velocity_z * uz;
+    pose.vecVelocity[0] = tracking.hmd_velocity_x + (radial_velocity - hmd_radial_velocity) * ux;
+    pose.vecVelocity[1] = 0.0;
+    pose.vecVelocity[2] = tracking.hmd_velocity_z + (radial_velocity - hmd_radial_velocity) * uz;
+
+    // Facing away from the anchor is the -Z axis of the belt. A positive yaw turns right,
+    // which is a negative rotation about the vertical axis.
+    float tether_yaw = std::atan2(ux, -uz);
+    float relative_yaw = std::remainder(tracking.hmd_yaw - tether_yaw, 6.28318531f);
+    relative_yaw = std::min(std::max(relative_yaw, -this->settings_.max_hip_angle), this->settings_.max_hip_angle);
+    float yaw = tether_yaw + relative_yaw;
+    pose.qRotation.w = std::cos(-0.5f * yaw);
+    pose.qRotation.x = 0.0;
+    pose.qRotation.y = std::sin(-0.5f * yaw);
+    pose.qRotation.z = 0.0;
+
+    // The position follows the HMD state of this frame, so the pose describes the
+    // present. Dating it back to the force sample would make the runtime extrapolate
+    // the HMD motion a second time and overshoot.
+    pose.poseTimeOffset = 0.0;
+
+    pose.poseIsValid = true;
+    pose.result = vr::TrackingResult_Running_OK;
+    return pose;
+}
@@ -0,0 +1,124 @@
+#include "line_parser.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+bool LineParser::Push(char ch, double time)
+{
+    if (this->complete_)
+        this->Reset();
+
+    uint8_t byte = static_cast<uint8_t>(ch);
+    if (this->frame_length_ > 0)
+    {
+        this->frame_[this->frame_length_++] = byte;
+        if (this->frame_length_ < FrameCodec::FRAME_SIZE)
+            return false;
+        this->end_time_ = time;
+        this->binary_ = true;
+        this->complete_ = true;
+        return true;
+    }
+
+    if (byte == FrameCodec::SYNC_BYTE)
+    {
+        // Text in front of a sync byte is the rest of a frame that lost its own sync
+        // byte, it ends without a line end and is dropped.
+        this->buffer_[0] = '\0';
+        this->length_ = 0;
+        this->frame_[0] = byte;
+        this->frame_length_ = 1;
+        this->first_byte_time_ = time;
+        return false;
+    }
+
+    if (ch == '\r')
+    {
+        this->buffer_[this->length_] = '\0';
+        this->end_time_ = time;
+        if (this->length_ == 0)
+            this->first_byte_time_ = time;
+        this->complete_ = true;
+        return true;
+    }
+
+    if (ch == '\n')
+        return false;
+
+    if (this->length_ == MAX_LINE_LENGTH)
+    {
+        // The rest of the line starts a new one, as the module sends no line end
+        // that could be waited for while it restarts.
+        this->buffer_[0] = '\0';
+        this->length_ = 0;
+        this->end_time_ = time;
+        this->overflow_ = true;
+        this->complete_ = true;
+        return true;
+    }
+
+    if (this->length_ == 0)
+        this->first_byte_time_ = time;
+    this->buffer_[this->length_++] = ch;
+    return false;
+}
+
+void LineParser::Reset()
+{
+    this->buffer_[0] = '\0';
+    this->length_ = 0;
+    this->complete_ = false;
+    this->overflow_ = false;
+    this->frame_length_ = 0;
+    this->binary_ = false;
+}
+
+const char* LineParser::GetLine() const
+{
+    return this->buffer_;
+}
+
+size_t LineParser::GetLength() const
+{
+    return this->binary_ ? this->frame_length_ : this->length_;
+}
+
+bool LineParser::IsOverflow() const
+{
+    return this->overflow_;
+}
+
+bool LineParser::IsBinary() const
+{
+    return this->binary_;
+}
+
+float LineParser::GetValue() const
+{
+    if (this->binary_)
+        return FrameCodec::Decode(this->frame_);
+    if (this->overflow_)
+        return std::numeric_limits<float>::quiet_NaN();
+    return LineParser::ParseValue(this->buffer_);
+}
+
+double LineParser::GetFirstByteTime() const
+{
+    return this->first_byte_time_;
+}
+
+double LineParser::GetEndTime() const
+{
+    return this->end_time_;
+}
+
+float LineParser::ParseValue(const char* line)
+{
+    char* end = nullptr;
+    float value = std::strtof(line, &end);
+    // "inf" and "nan" are numbers to strtof, but no values of the module.
+    if (end == line || !std::isfinite(value))
+        return std::numeric_limits<float>::quiet_NaN();
+    return value;
+}
@@ -0,0 +1,210 @@
+#include "log_queue.h"
+
+#include <cstdio>
+
+LogQueue::LogQueue()
+    : LogQueue(LogQueueSettings())
+{
+}
+
+LogQueue::LogQueue(const LogQueueSettings& settings)
+    : settings_(settings)
+{
+    for (size_t i = 0; i < CAPACITY; i++)
+        this->slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+LogQueue::~LogQueue()
+{
+    this->Stop();
+}
+
+void LogQueue::Start(Sink sink)
+{
+    if (this->running_)
+        return;
+
+    this->sink_ = sink;
+    this->running_ = true;
+    this->flusher_thread_ = std::thread(&LogQueue::FlusherLoop, this);
+}
+
+void LogQueue::Stop()
+{
+    if (!this->running_)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->wait_lock_);
+        this->running_ = false;
+    }
+    this->wakeup_.notify_all();
+    if (this->flusher_thread_.joinable())
+        this->flusher_thread_.join();
+
+    // A producer that saw the queue running may still be formatting its message. Either
+    // it incremented the count before running_ was cleared and is waited for here, or it
+    // sees the queue stopped and writes the message itself.
+    while (this->producers_.load() != 0)
+        std::this_thread::yield();
+
+    this->Flush(true);
+}
+
+bool LogQueue::IsRunning() const
+{
+    return this->running_;
+}
+
+bool LogQueue::Enqueue(const char* format, va_list args)
+{
+    // Claims a free slot. A slot is free if its sequence equals the position, a smaller
+    // sequence means the consumer did not take the message written a lap ago yet.
+    size_t position = this->enqueue_position_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        slot = &this->slots_[position % CAPACITY];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0)
+        {
+            if (this->enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            this->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = this->enqueue_position_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // The slot belongs to this thread until the sequence is advanced, so the message is
+    // formatted in place without a copy.
+    vsnprintf(slot->message, MAX_MESSAGE_LENGTH, format, args);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogQueue::EnqueueWhileRunning(const char* format, va_list args)
+{
+    this->producers_.fetch_add(1);
+    bool running = this->running_.load();
+    if (running)
+        this->Enqueue(format, args);
+    this->producers_.fetch_sub(1, std::memory_order_release);
+    return running;
+}
+
+uint64_t LogQueue::GetDroppedCount() const
+{
+    return this->dropped_.load(std::memory_order_relaxed);
+}
+
+void LogQueue::FlusherLoop()
+{
+    // The producers do not wake the flusher, as that could cost them a system call. The
+    // messages wait for the next flush interval instead.
+    const std::chrono::duration<float> flush_interval(this->settings_.flush_interval);
+
+    while (this->running_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->wait_lock_);
+            this->wakeup_.wait_for(lock, flush_interval, [this] { return !this->running_; });
+        }
+        this->Flush(false);
+    }
+}
+
+void LogQueue::Flush(bool final)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+        Slot& slot = this->slots_[this->dequeue_position_ % CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != this->dequeue_position_ + 1)
+            break;
+
+        this->Write(slot.message, now);
+        slot.sequence.store(this->dequeue_position_ + CAPACITY, std::memory_order_release);
+        this->dequeue_position_++;
+    }
+
+    uint64_t dropped = this->dropped_.load(std::memory_order_relaxed);
+    if (dropped != this->reported_dropped_)
+    {
+        char message[64];
+        snprintf(message, sizeof(message), "%llu log messages dropped",
+            static_cast<unsigned long long>(dropped - this->reported_dropped_));
+        this->sink_(message);
+        this->reported_dropped_ = dropped;
+    }
+
+    const std::chrono::duration<float> repeat_window(this->settings_.repeat_window);
+    for (RecentMessage& recent : this->recent_)
+    {
+        if (!recent.in_use)
+            continue;
+
+        bool expired = now - recent.window_start >= repeat_window;
+        if (recent.repetitions > 0 && (expired || final))
+            this->WriteRepetitions(recent, now);
+        else if (expired)
+            recent.in_use = false;
+    }
+}
+
+void LogQueue::Write(const char* message, std::chrono::steady_clock::time_point now)
+{
+    const std::chrono::duration<float> repeat_window(this->settings_.repeat_window);
+
+    RecentMessage* oldest = &this->recent_[0];
+    for (RecentMessage& recent : this->recent_)
+    {
+        if (recent.in_use && recent.message == message)
+        {
+            // Within the window the message is only counted. Once the window is up, the
+            // count including this message is written and starts the next window.
+            bool expired = now - recent.window_start >= repeat_window;
+            if (recent.repetitions > 0 || !expired)
+                recent.repetitions++;
+            if (!expired)
+                return;
+
+            if (recent.repetitions > 0)
+                this->WriteRepetitions(recent, now);
+            else
+                this->sink_(message);
+            recent.window_start = now;
+            return;
+        }
+
+        if (!recent.in_use || (oldest->in_use && recent.window_start < oldest->window_start))
+            oldest = &recent;
+    }
+
+    // A new message replaces the oldest recent one, whose pending count is written first.
+    if (oldest->repetitions > 0)
+        this->WriteRepetitions(*oldest, now);
+    oldest->in_use = true;
+    oldest->message = message;
+    oldest->window_start = now;
+    oldest->repetitions = 0;
+    this->sink_(message);
+}
+
+void LogQueue::WriteRepetitions(RecentMessage& recent, std::chrono::steady_clock::time_point now)
+{
+    char message[MAX_MESSAGE_LENGTH + 16];
+    snprintf(message, sizeof(message), "%s \xC3\x97%u", recent.message.c_str(), static_cast<unsigned int>(recent.repetitions));
+    this->sink_(message);
+
+    recent.repetitions = 0;
+    recent.window_start = now;
+}
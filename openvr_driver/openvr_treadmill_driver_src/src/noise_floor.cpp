@@ -0,0 +1,79 @@
+#include "noise_floor.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Smallest range above the deadzone the output is rescaled to.
+static const float MIN_RANGE = 0.05f;
+
+NoiseFloorEstimator::NoiseFloorEstimator(const NoiseFloorSettings& settings)
+    : settings_(settings)
+{
+    this->deadzone_ = settings.min_deadzone;
+}
+
+float NoiseFloorEstimator::Process(float value, bool idle, double timestamp)
+{
+    if (!this->settings_.enabled)
+        return value;
+
+    float dt = this->has_timestamp_ ? static_cast<float>(timestamp - this->last_timestamp_) : 0.0f;
+    dt = std::max(dt, 0.0f);
+    this->has_timestamp_ = true;
+    this->last_timestamp_ = timestamp;
+
+    if (idle && !this->was_idle_)
+        this->idle_since_ = timestamp;
+    this->was_idle_ = idle;
+
+    float offset = value - this->baseline_;
+    bool confidently_idle = idle && (timestamp - this->idle_since_) >= this->settings_.confidence_time;
+    bool inside_idle_band = offset <= this->settings_.idle_band;
+
+    if (confidently_idle && inside_idle_band)
+    {
+        // Moving by a fixed step towards the sample instead of by a fraction of the
+        // difference makes the tracker converge to the median of the idle load.
+        float step = std::min(this->settings_.baseline_rate * dt, std::fabs(offset));
+        this->baseline_ += offset > 0.0f ? step : -step;
+        this->baseline_ = std::min(std::max(this->baseline_, 0.0f), this->settings_.max_baseline);
+
+        float alpha = 1.0f - std::exp(-dt / this->settings_.noise_time_constant);
+        this->noise_ += alpha * (std::fabs(value - this->baseline_) - this->noise_);
+
+        this->deadzone_ = std::min(std::max(this->settings_.deadzone_factor * this->noise_,
+                                            this->settings_.min_deadzone),
+                                   this->settings_.max_deadzone);
+    }
+
+    // While the user stands still, a pull up to the idle band is treated as idle
+    // load, so leaning into the rope does not move the player. Pulls beyond it
+    // are rescaled from the edge of the band, which keeps the output continuous.
+    // A real start is classified as a step onset by the gait detector in the same
+    // sample, so the wider deadzone does not delay the start of walking.
+    float deadzone = idle ? std::max(this->deadzone_, this->settings_.idle_band) : this->deadzone_;
+
+    offset = value - this->baseline_;
+    if (offset <= deadzone)
+        return 0.0f;
+
+    // Rescale the remaining range, so that a full pull still reaches full deflection.
+    // A baseline and deadzone that cover the whole range would leave none.
+    float range = std::max(1.0f - this->baseline_ - deadzone, MIN_RANGE);
+    return std::min((offset - deadzone) / range, 1.0f);
+}
+
+void NoiseFloorEstimator::Reset()
+{
+    *this = NoiseFloorEstimator(this->settings_);
+}
+
+float NoiseFloorEstimator::GetBaseline() const
+{
+    return this->baseline_;
+}
+
+float NoiseFloorEstimator::GetDeadzone() const
+{
+    return this->deadzone_;
+}
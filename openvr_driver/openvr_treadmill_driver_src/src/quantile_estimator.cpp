@@ -0,0 +1,109 @@
+#include "quantile_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+P2QuantileEstimator::P2QuantileEstimator(double quantile)
+    : quantile_(quantile)
+{
+    this->Reset();
+}
+
+void P2QuantileEstimator::Add(double value)
+{
+    // The first five observations are kept sorted and initialize the markers.
+    if (this->count_ < 5)
+    {
+        this->heights_[this->count_] = value;
+        this->count_++;
+        std::sort(this->heights_.begin(), this->heights_.begin() + this->count_);
+        return;
+    }
+
+    size_t cell = 0;
+    if (value < this->heights_[0])
+    {
+        this->heights_[0] = value;
+        cell = 0;
+    }
+    else if (value >= this->heights_[4])
+    {
+        this->heights_[4] = value;
+        cell = 3;
+    }
+    else
+    {
+        while (cell < 3 && value >= this->heights_[cell + 1])
+            cell++;
+    }
+
+    for (size_t i = cell + 1; i < 5; i++)
+        this->positions_[i] += 1.0;
+    for (size_t i = 0; i < 5; i++)
+        this->desired_positions_[i] += this->increments_[i];
+    this->count_++;
+
+    // Move the three middle markers towards their desired positions, by at most
+    // one position per observation.
+    for (size_t i = 1; i < 4; i++)
+    {
+        double d = this->desired_positions_[i] - this->positions_[i];
+        bool move_up = d >= 1.0 && this->positions_[i + 1] - this->positions_[i] > 1.0;
+        bool move_down = d <= -1.0 && this->positions_[i - 1] - this->positions_[i] < -1.0;
+        if (!move_up && !move_down)
+            continue;
+
+        int step = move_up ? 1 : -1;
+        double height = this->Parabolic(i, step);
+        if (!(this->heights_[i - 1] < height && height < this->heights_[i + 1]))
+            height = this->Linear(i, step);
+
+        this->heights_[i] = height;
+        this->positions_[i] += step;
+    }
+}
+
+double P2QuantileEstimator::GetEstimate() const
+{
+    if (this->count_ == 0)
+        return 0.0;
+
+    if (this->count_ < 5)
+    {
+        size_t index = static_cast<size_t>(std::lround(this->quantile_ * (this->count_ - 1)));
+        return this->heights_[index];
+    }
+
+    return this->heights_[2];
+}
+
+size_t P2QuantileEstimator::GetCount() const
+{
+    return this->count_;
+}
+
+void P2QuantileEstimator::Reset()
+{
+    double p = this->quantile_;
+    this->count_ = 0;
+    this->heights_.fill(0.0);
+    this->positions_ = { 0.0, 1.0, 2.0, 3.0, 4.0 };
+    this->desired_positions_ = { 0.0, 2.0 * p, 4.0 * p, 2.0 + 2.0 * p, 4.0 };
+    this->increments_ = { 0.0, p / 2.0, p, (1.0 + p) / 2.0, 1.0 };
+}
+
+double P2QuantileEstimator::Parabolic(size_t i, double d) const
+{
+    const auto& q = this->heights_;
+    const auto& n = this->positions_;
+    return q[i] + d / (n[i + 1] - n[i - 1]) *
+        ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+         (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double P2QuantileEstimator::Linear(size_t i, int d) const
+{
+    size_t j = static_cast<size_t>(static_cast<int>(i) + d);
+    return this->heights_[i] + d * (this->heights_[j] - this->heights_[i]) /
+        (this->positions_[j] - this->positions_[i]);
+}
@@ -0,0 +1,134 @@
+#include "response_curve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+ResponseCurve::ResponseCurve()
+    : type_(ResponseCurveType::LINEAR), table_(LINEAR_CURVE_TABLE)
+{
+}
+
+ResponseCurve::ResponseCurve(ResponseCurveType type, float gamma)
+    : type_(type), table_(LINEAR_CURVE_TABLE)
+{
+    switch (type)
+    {
+    case ResponseCurveType::GAMMA_SOFT:
+        this->table_ = GAMMA_SOFT_CURVE_TABLE;
+        break;
+    case ResponseCurveType::GAMMA_HARD:
+        this->table_ = GAMMA_HARD_CURVE_TABLE;
+        break;
+    case ResponseCurveType::S_CURVE:
+        this->table_ = S_CURVE_TABLE;
+        break;
+    case ResponseCurveType::GAMMA:
+        // The comparison is written so that NaN fails it.
+        if (gamma > 0.0f)
+        {
+            this->table_ = response_curve_detail::MakeTable(
+                [gamma](double x) { return std::pow(x, static_cast<double>(gamma)); });
+        }
+        else
+        {
+            this->type_ = ResponseCurveType::LINEAR;
+        }
+        break;
+    case ResponseCurveType::CUSTOM:
+    case ResponseCurveType::LINEAR:
+        break;
+    }
+}
+
+static const std::pair<const char*, ResponseCurveType> curve_type_names[] = {
+    { "linear", ResponseCurveType::LINEAR },
+    { "gamma_soft", ResponseCurveType::GAMMA_SOFT },
+    { "gamma_hard", ResponseCurveType::GAMMA_HARD },
+    { "s_curve", ResponseCurveType::S_CURVE },
+    { "gamma", ResponseCurveType::GAMMA },
+    { "custom", ResponseCurveType::CUSTOM },
+};
+
+bool ResponseCurve::ParseType(const std::string& name, ResponseCurveType& type)
+{
+    for (const auto& entry : curve_type_names)
+    {
+        if (name == entry.first)
+        {
+            type = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* ResponseCurve::GetTypeName(ResponseCurveType type)
+{
+    for (const auto& entry : curve_type_names)
+    {
+        if (entry.second == type)
+            return entry.first;
+    }
+    return "unknown";
+}
+
+bool ResponseCurve::FromPoints(const std::string& description)
+{
+    std::vector<std::pair<double, double>> points;
+    std::stringstream stream(description);
+    std::string token;
+
+    while (std::getline(stream, token, ','))
+    {
+        double x = 0.0;
+        double y = 0.0;
+        char separator = 0;
+        std::stringstream point(token);
+        if (!(point >> x >> separator >> y) || separator != ':')
+            return false;
+        // The deflection goes to SteamVR as is, so it has to be a valid axis value. The
+        // comparisons are written so that NaN fails them.
+        if (!(x >= 0.0 && x <= 1.0) || !(y >= 0.0 && y <= 1.0))
+            return false;
+        points.emplace_back(x, y);
+    }
+
+    if (points.size() < 2)
+        return false;
+
+    std::sort(points.begin(), points.end());
+
+    // The sampling only happens once while loading the settings, so a plain search
+    // for the enclosing segment is good enough.
+    this->table_ = response_curve_detail::MakeTable([&points](double x) {
+        if (x <= points.front().first)
+            return points.front().second;
+        if (x >= points.back().first)
+            return points.back().second;
+
+        size_t i = 1;
+        while (points[i].first < x)
+            i++;
+
+        double x0 = points[i - 1].first;
+        double x1 = points[i].first;
+        double t = x1 > x0 ? (x - x0) / (x1 - x0) : 1.0;
+        return points[i - 1].second + t * (points[i].second - points[i - 1].second);
+    });
+    this->type_ = ResponseCurveType::CUSTOM;
+    return true;
+}
+
+void ResponseCurve::EvaluateBlock(const float* values, float* results, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+        results[i] = this->Evaluate(values[i]);
+}
+
+ResponseCurveType ResponseCurve::GetType() const
+{
+    return this->type_;
+}
@@ -0,0 +1,239 @@
+#include "serial_transport.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * A tty of Linux and other POSIX systems. Devices are found by the names udev gives
+ * them in /dev/serial/by-id, which contain the vendor and product name.
+ */
+class PosixSerialTransport : public SerialTransport
+{
+public:
+    PosixSerialTransport();
+    ~PosixSerialTransport() override;
+
+    std::string FindPort(const std::string& name_match, const std::set<std::string>& excluded) override;
+    bool Open(const std::string& port, uint32_t baud_rate) override;
+    void Close() override;
+    bool IsOpen() const override;
+    void SetReadTimeout(uint32_t milliseconds) override;
+    int Read(char* buffer, size_t size) override;
+    bool Write(const char* data, size_t size) override;
+    void CancelRead() override;
+    void Reset() override;
+
+private:
+    int fd_ = -1;
+    // CancelRead() writes into the pipe, which wakes up the poll of a pending Read().
+    int cancel_pipe_[2] = { -1, -1 };
+    int read_timeout_ = 100;
+
+    /**
+     * Returns the termios speed constant of the given baud rate, or B0 if there is none.
+     */
+    static speed_t GetSpeed(uint32_t baud_rate);
+};
+
+std::unique_ptr<SerialTransport> SerialTransport::Create()
+{
+    return std::make_unique<PosixSerialTransport>();
+}
+
+PosixSerialTransport::PosixSerialTransport()
+{
+    if (pipe(this->cancel_pipe_) == 0)
+    {
+        for (int fd : this->cancel_pipe_)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+}
+
+PosixSerialTransport::~PosixSerialTransport()
+{
+    this->Close();
+    for (int fd : this->cancel_pipe_)
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+std::string PosixSerialTransport::FindPort(const std::string& name_match, const std::set<std::string>& excluded)
+{
+    // A device path can be given directly, e.g. for adapters without a useful name or
+    // the link the device simulator keeps pointing at its current pseudo terminal.
+    if (name_match.rfind("/", 0) == 0)
+        return access(name_match.c_str(), R_OK | W_OK) == 0 && excluded.count(name_match) == 0 ? name_match : "";
+
+    const char* directory = "/dev/serial/by-id";
+    DIR* devices = opendir(directory);
+    if (devices == nullptr)
+        return "";
+
+    std::string found_port = "";
+    while (dirent* entry = readdir(devices))
+    {
+        std::string name = entry->d_name;
+        if (name.find(name_match) == std::string::npos)
+            continue;
+
+        // The entries are links to the actual tty, which is what other captures claim.
+        char port[PATH_MAX];
+        if (realpath((std::string(directory) + "/" + name).c_str(), port) == nullptr)
+            continue;
+        if (excluded.count(port) == 0)
+        {
+            found_port = port;
+            break;
+        }
+    }
+
+    closedir(devices);
+    return found_port;
+}
+
+speed_t PosixSerialTransport::GetSpeed(uint32_t baud_rate)
+{
+    switch (baud_rate)
+    {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return B0;
+    }
+}
+
+bool PosixSerialTransport::Open(const std::string& port, uint32_t baud_rate)
+{
+    this->Close();
+
+    speed_t speed = PosixSerialTransport::GetSpeed(baud_rate);
+    if (speed == B0)
+        return false;
+
+    this->fd_ = open(port.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (this->fd_ < 0)
+        return false;
+
+    // Raw 8N1 without flow control, the module sends plain text lines.
+    termios options = {};
+    if (tcgetattr(this->fd_, &options) == 0)
+    {
+        cfmakeraw(&options);
+        options.c_cflag |= CLOCAL | CREAD;
+        options.c_cflag &= ~(CSTOPB | PARENB);
+        options.c_cc[VMIN] = 0;
+        options.c_cc[VTIME] = 0;
+        cfsetispeed(&options, speed);
+        cfsetospeed(&options, speed);
+        tcsetattr(this->fd_, TCSANOW, &options);
+    }
+    return true;
+}
+
+void PosixSerialTransport::Close()
+{
+    if (this->fd_ >= 0)
+    {
+        close(this->fd_);
+        this->fd_ = -1;
+    }
+}
+
+bool PosixSerialTransport::IsOpen() const
+{
+    return this->fd_ >= 0;
+}
+
+void PosixSerialTransport::SetReadTimeout(uint32_t milliseconds)
+{
+    this->read_timeout_ = static_cast<int>(milliseconds);
+}
+
+int PosixSerialTransport::Read(char* buffer, size_t size)
+{
+    if (this->fd_ < 0)
+        return -1;
+
+    pollfd fds[2] = {
+        { this->fd_, POLLIN, 0 },
+        { this->cancel_pipe_[0], POLLIN, 0 },
+    };
+    int ready = poll(fds, this->cancel_pipe_[0] >= 0 ? 2 : 1, this->read_timeout_);
+    if (ready < 0)
+        return errno == EINTR ? 0 : -1;
+    if (ready == 0)
+        return 0;
+
+    if (fds[1].revents & POLLIN)
+    {
+        char drained[16];
+        while (read(this->cancel_pipe_[0], drained, sizeof(drained)) > 0)
+        {
+        }
+        return 0;
+    }
+
+    // An unplugged adapter reports a hangup or reads end of file.
+    if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+        return -1;
+
+    ssize_t bytes_read = read(this->fd_, buffer, size);
+    if (bytes_read < 0)
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    if (bytes_read == 0)
+        return -1;
+    return static_cast<int>(bytes_read);
+}
+
+bool PosixSerialTransport::Write(const char* data, size_t size)
+{
+    if (this->fd_ < 0)
+        return false;
+
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t result = write(this->fd_, data + written, size - written);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return false;
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+void PosixSerialTransport::CancelRead()
+{
+    if (this->cancel_pipe_[1] >= 0)
+    {
+        char wakeup = 1;
+        ssize_t result = write(this->cancel_pipe_[1], &wakeup, 1);
+        (void)result;
+    }
+}
+
+void PosixSerialTransport::Reset()
+{
+    if (this->fd_ < 0)
+        return;
+
+    tcflush(this->fd_, TCIOFLUSH);
+    // Fails for pseudo terminals, which have no modem lines.
+    int lines = TIOCM_DTR | TIOCM_RTS;
+    ioctl(this->fd_, TIOCMBIS, &lines);
+}
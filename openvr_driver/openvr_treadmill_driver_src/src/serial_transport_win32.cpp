@@ -0,0 +1,186 @@
+#include "serial_transport.h"
+
+#include <Windows.h>
+#include <setupapi.h>
+#include <devguid.h>
+#include <regstr.h>
+#include <atomic>
+#include <regex>
+
+#include "utils.h"
+
+#pragma comment(lib, "setupapi.lib")
+
+/**
+ * The serial port of Windows, found by the friendly name of the device.
+ */
+class Win32SerialTransport : public SerialTransport
+{
+public:
+    ~Win32SerialTransport() override;
+
+    std::string FindPort(const std::string& name_match, const std::set<std::string>& excluded) override;
+    bool Open(const std::string& port, uint32_t baud_rate) override;
+    void Close() override;
+    bool IsOpen() const override;
+    void SetReadTimeout(uint32_t milliseconds) override;
+    int Read(char* buffer, size_t size) override;
+    bool Write(const char* data, size_t size) override;
+    void CancelRead() override;
+    void Reset() override;
+
+private:
+    HANDLE serial_handle_ = INVALID_HANDLE_VALUE;
+    // The thread blocking in Read(), whose synchronous read CancelRead() aborts.
+    std::atomic<HANDLE> reading_thread_{ NULL };
+
+    /**
+     * Extracts the port name, e.g. "COM3", from a friendly name like "Arduino Uno (COM3)".
+     */
+    static std::string ExtractPortFromName(const std::string& name);
+};
+
+std::unique_ptr<SerialTransport> SerialTransport::Create()
+{
+    return std::make_unique<Win32SerialTransport>();
+}
+
+Win32SerialTransport::~Win32SerialTransport()
+{
+    this->Close();
+    HANDLE thread = this->reading_thread_.exchange(NULL);
+    if (thread != NULL)
+        CloseHandle(thread);
+}
+
+std::string Win32SerialTransport::FindPort(const std::string& name_match, const std::set<std::string>& excluded)
+{
+    HDEVINFO deviceInfoSet = SetupDiGetClassDevs(&GUID_DEVCLASS_PORTS, nullptr, nullptr, DIGCF_PRESENT);
+    if (deviceInfoSet == INVALID_HANDLE_VALUE) {
+        return "";
+    }
+
+    SP_DEVINFO_DATA devInfoData = {};
+    devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+    std::string found_port = "";
+
+    for (DWORD i = 0; SetupDiEnumDeviceInfo(deviceInfoSet, i, &devInfoData); ++i) {
+        WCHAR buffer[256];
+        DWORD buffersize = 0;
+
+        // Get the friendly name
+        if (SetupDiGetDeviceRegistryPropertyW(deviceInfoSet, &devInfoData, SPDRP_FRIENDLYNAME,
+            nullptr, (PBYTE)buffer, sizeof(buffer), &buffersize)) {
+
+            // Optional: detect Arduino by matching known patterns
+            std::string name = WstrToStr(std::wstring(buffer)).c_str();
+            if (name.find(name_match) != std::string::npos) {
+                std::string port = Win32SerialTransport::ExtractPortFromName(name);
+                if (!port.empty() && excluded.count(port) == 0) {
+                    found_port = port;
+                    break;
+                }
+            }
+        }
+    }
+
+    SetupDiDestroyDeviceInfoList(deviceInfoSet);
+    return found_port;
+}
+
+std::string Win32SerialTransport::ExtractPortFromName(const std::string& name)
+{
+    std::regex pattern("\\((COM\\d+)\\)");
+    std::smatch match;
+
+    if (std::regex_search(name, match, pattern) && match.size() > 1)
+        return match[1].str();
+    return "";
+}
+
+bool Win32SerialTransport::Open(const std::string& port, uint32_t baud_rate)
+{
+    this->Close();
+
+    // Ports above COM9 are only reachable through the device namespace.
+    std::string path = "\\\\.\\" + port;
+    this->serial_handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (this->serial_handle_ == INVALID_HANDLE_VALUE)
+        return false;
+
+    // Config serial port parameter
+    DCB serialParams = { 0 };
+    serialParams.DCBlength = sizeof(serialParams);
+    GetCommState(this->serial_handle_, &serialParams);
+    serialParams.BaudRate = baud_rate;
+    serialParams.ByteSize = 8;
+    serialParams.StopBits = ONESTOPBIT;
+    serialParams.Parity = NOPARITY;
+    SetCommState(this->serial_handle_, &serialParams);
+    return true;
+}
+
+void Win32SerialTransport::Close()
+{
+    if (this->serial_handle_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(this->serial_handle_);
+        this->serial_handle_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool Win32SerialTransport::IsOpen() const
+{
+    return this->serial_handle_ != INVALID_HANDLE_VALUE;
+}
+
+void Win32SerialTransport::SetReadTimeout(uint32_t milliseconds)
+{
+    // A read returns as soon as any byte arrived, or after the constant timeout if
+    // none did.
+    COMMTIMEOUTS timeout = { 0 };
+    timeout.ReadIntervalTimeout = MAXDWORD;
+    timeout.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeout.ReadTotalTimeoutConstant = milliseconds;
+    timeout.WriteTotalTimeoutConstant = 100;
+    timeout.WriteTotalTimeoutMultiplier = 20;
+    SetCommTimeouts(this->serial_handle_, &timeout);
+}
+
+int Win32SerialTransport::Read(char* buffer, size_t size)
+{
+    // CancelSynchronousIo needs a real handle of the reading thread, the pseudo handle
+    // of GetCurrentThread() is only valid on the thread itself.
+    if (this->reading_thread_.load() == NULL)
+        this->reading_thread_ = OpenThread(THREAD_TERMINATE, FALSE, GetCurrentThreadId());
+
+    // A framing or overrun error blocks further reads until it is cleared.
+    DWORD errors = 0;
+    COMSTAT status = {};
+    ClearCommError(this->serial_handle_, &errors, &status);
+
+    DWORD bytes_read = 0;
+    if (!ReadFile(this->serial_handle_, buffer, static_cast<DWORD>(size), &bytes_read, NULL))
+        return GetLastError() == ERROR_OPERATION_ABORTED ? 0 : -1;
+    return static_cast<int>(bytes_read);
+}
+
+bool Win32SerialTransport::Write(const char* data, size_t size)
+{
+    DWORD bytes_written = 0;
+    return WriteFile(this->serial_handle_, data, static_cast<DWORD>(size), &bytes_written, NULL) && bytes_written == size;
+}
+
+void Win32SerialTransport::CancelRead()
+{
+    HANDLE thread = this->reading_thread_.load();
+    if (thread != NULL)
+        CancelSynchronousIo(thread);
+}
+
+void Win32SerialTransport::Reset()
+{
+    PurgeComm(this->serial_handle_, PURGE_RXCLEAR | PURGE_TXCLEAR);
+    EscapeCommFunction(this->serial_handle_, SETDTR);
+    EscapeCommFunction(this->serial_handle_, SETRTS);
+}
@@ -0,0 +1,329 @@
+#include "session_recorder.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// The writer moves the records this often, the ring buffer holds far more than that.
+static const std::chrono::milliseconds WRITE_INTERVAL(100);
+static const std::chrono::seconds SYNC_INTERVAL(1);
+
+SessionRecorder::~SessionRecorder()
+{
+    this->Close();
+}
+
+bool SessionRecorder::Open(const std::string& file, double start_host_time, const std::string& metadata)
+{
+    this->Close();
+
+    if (!this->ring_)
+        this->ring_.reset(new SessionRecord[SessionRecorder::RING_CAPACITY]);
+    this->write_position_ = 0;
+    this->read_position_ = 0;
+    this->next_sequence_ = 0;
+    this->written_ = 0;
+    this->lost_ = 0;
+    this->file_size_ = 0;
+    this->chunk_ = nullptr;
+    this->chunk_index_ = 0;
+    this->chunk_records_ = 0;
+    this->failed_ = false;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    this->file_ = handle;
+#else
+    this->file_ = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (this->file_ < 0)
+        return false;
+#endif
+
+    if (!this->Reserve(SessionFileHeader::SIZE) || !this->MapRegion(0, SessionFileHeader::SIZE, this->header_region_))
+    {
+        this->CloseFile();
+        return false;
+    }
+
+    // A reader only takes the file once the magic is there.
+    SessionFileHeader* header = reinterpret_cast<SessionFileHeader*>(this->header_region_.data);
+    std::memset(header, 0, sizeof(SessionFileHeader));
+    header->version = SessionFileHeader::VERSION;
+    header->header_size = static_cast<uint32_t>(SessionFileHeader::SIZE);
+    header->chunk_size = static_cast<uint32_t>(SessionRecorder::CHUNK_SIZE);
+    header->record_size = static_cast<uint32_t>(sizeof(SessionRecord));
+    header->start_host_time = start_host_time;
+    header->start_unix_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::strncpy(header->metadata, metadata.c_str(), sizeof(header->metadata) - 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SessionFileHeader::MAGIC;
+    this->FlushRegion(this->header_region_, false);
+
+    this->open_ = true;
+    this->running_ = true;
+    this->writer_thread_ = std::thread(&SessionRecorder::WriterLoop, this);
+    return true;
+}
+
+void SessionRecorder::Close()
+{
+    if (!this->writer_thread_.joinable())
+        return;
+
+    this->open_ = false;
+    this->running_ = false;
+    this->wait_lock_.lock();
+    this->wait_lock_.unlock();
+    this->wakeup_.notify_all();
+    this->writer_thread_.join();
+
+    this->FlushRegion(this->chunk_region_, true);
+    this->UnmapRegion(this->chunk_region_);
+    this->chunk_ = nullptr;
+
+    SessionFileHeader* header = reinterpret_cast<SessionFileHeader*>(this->header_region_.data);
+    header->lost_records = this->lost_;
+    header->closed = 1;
+    this->FlushRegion(this->header_region_, true);
+    this->UnmapRegion(this->header_region_);
+    this->CloseFile();
+}
+
+bool SessionRecorder::IsOpen() const
+{
+    return this->open_;
+}
+
+bool SessionRecorder::Record(SessionRecordType type, uint16_t flags, double host_time, double device_time,
+    float raw_value, float value)
+{
+    if (!this->open_.load(std::memory_order_relaxed))
+        return false;
+
+    uint32_t sequence = this->next_sequence_++;
+    size_t write = this->write_position_.load(std::memory_order_relaxed);
+    if (write - this->read_position_.load(std::memory_order_acquire) >= SessionRecorder::RING_CAPACITY)
+    {
+        this->lost_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    SessionRecord& record = this->ring_[write % SessionRecorder::RING_CAPACITY];
+    record.host_time = host_time;
+    record.device_time = device_time;
+    record.sequence = sequence;
+    record.type = static_cast<uint16_t>(type);
+    record.flags = flags;
+    record.raw_value = raw_value;
+    record.value = value;
+    this->write_position_.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t SessionRecorder::GetWrittenCount() const
+{
+    return this->written_;
+}
+
+uint64_t SessionRecorder::GetLostCount() const
+{
+    return this->lost_;
+}
+
+void SessionRecorder::WriterLoop()
+{
+    std::chrono::steady_clock::time_point next_sync = std::chrono::steady_clock::now() + SYNC_INTERVAL;
+    while (this->running_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->wait_lock_);
+            this->wakeup_.wait_for(lock, WRITE_INTERVAL, [this]() { return !this->running_; });
+        }
+
+        this->Drain();
+        if (std::chrono::steady_clock::now() >= next_sync)
+        {
+            this->FlushRegion(this->chunk_region_, true);
+            next_sync = std::chrono::steady_clock::now() + SYNC_INTERVAL;
+        }
+    }
+    this->Drain();
+}
+
+void SessionRecorder::Drain()
+{
+    size_t read = this->read_position_.load(std::memory_order_relaxed);
+    size_t write = this->write_position_.load(std::memory_order_acquire);
+    if (read == write)
+        return;
+
+    while (read != write && !this->failed_)
+    {
+        if (this->chunk_ == nullptr || this->chunk_records_ == SessionRecorder::RECORDS_PER_CHUNK)
+        {
+            if (!this->NextChunk())
+            {
+                this->failed_ = true;
+                break;
+            }
+        }
+
+        const SessionRecord& record = this->ring_[read % SessionRecorder::RING_CAPACITY];
+        if (this->chunk_records_ == 0)
+            this->chunk_->first_sequence = record.sequence;
+        reinterpret_cast<SessionRecord*>(this->chunk_)[1 + this->chunk_records_] = record;
+        this->chunk_records_++;
+        this->written_.fetch_add(1, std::memory_order_relaxed);
+        read++;
+    }
+    this->CommitChunk();
+
+    // Without a file the records are dropped, so that the producer never blocks.
+    if (this->failed_)
+    {
+        this->lost_.fetch_add(write - read, std::memory_order_relaxed);
+        read = write;
+    }
+    this->read_position_.store(read, std::memory_order_release);
+}
+
+void SessionRecorder::CommitChunk()
+{
+    if (this->chunk_ == nullptr)
+        return;
+    std::atomic_thread_fence(std::memory_order_release);
+    this->chunk_->record_count = this->chunk_records_;
+}
+
+bool SessionRecorder::NextChunk()
+{
+    if (this->chunk_ != nullptr)
+    {
+        this->CommitChunk();
+        this->FlushRegion(this->chunk_region_, true);
+        this->UnmapRegion(this->chunk_region_);
+        this->chunk_ = nullptr;
+        this->chunk_index_++;
+    }
+
+    uint64_t offset = SessionFileHeader::SIZE + static_cast<uint64_t>(this->chunk_index_) * SessionRecorder::CHUNK_SIZE;
+    if (!this->Reserve(offset + SessionRecorder::CHUNK_SIZE) ||
+        !this->MapRegion(offset, SessionRecorder::CHUNK_SIZE, this->chunk_region_))
+        return false;
+
+    // The reserved space reads as zeros, a chunk without its magic ends the log.
+    this->chunk_ = reinterpret_cast<SessionChunkHeader*>(this->chunk_region_.data);
+    this->chunk_->index = this->chunk_index_;
+    this->chunk_->record_count = 0;
+    this->chunk_records_ = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    this->chunk_->magic = SessionChunkHeader::MAGIC;
+    return true;
+}
+
+bool SessionRecorder::Reserve(uint64_t size)
+{
+    if (size <= this->file_size_)
+        return true;
+
+#ifdef _WIN32
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(this->file_, end, NULL, FILE_BEGIN) || !SetEndOfFile(this->file_))
+        return false;
+#elif defined(__linux__)
+    if (posix_fallocate(this->file_, static_cast<off_t>(this->file_size_), static_cast<off_t>(size - this->file_size_)) != 0)
+        return false;
+#else
+    if (ftruncate(this->file_, static_cast<off_t>(size)) != 0)
+        return false;
+#endif
+    this->file_size_ = size;
+    return true;
+}
+
+bool SessionRecorder::MapRegion(uint64_t offset, size_t length, MappedRegion& region)
+{
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    uint64_t granularity = system_info.dwAllocationGranularity;
+#else
+    uint64_t granularity = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+    uint64_t aligned_offset = offset - offset % granularity;
+    size_t delta = static_cast<size_t>(offset - aligned_offset);
+
+#ifdef _WIN32
+    uint64_t end = offset + length;
+    HANDLE mapping = CreateFileMappingA(this->file_, NULL, PAGE_READWRITE, static_cast<DWORD>(end >> 32),
+        static_cast<DWORD>(end), NULL);
+    if (mapping == NULL)
+        return false;
+    void* base = MapViewOfFile(mapping, FILE_MAP_WRITE, static_cast<DWORD>(aligned_offset >> 32),
+        static_cast<DWORD>(aligned_offset), length + delta);
+    // The view keeps the mapping alive.
+    CloseHandle(mapping);
+    if (base == NULL)
+        return false;
+#else
+    void* base = mmap(nullptr, length + delta, PROT_READ | PROT_WRITE, MAP_SHARED, this->file_,
+        static_cast<off_t>(aligned_offset));
+    if (base == MAP_FAILED)
+        return false;
+#endif
+
+    region.base = base;
+    region.length = length + delta;
+    region.data = static_cast<uint8_t*>(base) + delta;
+    return true;
+}
+
+void SessionRecorder::UnmapRegion(MappedRegion& region)
+{
+    if (region.base == nullptr)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(region.base);
+#else
+    munmap(region.base, region.length);
+#endif
+    region = MappedRegion();
+}
+
+void SessionRecorder::FlushRegion(const MappedRegion& region, bool wait)
+{
+    if (region.base == nullptr)
+        return;
+#ifdef _WIN32
+    FlushViewOfFile(region.base, region.length);
+    if (wait)
+        FlushFileBuffers(this->file_);
+#else
+    msync(region.base, region.length, wait ? MS_SYNC : MS_ASYNC);
+#endif
+}
+
+void SessionRecorder::CloseFile()
+{
+    this->UnmapRegion(this->header_region_);
+#ifdef _WIN32
+    if (this->file_ != nullptr)
+        CloseHandle(this->file_);
+    this->file_ = nullptr;
+#else
+    if (this->file_ >= 0)
+        close(this->file_);
+    this->file_ = -1;
+#endif
+}
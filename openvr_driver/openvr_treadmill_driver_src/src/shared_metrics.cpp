@@ -0,0 +1,98 @@
+#include "shared_metrics.h"
+
+#include <new>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+SharedMetrics::~SharedMetrics()
+{
+    this->Close();
+}
+
+bool SharedMetrics::Open(const std::string& name)
+{
+    this->Close();
+
+    void* memory = nullptr;
+#ifdef _WIN32
+    std::string mapping_name = "Local\\" + name;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+        static_cast<DWORD>(sizeof(SharedMetricsBlock)), mapping_name.c_str());
+    if (mapping == NULL)
+        return false;
+
+    memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedMetricsBlock));
+    if (memory == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    this->mapping_ = mapping;
+    DWORD process_id = GetCurrentProcessId();
+#else
+    std::string object_name = "/" + name;
+    int descriptor = shm_open(object_name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (descriptor < 0)
+        return false;
+
+    if (ftruncate(descriptor, sizeof(SharedMetricsBlock)) != 0)
+    {
+        close(descriptor);
+        return false;
+    }
+
+    memory = mmap(nullptr, sizeof(SharedMetricsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (memory == MAP_FAILED)
+        return false;
+    pid_t process_id = getpid();
+#endif
+
+    // A tool may already watch the block of a previous driver instance, so the magic is
+    // cleared first and written last.
+    this->block_ = static_cast<SharedMetricsBlock*>(memory);
+    this->block_->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    this->block_->version = SharedMetricsBlock::VERSION;
+    this->block_->size = static_cast<uint32_t>(sizeof(SharedMetricsBlock));
+    this->block_->process_id = static_cast<uint32_t>(process_id);
+    new (&this->block_->metrics) Seqlock<SharedMetricsValues>();
+    std::atomic_thread_fence(std::memory_order_release);
+    this->block_->magic = SharedMetricsBlock::MAGIC;
+
+    this->name_ = name;
+    return true;
+}
+
+void SharedMetrics::Close()
+{
+    if (this->block_ == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(this->block_);
+    CloseHandle(this->mapping_);
+    this->mapping_ = nullptr;
+#else
+    munmap(this->block_, sizeof(SharedMetricsBlock));
+    shm_unlink(("/" + this->name_).c_str());
+#endif
+    this->block_ = nullptr;
+}
+
+bool SharedMetrics::IsOpen() const
+{
+    return this->block_ != nullptr;
+}
+
+void SharedMetrics::Publish(const SharedMetricsValues& values)
+{
+    if (this->block_ != nullptr)
+        this->block_->metrics.Store(values);
+}
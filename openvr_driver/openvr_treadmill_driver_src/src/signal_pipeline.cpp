@@ -0,0 +1,96 @@
+#include "signal_pipeline.h"
+
+#include <algorithm>
+
+SignalPipeline::SignalPipeline(const SignalPipelineSettings& settings)
+    : settings_(settings),
+      auto_calibrator_(settings.auto_calibration),
+      spike_filter_(settings.spike_filter),
+      gait_detector_(settings.gait_detector),
+      noise_floor_(settings.noise_floor)
+{
+}
+
+const ConditionedSample& SignalPipeline::Process(float raw_value, double timestamp)
+{
+    float value = this->spike_filter_.Process(this->Normalize(raw_value));
+
+    // The gait detector works on the absolute force, while the noise floor stage
+    // needs its idle classification of the very same sample.
+    this->output_.gait = this->gait_detector_.AddSample(value, timestamp);
+    bool idle = this->output_.gait.phase == GaitPhase::IDLE;
+    this->output_.value = this->noise_floor_.Process(value, idle, timestamp);
+
+    // The calibration sees the values before normalization, so that its bounds
+    // can directly replace the ones of the profile.
+    this->auto_calibrator_.Add(raw_value, idle);
+
+    CalibrationProfile profile;
+    if (this->auto_calibrator_.TakeSessionResult(profile))
+    {
+        this->settings_.calibration = profile;
+        this->has_calibration_result_ = true;
+
+        // The history of both stages was normalized with the old profile. The gait
+        // detector keeps its state, so that the step count continues.
+        this->spike_filter_.Reset();
+        this->noise_floor_.Reset();
+    }
+
+    return this->output_;
+}
+
+const ConditionedSample& SignalPipeline::GetOutput() const
+{
+    return this->output_;
+}
+
+void SignalPipeline::StartCalibration()
+{
+    this->auto_calibrator_.StartSession();
+}
+
+bool SignalPipeline::TakeCalibrationResult(CalibrationProfile& profile)
+{
+    if (!this->has_calibration_result_)
+        return false;
+
+    this->has_calibration_result_ = false;
+    profile = this->settings_.calibration;
+    return true;
+}
+
+const SignalPipelineSettings& SignalPipeline::GetSettings() const
+{
+    return this->settings_;
+}
+
+const AutoCalibrator& SignalPipeline::GetAutoCalibrator() const
+{
+    return this->auto_calibrator_;
+}
+
+void SignalPipeline::Reset()
+{
+    this->spike_filter_.Reset();
+    this->gait_detector_.Reset();
+    this->noise_floor_.Reset();
+    this->output_ = ConditionedSample();
+}
+
+const SpikeFilter& SignalPipeline::GetSpikeFilter() const
+{
+    return this->spike_filter_;
+}
+
+const NoiseFloorEstimator& SignalPipeline::GetNoiseFloor() const
+{
+    return this->noise_floor_;
+}
+
+float SignalPipeline::Normalize(float value) const
+{
+    const CalibrationProfile& profile = this->settings_.calibration;
+    float result = (value - profile.min_value) / (profile.max_value - profile.min_value);
+    return std::min(std::max(result, 0.0f), 1.0f);
+}
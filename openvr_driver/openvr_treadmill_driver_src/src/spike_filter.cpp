@@ -0,0 +1,147 @@
+#include "spike_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /**
+     * Sorts a fixed number of values with an odd-even transposition network. The
+     * sequence of compare-exchange operations does not depend on the data, so the
+     * compiler unrolls it into branch free min/max instructions.
+     */
+    template <size_t N>
+    void SortNetwork(float* values)
+    {
+        for (size_t round = 0; round < N; round++)
+        {
+            for (size_t i = round & 1; i + 1 < N; i += 2)
+            {
+                float low = std::min(values[i], values[i + 1]);
+                float high = std::max(values[i], values[i + 1]);
+                values[i] = low;
+                values[i + 1] = high;
+            }
+        }
+    }
+
+    /**
+     * Returns the median and the median absolute deviation of N values.
+     */
+    template <size_t N>
+    void MedianAndMad(const float* input, float& median, float& mad)
+    {
+        float values[N];
+        std::copy(input, input + N, values);
+        SortNetwork<N>(values);
+        median = values[N / 2];
+
+        for (size_t i = 0; i < N; i++)
+            values[i] = std::fabs(values[i] - median);
+        SortNetwork<N>(values);
+        mad = values[N / 2];
+    }
+}
+
+SpikeFilter::SpikeFilter(const SpikeFilterSettings& settings)
+    : settings_(settings)
+{
+    // Only odd windows have a single median element. Anything else is rounded to
+    // the next supported size.
+    if (this->settings_.window != 0)
+    {
+        this->settings_.window = std::min(std::max(this->settings_.window, size_t(3)), MAX_WINDOW);
+        this->settings_.window |= 1;
+    }
+}
+
+float SpikeFilter::Process(float value)
+{
+    if (this->settings_.window == 0)
+        return value;
+
+    if (this->history_size_ < this->settings_.window)
+    {
+        this->PushHistory(value);
+        this->last_input_ = value;
+        this->last_output_ = value;
+        return value;
+    }
+
+    float median = 0.0f;
+    float deviation = 0.0f;
+    this->ComputeBand(median, deviation);
+
+    if (this->has_candidate_)
+    {
+        this->has_candidate_ = false;
+
+        if (std::fabs(value - this->candidate_) <= std::fabs(value - median))
+        {
+            // The new level persists, so the candidate was the start of a real movement.
+            this->delayed_onsets_++;
+            this->PushHistory(this->candidate_);
+            this->PushHistory(value);
+            this->last_input_ = value;
+            this->last_output_ = value;
+            return value;
+        }
+
+        this->removed_spikes_++;
+        this->PushHistory(median);
+        this->last_input_ = median;
+    }
+
+    bool far_from_median = std::fabs(value - median) > deviation;
+    bool far_from_last = std::fabs(value - this->last_input_) > deviation;
+    if (far_from_median && far_from_last)
+    {
+        this->has_candidate_ = true;
+        this->candidate_ = value;
+        return this->last_output_;
+    }
+
+    this->PushHistory(value);
+    this->last_input_ = value;
+    this->last_output_ = value;
+    return value;
+}
+
+void SpikeFilter::Reset()
+{
+    *this = SpikeFilter(this->settings_);
+}
+
+size_t SpikeFilter::GetRemovedSpikes() const
+{
+    return this->removed_spikes_;
+}
+
+size_t SpikeFilter::GetDelayedOnsets() const
+{
+    return this->delayed_onsets_;
+}
+
+void SpikeFilter::PushHistory(float value)
+{
+    this->history_[this->history_index_] = value;
+    this->history_index_ = (this->history_index_ + 1) % this->settings_.window;
+    if (this->history_size_ < this->settings_.window)
+        this->history_size_++;
+}
+
+void SpikeFilter::ComputeBand(float& median, float& deviation) const
+{
+    float mad = 0.0f;
+    switch (this->settings_.window)
+    {
+    case 3: MedianAndMad<3>(this->history_.data(), median, mad); break;
+    case 5: MedianAndMad<5>(this->history_.data(), median, mad); break;
+    case 7: MedianAndMad<7>(this->history_.data(), median, mad); break;
+    case 9: MedianAndMad<9>(this->history_.data(), median, mad); break;
+    default: MedianAndMad<11>(this->history_.data(), median, mad); break;
+    }
+
+    // 1.4826 scales the MAD to the standard deviation of normally distributed noise.
+    deviation = std::max(this->settings_.threshold * 1.4826f * mad, this->settings_.min_deviation);
+}
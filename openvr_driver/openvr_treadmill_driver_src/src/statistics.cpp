@@ -0,0 +1,140 @@
+#include "statistics.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * Returns the index of the highest set bit of a value other than 0.
+ */
+static size_t GetHighestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    this->Reset();
+}
+
+void LatencyHistogram::Record(uint64_t microseconds)
+{
+    this->counts_[GetBucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    this->total_count_.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = this->max_.load(std::memory_order_relaxed);
+    while (microseconds > max && !this->max_.compare_exchange_weak(max, microseconds, std::memory_order_relaxed))
+        ;
+}
+
+void LatencyHistogram::RecordSeconds(double seconds)
+{
+    this->Record(static_cast<uint64_t>(std::max(seconds, 0.0) * 1.0e6));
+}
+
+uint64_t LatencyHistogram::GetCount(size_t bucket) const
+{
+    return this->counts_[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetTotalCount() const
+{
+    return this->total_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetMax() const
+{
+    return this->max_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double quantile) const
+{
+    uint64_t total = this->GetTotalCount();
+    if (total == 0)
+        return 0;
+
+    // The rank of the quantile, at least the first value.
+    uint64_t rank = static_cast<uint64_t>(std::max(quantile, 0.0) * total + 0.5);
+    rank = std::min(std::max(rank, uint64_t(1)), total);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++)
+    {
+        seen += this->GetCount(i);
+        if (seen >= rank)
+            return std::min(GetUpperBound(i) - 1, this->GetMax());
+    }
+    return this->GetMax();
+}
+
+size_t LatencyHistogram::GetBucket(uint64_t microseconds)
+{
+    if (microseconds < LINEAR_RANGE)
+        return static_cast<size_t>(microseconds);
+
+    // The top bits below the highest one select the sub-bucket of the power of two range.
+    size_t highest_bit = GetHighestBit(microseconds);
+    size_t range = highest_bit - GetHighestBit(LINEAR_RANGE);
+    if (range >= RANGES)
+        return BUCKETS - 1;
+
+    size_t sub_bucket = static_cast<size_t>(microseconds >> (highest_bit - GetHighestBit(SUB_BUCKETS))) - SUB_BUCKETS;
+    return LINEAR_RANGE + range * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetLowerBound(size_t bucket)
+{
+    if (bucket < LINEAR_RANGE)
+        return bucket;
+
+    size_t range = (bucket - LINEAR_RANGE) / SUB_BUCKETS;
+    size_t sub_bucket = (bucket - LINEAR_RANGE) % SUB_BUCKETS;
+    return uint64_t(SUB_BUCKETS + sub_bucket) << (range + 1);
+}
+
+uint64_t LatencyHistogram::GetUpperBound(size_t bucket)
+{
+    if (bucket < LINEAR_RANGE)
+        return bucket + 1;
+
+    size_t range = (bucket - LINEAR_RANGE) / SUB_BUCKETS;
+    size_t sub_bucket = (bucket - LINEAR_RANGE) % SUB_BUCKETS;
+    return uint64_t(SUB_BUCKETS + sub_bucket + 1) << (range + 1);
+}
+
+void LatencyHistogram::Reset()
+{
+    for (std::atomic<uint64_t>& count : this->counts_)
+        count.store(0, std::memory_order_relaxed);
+    this->total_count_.store(0, std::memory_order_relaxed);
+    this->max_.store(0, std::memory_order_relaxed);
+}
+
+void CaptureStatistics::Reset()
+{
+    this->samples = 0;
+    this->read_errors = 0;
+    this->reconnects = 0;
+    this->removed_spikes = 0;
+    this->wakeups = 0;
+    this->line_latency.Reset();
+    this->processing_latency.Reset();
+}
+
+void DriverStatistics::Reset()
+{
+    this->frames = 0;
+    this->input_updates = 0;
+    this->consumed_samples = 0;
+    this->publisher_wakeups = 0;
+    this->sample_latency.Reset();
+    this->total_latency.Reset();
+}
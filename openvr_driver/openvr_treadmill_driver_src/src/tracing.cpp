@@ -0,0 +1,249 @@
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static const char* trace_event_names[] = {
+    "serial read",
+    "parse",
+    "pipeline",
+    "publish",
+    "standby",
+    "reconnect",
+    "find port",
+    "open port",
+    "RunFrame",
+    "PublishInputs",
+};
+
+static_assert(sizeof(trace_event_names) / sizeof(trace_event_names[0]) == static_cast<size_t>(TraceEventId::COUNT),
+    "Every trace event needs a name");
+
+/**
+ * The ring buffer of one thread. Only the owning thread writes, WriteChromeTrace() reads
+ * concurrently. The events are stored in relaxed atomic words, which compile to plain
+ * stores, so that the concurrent read is no data race.
+ */
+struct TraceBuffer
+{
+    // The steady clock time in nanoseconds, and the id, phase and argument packed into
+    // the second word.
+    std::array<std::atomic<uint64_t>, Tracer::EVENTS_PER_THREAD> times;
+    std::array<std::atomic<uint64_t>, Tracer::EVENTS_PER_THREAD> events;
+    std::atomic<uint64_t> position{ 0 };
+    const char* thread_name = nullptr;
+    uint32_t thread_id = 0;
+    // The owning thread finished, a new thread may take the buffer over.
+    bool released = false;
+};
+
+/**
+ * The buffer of the calling thread, which it gives back when it finishes.
+ */
+struct TraceThread
+{
+    TraceBuffer* buffer = nullptr;
+    const char* name = nullptr;
+    // All buffers were in use when the thread tried to get one.
+    bool without_buffer = false;
+
+    ~TraceThread();
+};
+
+static_assert((Tracer::EVENTS_PER_THREAD & (Tracer::EVENTS_PER_THREAD - 1)) == 0, "The ring size must be a power of two");
+
+static std::mutex trace_buffers_lock;
+static std::vector<std::unique_ptr<TraceBuffer>> trace_buffers;
+static uint32_t trace_thread_count = 0;
+static std::atomic<uint64_t> trace_start_time{ 0 };
+
+static thread_local TraceThread trace_thread;
+
+TraceThread::~TraceThread()
+{
+    if (this->buffer == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(trace_buffers_lock);
+    this->buffer->released = true;
+}
+
+/**
+ * Hands the calling thread a released buffer or a new one. Returns null if all buffers
+ * are in use.
+ */
+static TraceBuffer* AcquireTraceBuffer()
+{
+    if (trace_thread.without_buffer)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(trace_buffers_lock);
+    TraceBuffer* buffer = nullptr;
+    for (const std::unique_ptr<TraceBuffer>& candidate : trace_buffers)
+    {
+        if (candidate->released)
+        {
+            // The events of the finished thread are dropped, and the new thread gets an
+            // id of its own in the trace.
+            buffer = candidate.get();
+            buffer->position.store(0, std::memory_order_relaxed);
+            buffer->released = false;
+            break;
+        }
+    }
+    if (buffer == nullptr && trace_buffers.size() < Tracer::MAX_THREADS)
+    {
+        trace_buffers.push_back(std::make_unique<TraceBuffer>());
+        buffer = trace_buffers.back().get();
+    }
+    if (buffer == nullptr)
+    {
+        trace_thread.without_buffer = true;
+        return nullptr;
+    }
+
+    buffer->thread_name = trace_thread.name;
+    buffer->thread_id = ++trace_thread_count;
+    trace_thread.buffer = buffer;
+    return buffer;
+}
+
+static uint64_t GetTraceTime()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::Start()
+{
+    trace_start_time.store(GetTraceTime(), std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Stop()
+{
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::SetThreadName(const char* name)
+{
+    trace_thread.name = name;
+    if (trace_thread.buffer != nullptr)
+        trace_thread.buffer->thread_name = name;
+}
+
+void Tracer::Record(TraceEventId id, TracePhase phase, uint32_t argument)
+{
+    // The first event of a thread takes its buffer.
+    TraceBuffer* buffer = trace_thread.buffer;
+    if (buffer == nullptr)
+    {
+        buffer = AcquireTraceBuffer();
+        if (buffer == nullptr)
+            return;
+    }
+
+    uint64_t position = buffer->position.load(std::memory_order_relaxed);
+    size_t slot = static_cast<size_t>(position & (EVENTS_PER_THREAD - 1));
+    uint64_t event = static_cast<uint64_t>(id) | (static_cast<uint64_t>(phase) << 16) | (static_cast<uint64_t>(argument) << 32);
+    buffer->times[slot].store(GetTraceTime(), std::memory_order_relaxed);
+    buffer->events[slot].store(event, std::memory_order_relaxed);
+    buffer->position.store(position + 1, std::memory_order_release);
+}
+
+/**
+ * A decoded event of the written trace.
+ */
+struct TraceRecord
+{
+    uint64_t time;
+    uint64_t event;
+};
+
+/**
+ * Copies the events of a buffer that were not overwritten during the copy.
+ */
+static void CopyEvents(const TraceBuffer& buffer, std::vector<TraceRecord>& records)
+{
+    uint64_t end = buffer.position.load(std::memory_order_acquire);
+    uint64_t begin = end > Tracer::EVENTS_PER_THREAD ? end - Tracer::EVENTS_PER_THREAD : 0;
+
+    records.clear();
+    for (uint64_t position = begin; position < end; position++)
+    {
+        size_t slot = static_cast<size_t>(position & (Tracer::EVENTS_PER_THREAD - 1));
+        records.push_back({ buffer.times[slot].load(std::memory_order_relaxed), buffer.events[slot].load(std::memory_order_relaxed) });
+    }
+
+    // Events the thread recorded meanwhile overwrote the oldest copied ones.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t written = buffer.position.load(std::memory_order_relaxed);
+    uint64_t first_valid = written > Tracer::EVENTS_PER_THREAD ? written - Tracer::EVENTS_PER_THREAD : 0;
+    if (first_valid > begin)
+        records.erase(records.begin(), records.begin() + static_cast<ptrdiff_t>(std::min(first_valid - begin, end - begin)));
+}
+
+bool Tracer::WriteChromeTrace(const std::string& file)
+{
+    std::ofstream trace(file);
+    if (!trace)
+        return false;
+
+    uint64_t start_time = trace_start_time.load(std::memory_order_relaxed);
+    std::vector<TraceRecord> records;
+    records.reserve(EVENTS_PER_THREAD);
+    char line[256];
+    bool first = true;
+
+    trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::lock_guard<std::mutex> lock(trace_buffers_lock);
+    for (const std::unique_ptr<TraceBuffer>& buffer : trace_buffers)
+    {
+        if (buffer->thread_name != nullptr)
+        {
+            snprintf(line, sizeof(line), "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", buffer->thread_id, buffer->thread_name);
+            trace << line;
+            first = false;
+        }
+
+        CopyEvents(*buffer, records);
+        for (const TraceRecord& record : records)
+        {
+            if (record.time < start_time)
+                continue;
+
+            size_t id = static_cast<size_t>(record.event & 0xFFFF);
+            char phase = static_cast<char>((record.event >> 16) & 0xFF);
+            uint32_t argument = static_cast<uint32_t>(record.event >> 32);
+            if (id >= static_cast<size_t>(TraceEventId::COUNT))
+                continue;
+
+            // The Chrome format counts in microseconds, the fraction keeps the nanoseconds.
+            snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u%s",
+                first ? "" : ",", trace_event_names[id], phase, (record.time - start_time) / 1000.0, buffer->thread_id,
+                phase == static_cast<char>(TracePhase::INSTANT) ? ",\"s\":\"t\"" : "");
+            trace << line;
+            if (argument != 0)
+                trace << ",\"args\":{\"value\":" << argument << "}";
+            trace << "}";
+            first = false;
+        }
+    }
+
+    trace << "\n]}\n";
+    return static_cast<bool>(trace);
+}
+
+size_t Tracer::GetBufferCount()
+{
+    std::lock_guard<std::mutex> lock(trace_buffers_lock);
+    return trace_buffers.size();
+}
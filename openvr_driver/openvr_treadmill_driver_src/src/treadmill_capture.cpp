@@ -2,15 +2,70 @@
 
 #include <limits>
 #include <cmath>
-#include <setupapi.h>
-#include <devguid.h>
-#include <regstr.h>
-#include <regex>
+#include <chrono>
+#include <cstdio>
 
 #include "driverlog.h"
-#include "utils.h"
+#include "tracing.h"
 
-#pragma comment(lib, "setupapi.lib")
+// The read timeouts must be longer than the time between two lines of the load cell
+// module. In standby it only sends a heartbeat every second.
+static const uint32_t FULL_RATE_READ_TIMEOUT = 100;
+static const uint32_t STANDBY_READ_TIMEOUT = 2500;
+
+std::mutex TreadmillCapture::claimed_ports_lock_;
+std::set<std::string> TreadmillCapture::claimed_ports_;
+
+TreadmillCapture::TreadmillCapture()
+    : TreadmillCapture(SerialTransport::Create())
+{
+}
+
+TreadmillCapture::TreadmillCapture(std::unique_ptr<SerialTransport> transport, Clock& clock)
+    : transport_(std::move(transport)),
+      clock_(clock)
+{
+}
+
+void TreadmillCapture::Configure(const SignalPipelineSettings& settings, const std::string& port_match)
+{
+    this->pipeline_ = SignalPipeline(settings);
+    this->port_match_ = port_match;
+    this->calibration_ = settings.calibration;
+}
+
+void TreadmillCapture::SetSampleListener(std::function<void(const TreadmillSample&)> listener)
+{
+    this->sample_listener_ = std::move(listener);
+}
+
+bool TreadmillCapture::StartRecording(const std::string& file, const std::string& metadata)
+{
+    if (this->update_loop_thread_.joinable())
+        return false;
+
+    const SignalPipelineSettings& settings = this->pipeline_.GetSettings();
+    char pipeline[512];
+    snprintf(pipeline, sizeof(pipeline),
+        "port_match=%s\ncalibration_min=%g\ncalibration_max=%g\nspike_filter_window=%zu\n"
+        "spike_filter_threshold=%g\nspike_filter_min_deviation=%g\nauto_deadzone=%d\nidle_band=%g\n"
+        "max_idle_baseline=%g\n",
+        this->port_match_.c_str(), settings.calibration.min_value, settings.calibration.max_value,
+        settings.spike_filter.window, settings.spike_filter.threshold, settings.spike_filter.min_deviation,
+        settings.noise_floor.enabled ? 1 : 0, settings.noise_floor.idle_band, settings.noise_floor.max_baseline);
+
+    double now = this->clock_.Now();
+    if (!this->recorder_.Open(file, now, metadata + pipeline))
+        return false;
+    this->recorder_.Record(SessionRecordType::CONFIG, 0, now, 0.0, settings.calibration.min_value,
+        settings.calibration.max_value);
+    return true;
+}
+
+bool TreadmillCapture::isRecording()
+{
+    return this->recorder_.IsOpen();
+}
 
 void TreadmillCapture::StartBackgroundCapture()
 {
@@ -21,6 +76,59 @@ void TreadmillCapture::StopBackgroundCapture()
 {
     this->StopUpdateLoop();
     this->CloseDevice();
+    this->recorder_.Close();
+}
+
+void TreadmillCapture::StartCalibration()
+{
+    this->calibration_requested_ = true;
+}
+
+bool TreadmillCapture::TakeCalibrationResult(CalibrationProfile& profile)
+{
+    // Checked on every frame, so the common case must not touch the lock.
+    if (!this->has_calibration_result_.exchange(false))
+        return false;
+
+    std::lock_guard<std::mutex> lock(this->value_lock_);
+    profile = this->calibration_result_;
+    return true;
+}
+
+CalibrationProfile TreadmillCapture::GetCalibration()
+{
+    std::lock_guard<std::mutex> lock(this->value_lock_);
+    return this->calibration_;
+}
+
+bool TreadmillCapture::GetCalibrationSuggestion(CalibrationProfile& profile)
+{
+    std::lock_guard<std::mutex> lock(this->value_lock_);
+    profile = this->calibration_suggestion_;
+    return this->has_calibration_suggestion_;
+}
+
+void TreadmillCapture::SetStandby(bool standby)
+{
+    if (this->standby_requested_.exchange(standby) == standby)
+        return;
+
+    // Entering the standby can wait for the current read, but leaving it must not
+    // wait for the next heartbeat. The read is aborted and the capture thread then
+    // switches the module back to full rate. A read starting right after the cancel
+    // delays the switch until the next heartbeat at worst.
+    if (!standby && this->update_loop_thread_.joinable())
+        this->transport_->CancelRead();
+}
+
+bool TreadmillCapture::isStandby()
+{
+    return this->standby_requested_;
+}
+
+CaptureStatistics& TreadmillCapture::GetStatistics()
+{
+    return this->statistics_;
 }
 
 bool TreadmillCapture::isActive()
@@ -33,90 +141,69 @@ bool TreadmillCapture::isConnected()
     return this->is_connected_;
 }
 
-std::wstring TreadmillCapture::FindSerialPort(std::wstring device_substring)
+std::string TreadmillCapture::FindSerialPort(const std::string& device_substring)
 {
-    HDEVINFO deviceInfoSet = SetupDiGetClassDevs(&GUID_DEVCLASS_PORTS, nullptr, nullptr, DIGCF_PRESENT);
-    if (deviceInfoSet == INVALID_HANDLE_VALUE) {
-        return L"";
-    }
-
-    SP_DEVINFO_DATA devInfoData = {};
-    devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
-    std::wstring found_port = L"";
-
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(deviceInfoSet, i, &devInfoData); ++i) {
-        TCHAR buffer[256];
-        DWORD buffersize = 0;
-        
-        // Get the friendly name
-        if (SetupDiGetDeviceRegistryProperty(deviceInfoSet, &devInfoData, SPDRP_FRIENDLYNAME,
-            nullptr, (PBYTE)buffer, sizeof(buffer), &buffersize)) {
-
-            // Optional: detect Arduino by matching known patterns
-            std::wstring name = std::wstring(buffer);
-            if (name.find(device_substring) != std::wstring::npos) {
-                found_port = TreadmillCapture::ExtractSerialPortFromName(name);
-                break;
-            }
-        }
-    }
-
-    SetupDiDestroyDeviceInfoList(deviceInfoSet);
-    return found_port;
+    std::lock_guard<std::mutex> lock(TreadmillCapture::claimed_ports_lock_);
+    return this->transport_->FindPort(device_substring, TreadmillCapture::claimed_ports_);
 }
 
-std::wstring TreadmillCapture::ExtractSerialPortFromName(std::wstring serial_name)
+int TreadmillCapture::OpenDevice(const std::string& com_port, uint32_t baud_rate)
 {
-    std::wregex pattern(L"\\((COM\\d+)\\)");
-    std::wsmatch match;
+    std::lock_guard<std::mutex> lock(this->serial_lock_);
 
-    if (std::regex_search(serial_name, match, pattern) && match.size() > 1)
+    this->com_port_ = com_port;
+    if (com_port.empty() || !this->transport_->Open(com_port, baud_rate))
     {
-        std::wstring comport = match[1].str();
-        return comport;
+        DriverLog("Failed to open serial port");
+        this->is_connected_ = false;
+        this->recorder_.Record(SessionRecordType::CONNECT, 0, this->clock_.Now(), 0.0, static_cast<float>(baud_rate));
+        return -1;
     }
-    else
+
     {
-        return L"";
+        std::lock_guard<std::mutex> claimed_lock(TreadmillCapture::claimed_ports_lock_);
+        TreadmillCapture::claimed_ports_.insert(com_port);
     }
+
+    // The module restarts with full rate streaming when the port is opened.
+    this->transport_->SetReadTimeout(FULL_RATE_READ_TIMEOUT);
+    this->standby_applied_ = false;
+
+    this->is_connected_ = true;
+    this->recorder_.Record(SessionRecordType::CONNECT, 1, this->clock_.Now(), 0.0, static_cast<float>(baud_rate));
+    DriverLog("Connected to serial port");
+
+    return 0;
+}
+
+void TreadmillCapture::ResetDevice()
+{
+    std::lock_guard<std::mutex> lock(this->serial_lock_);
+    this->transport_->Reset();
+    this->receive_position_ = 0;
+    this->receive_length_ = 0;
+    this->line_parser_.Reset();
 }
 
-int TreadmillCapture::OpenDevice(std::wstring com_port, DWORD baud_rate)
+int TreadmillCapture::ApplyStandby(bool standby)
 {
     std::lock_guard<std::mutex> lock(this->serial_lock_);
 
-	this->com_port_ = com_port;
-	this->serial_handle_ = CreateFile(com_port.c_str(), GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    // The mode counts as applied even if the command got lost. The module then sends
+    // at an unexpected rate, which ends in the usual reconnect and a fresh attempt.
+    this->transport_->SetReadTimeout(standby ? STANDBY_READ_TIMEOUT : FULL_RATE_READ_TIMEOUT);
+    this->standby_applied_ = standby;
+    TraceEvent(TraceEventId::STANDBY, TracePhase::INSTANT, standby ? 1 : 0);
+    this->recorder_.Record(SessionRecordType::STANDBY, standby ? 1 : 0, this->clock_.Now());
 
-    if (this->serial_handle_ == INVALID_HANDLE_VALUE)
+    char command = standby ? 'S' : 'F';
+    if (!this->transport_->Write(&command, 1))
     {
-        DriverLog("Failed to open serial port");
-        this->is_connected_ = false;
+        DriverLog("Failed to send the rate command to the treadmill");
         return -1;
     }
 
-    // Config serial port parameter
-    DCB serialParams = { 0 };
-    serialParams.DCBlength = sizeof(serialParams);
-    GetCommState(this->serial_handle_, &serialParams);
-    serialParams.BaudRate = baud_rate;
-    serialParams.ByteSize = 8;
-    serialParams.StopBits = 1;
-    serialParams.Parity = 0;
-    SetCommState(this->serial_handle_, &serialParams);
-
-    // Config timeout parameters
-    COMMTIMEOUTS timeout = { 0 };
-    timeout.ReadIntervalTimeout = 100;
-    timeout.ReadTotalTimeoutConstant = 100;
-    timeout.ReadTotalTimeoutMultiplier = 100;
-    timeout.WriteTotalTimeoutConstant = 100;
-    timeout.WriteTotalTimeoutMultiplier = 20;
-    SetCommTimeouts(this->serial_handle_, &timeout);
-
-    this->is_connected_ = true;
-    DriverLog("Connected to serial port");
-
+    DriverLog(standby ? "Treadmill entered standby" : "Treadmill left standby");
     return 0;
 }
 
@@ -124,95 +211,188 @@ float TreadmillCapture::ReadValue()
 {
     std::lock_guard<std::mutex> lock(this->serial_lock_);
 
-    ClearCommError(this->serial_handle_, &this->errors_, &this->status_);
-
-    char ch;
-    DWORD bytesRead = 0;
-    int chars_read = 0;
-    bool error = false;
+    bool line_ended = false;
 
+    TraceEvent(TraceEventId::SERIAL_READ, TracePhase::BEGIN);
     while (this->active_) {
-        if (!ReadFile(this->serial_handle_, &ch, 1, &bytesRead, NULL) || bytesRead == 0)
-        {
-            this->buffer_[0] = '\0';
-            error = true;
-            break;
-        }
-
-        if (chars_read > 128)
+        // The module sends faster than a line per read at times, the rest of a read
+        // is kept for the next call.
+        if (this->receive_position_ == this->receive_length_)
         {
-            this->buffer_[0] = '\0';
-            error = true;
-            break;
+            int bytes_read = this->transport_->Read(this->receive_buffer_, sizeof(this->receive_buffer_));
+            this->statistics_.wakeups.fetch_add(1, std::memory_order_relaxed);
+            if (bytes_read <= 0)
+            {
+                this->line_parser_.Reset();
+                break;
+            }
+            this->receive_position_ = 0;
+            this->receive_length_ = static_cast<size_t>(bytes_read);
+            this->receive_time_ = this->clock_.Now();
         }
 
-        if (ch == 13)
+        char ch = this->receive_buffer_[this->receive_position_++];
+        if (this->line_parser_.Push(ch, this->receive_time_))
         {
-            this->buffer_[chars_read] = '\0';
+            line_ended = true;
             break;
         }
-        else if (ch != 10)
-        {
-            this->buffer_[chars_read] = ch;
-            chars_read++;
-        }
     }
 
-    //DriverLog(this->buffer_);
+    TraceEvent(TraceEventId::SERIAL_READ, TracePhase::END, static_cast<uint32_t>(this->line_parser_.GetLength()));
 
-    if (!error)
-    {
-        try
-        {
-            return (float)std::atof(this->buffer_);
-        }
-        catch (const std::exception&)
-        {
-            DriverLog("Cannot cast buffer to float");
-            return std::numeric_limits<float>::quiet_NaN();
-        }
-    }
+    //DriverLog(this->line_parser_.GetLine());
+
+    if (!line_ended || this->line_parser_.IsOverflow())
+        return std::numeric_limits<float>::quiet_NaN();
 
-    return std::numeric_limits<float>::quiet_NaN();
+    this->line_start_time_ = this->line_parser_.GetFirstByteTime();
+    this->line_end_time_ = this->line_parser_.GetEndTime();
+    this->line_binary_ = this->line_parser_.IsBinary();
+
+    TraceScope trace(TraceEventId::PARSE);
+    return this->line_parser_.GetValue();
 }
 
 void TreadmillCapture::UpdateValueLoop()
 {
     const int MAX_ERRORS_ALLOWED = 10;
-    static int i = 0;
+    Tracer::SetThreadName("capture");
     while (this->active_)
     {
+        bool standby = this->standby_requested_;
+        if (standby != this->standby_applied_ && this->is_connected_)
+            this->ApplyStandby(standby);
+
         float tmp_value = this->ReadValue();
-        bool error = isnan(tmp_value);
+        bool error = std::isnan(tmp_value);
         if (error)
             tmp_value = 0.0;
+
+        // A read aborted by leaving the standby is no connection problem. Without a
+        // connection the mode cannot be applied, and the errors must lead to a reconnect.
+        if (error && this->is_connected_ && this->standby_requested_ != this->standby_applied_)
+            continue;
+
+        // The pipeline only sees real samples, a read error must not look like a
+        // sudden drop of the pull force.
+        double timestamp = this->clock_.Now();
+        if (this->calibration_requested_.exchange(false))
+        {
+            this->pipeline_.StartCalibration();
+            this->recorder_.Record(SessionRecordType::CALIBRATION_START, 0, timestamp);
+        }
+        float raw_value = tmp_value;
+
+        GaitState gait_state = this->pipeline_.GetOutput().gait;
+        CalibrationProfile calibration_result;
+        bool has_calibration_result = false;
+        if (!error)
+        {
+            size_t removed_spikes = this->pipeline_.GetSpikeFilter().GetRemovedSpikes();
+            TraceEvent(TraceEventId::PIPELINE, TracePhase::BEGIN);
+            const ConditionedSample& sample = this->pipeline_.Process(tmp_value, timestamp);
+            TraceEvent(TraceEventId::PIPELINE, TracePhase::END);
+            tmp_value = sample.value;
+            gait_state = sample.gait;
+            has_calibration_result = this->pipeline_.TakeCalibrationResult(calibration_result);
+
+            this->statistics_.samples.fetch_add(1, std::memory_order_relaxed);
+            this->statistics_.line_latency.RecordSeconds(this->line_end_time_ - this->line_start_time_);
+            // A new calibration profile resets the spike filter and its count.
+            if (!has_calibration_result)
+                this->statistics_.removed_spikes.fetch_add(
+                    this->pipeline_.GetSpikeFilter().GetRemovedSpikes() - removed_spikes, std::memory_order_relaxed);
+        }
+        else
+        {
+            this->statistics_.read_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        CalibrationProfile suggestion;
+        bool has_suggestion = this->pipeline_.GetAutoCalibrator().GetSuggestion(suggestion);
+
+        TreadmillSample sample;
+        sample.value = tmp_value;
+        sample.gait = gait_state;
+        sample.sequence = ++this->sequence_;
+        sample.timestamp = timestamp;
+        sample.first_byte_time = error ? 0.0 : this->line_start_time_;
+        sample.publish_time = this->clock_.Now();
+        this->sample_.Store(sample);
+        TraceEvent(TraceEventId::PUBLISH, TracePhase::INSTANT, static_cast<uint32_t>(sample.sequence));
+        if (this->sample_listener_)
+            this->sample_listener_(sample);
+
+        if (error)
+        {
+            this->recorder_.Record(SessionRecordType::READ_ERROR, 0, timestamp);
+        }
+        else
+        {
+            uint16_t flags = static_cast<uint16_t>(static_cast<uint16_t>(gait_state.phase) |
+                (gait_state.step_event ? 4 : 0) | (this->line_binary_ ? 8 : 0));
+            this->recorder_.Record(SessionRecordType::SAMPLE, flags, timestamp, this->line_start_time_, raw_value, tmp_value);
+            if (has_calibration_result)
+                this->recorder_.Record(SessionRecordType::CONFIG, 1, timestamp, 0.0, calibration_result.min_value,
+                    calibration_result.max_value);
+        }
+        if (!error)
+            this->statistics_.processing_latency.RecordSeconds(sample.publish_time - this->line_end_time_);
+
         this->value_lock_.lock();
-        this->treadmill_value_ = tmp_value;
+        this->calibration_suggestion_ = suggestion;
+        this->has_calibration_suggestion_ = has_suggestion;
+        if (has_calibration_result)
+        {
+            this->calibration_result_ = calibration_result;
+            this->calibration_ = calibration_result;
+        }
         this->value_lock_.unlock();
 
+        // Taking the wait lock orders the publication before a waiter checking the
+        // sequence, so that no wakeup gets lost.
+        this->wait_lock_.lock();
+        this->wait_lock_.unlock();
+        this->sample_published_.notify_all();
+
+        if (has_calibration_result)
+            this->has_calibration_result_ = true;
+
         if (error)
-            i++;
+            this->consecutive_errors_++;
         else
-            i = 0;
+            this->consecutive_errors_ = 0;
 
         // This error counter conceptually is a little fragile, but empirically it is very robust.
         // It is needed to not overinterpret every single issue as a connection loss and reconnect every time.
         // This would lead to constant error and reconnection loops, because the serial device in the beginning
         // always timeouts a few times before being stable.
-        if (i > MAX_ERRORS_ALLOWED)
+        if (this->consecutive_errors_ > MAX_ERRORS_ALLOWED)
         {
-            i = 0;
+            this->recorder_.Record(SessionRecordType::RECONNECT, 0, this->clock_.Now(), 0.0,
+                static_cast<float>(this->consecutive_errors_));
+            this->consecutive_errors_ = 0;
+            TraceEvent(TraceEventId::RECONNECT, TracePhase::BEGIN);
+            this->statistics_.reconnects.fetch_add(1, std::memory_order_relaxed);
+            this->pipeline_.Reset();
             this->CloseDevice();
-            std::wstring device = this->FindSerialPort(L"Arduino");
-            DriverLog("Found Device: (below)");
-            DriverLog(WstrToStr(device).c_str());
-            Sleep(1000);
+            TraceEvent(TraceEventId::FIND_PORT, TracePhase::BEGIN);
+            std::string device = this->FindSerialPort(this->port_match_);
+            TraceEvent(TraceEventId::FIND_PORT, TracePhase::END);
+            if (!device.empty())
+            {
+                DriverLog("Found Device: (below)");
+                DriverLog("%s", device.c_str());
+            }
+            this->clock_.SleepFor(1.0);
+            TraceEvent(TraceEventId::OPEN_PORT, TracePhase::BEGIN);
             this->OpenDevice(device, 9600);
-            PurgeComm(this->serial_handle_, PURGE_RXCLEAR | PURGE_TXCLEAR);
-            Sleep(500);
-            EscapeCommFunction(this->serial_handle_, SETDTR);
-            EscapeCommFunction(this->serial_handle_, SETRTS);
-            Sleep(500);
+            TraceEvent(TraceEventId::OPEN_PORT, TracePhase::END, this->is_connected_ ? 1 : 0);
+            this->clock_.SleepFor(0.5);
+            this->ResetDevice();
+            this->clock_.SleepFor(0.5);
+            TraceEvent(TraceEventId::RECONNECT, TracePhase::END);
         }
     }
 }
@@ -227,6 +407,9 @@ int TreadmillCapture::StartUpdateLoop()
 int TreadmillCapture::StopUpdateLoop()
 {
     this->active_ = false;
+    this->wait_lock_.lock();
+    this->wait_lock_.unlock();
+    this->sample_published_.notify_all();
     if (this->update_loop_thread_.joinable())
     {
         this->update_loop_thread_.join();
@@ -237,10 +420,13 @@ int TreadmillCapture::StopUpdateLoop()
 int TreadmillCapture::CloseDevice()
 {
     std::lock_guard<std::mutex> lock(this->serial_lock_);
-    if (this->serial_handle_ != INVALID_HANDLE_VALUE)
+    if (this->transport_->IsOpen())
     {
-        CloseHandle(this->serial_handle_);
-        this->serial_handle_ = INVALID_HANDLE_VALUE;
+        this->transport_->Close();
+        this->recorder_.Record(SessionRecordType::DISCONNECT, 0, this->clock_.Now());
+
+        std::lock_guard<std::mutex> claimed_lock(TreadmillCapture::claimed_ports_lock_);
+        TreadmillCapture::claimed_ports_.erase(this->com_port_);
     }
     this->is_connected_ = false;
     return 0;
@@ -248,6 +434,29 @@ int TreadmillCapture::CloseDevice()
 
 float TreadmillCapture::GetTreadmillValue()
 {
-    std::lock_guard<std::mutex> lock(this->value_lock_);
-    return this->treadmill_value_;
+    return this->sample_.Load().value;
+}
+
+TreadmillSample TreadmillCapture::GetTreadmillSample()
+{
+    return this->sample_.Load();
+}
+
+bool TreadmillCapture::WaitForSample(uint64_t last_sequence, std::chrono::milliseconds timeout, TreadmillSample& sample)
+{
+    TreadmillSample current = this->sample_.Load();
+    if (current.sequence == last_sequence)
+    {
+        std::unique_lock<std::mutex> lock(this->wait_lock_);
+        this->sample_published_.wait_for(lock, timeout, [this, last_sequence, &current]() {
+            current = this->sample_.Load();
+            return current.sequence != last_sequence || !this->active_;
+        });
+    }
+
+    if (current.sequence == last_sequence)
+        return false;
+
+    sample = current;
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include <cmath>
+#include <random>
+
+#include "anchor_calibrator.h"
+#include "test_framework.h"
+
+static const float ANCHOR_X = 1.0f;
+static const float ANCHOR_Z = -2.0f;
+static const float ROPE_LENGTH = 2.0f;
+static const float STRETCH = 0.3f;
+
+/**
+ * Accumulates headset positions on an arc of 120 degrees around the anchor, pulled with
+ * forces between 0.2 and 0.8. The first half of the samples has the given position
+ * noise, the second half the other one.
+ */
+static void AddArc(AnchorCalibrator& calibrator, size_t samples, float first_noise, float second_noise)
+{
+    std::mt19937 generator(7);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    for (size_t i = 0; i < samples; i++)
+    {
+        float angle = 2.1f * uniform(generator) - 1.05f;
+        float force = 0.2f + 0.6f * uniform(generator);
+        float distance = ROPE_LENGTH + STRETCH * force;
+        float noise = i < samples / 2 ? first_noise : second_noise;
+        calibrator.Accumulate(ANCHOR_X + distance * std::sin(angle) + noise * normal(generator),
+                              ANCHOR_Z + distance * std::cos(angle) + noise * normal(generator), force);
+    }
+}
+
+TEST_CASE(anchor_calibrator_fits_arc)
+{
+    AnchorCalibrator calibrator;
+    AnchorEstimate estimate;
+    AddArc(calibrator, 200, 0.01f, 0.01f);
+    CHECK(!calibrator.Solve(estimate));
+
+    AddArc(calibrator, 400, 0.01f, 0.01f);
+    CHECK(calibrator.Solve(estimate));
+    CHECK_NEAR(estimate.anchor_x, ANCHOR_X, 0.02f);
+    CHECK_NEAR(estimate.anchor_z, ANCHOR_Z, 0.02f);
+    CHECK_NEAR(estimate.rope_length, ROPE_LENGTH, 0.02f);
+    CHECK_NEAR(estimate.stretch, STRETCH, 0.03f);
+    CHECK_NEAR(estimate.residual, 0.01f, 0.002f);
+    CHECK(estimate.samples == 600);
+}
+
+TEST_CASE(anchor_calibrator_rejects_short_arc)
+{
+    // A few centimeters of arc do not pin down the anchor.
+    AnchorCalibrator calibrator;
+    std::mt19937 generator(3);
+    std::normal_distribution<float> normal(0.0f, 0.01f);
+    for (int i = 0; i < 600; i++)
+    {
+        float angle = 0.02f * static_cast<float>(i % 10);
+        calibrator.Accumulate(ANCHOR_X + ROPE_LENGTH * std::sin(angle) + normal(generator),
+                              ANCHOR_Z + ROPE_LENGTH * std::cos(angle) + normal(generator), 0.5f);
+    }
+    AnchorEstimate estimate;
+    CHECK(!calibrator.Solve(estimate));
+}
+
+TEST_CASE(anchor_calibrator_even_decimation)
+{
+    // More samples than are stored. The residual of the stored samples must weight
+    // both halves of the session equally, i.e. the thinning must not favor the
+    // latest samples.
+    AnchorCalibrator calibrator;
+    AddArc(calibrator, 20000, 0.005f, 0.03f);
+    AnchorEstimate estimate;
+    CHECK(calibrator.Solve(estimate));
+    float expected = std::sqrt((0.005f * 0.005f + 0.03f * 0.03f) / 2.0f);
+    CHECK_NEAR(estimate.residual, expected, 0.1f * expected);
+    CHECK_NEAR(estimate.anchor_x, ANCHOR_X, 0.01f);
+    CHECK_NEAR(estimate.anchor_z, ANCHOR_Z, 0.01f);
+    CHECK(estimate.samples == 20000);
+}
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gait_detector.h"
+#include "test_framework.h"
+
+static const double SAMPLE_RATE = 10.0;
+static const double PI = 3.14159265358979;
+
+/**
+ * Feeds a pull force oscillating once per step at the given cadence and returns the
+ * state after the last sample.
+ */
+static GaitState FeedSteps(GaitDetector& detector, double& time, double seconds, double cadence, float mean,
+    float amplitude)
+{
+    GaitState state;
+    double end = time + seconds;
+    for (; time < end; time += 1.0 / SAMPLE_RATE)
+    {
+        float value = mean + amplitude * static_cast<float>(std::sin(2.0 * PI * cadence / 60.0 * time));
+        state = detector.AddSample(value, time);
+    }
+    return state;
+}
+
+TEST_CASE(gait_detector_walking_cadence)
+{
+    GaitDetector detector;
+    double time = 0.0;
+    GaitState state = FeedSteps(detector, time, 30.0, 50.0, 0.25f, 0.15f);
+    CHECK(state.phase == GaitPhase::WALKING);
+    CHECK_NEAR(state.cadence, 50.0f, 4.0f);
+    CHECK(state.step_count >= 23 && state.step_count <= 26);
+}
+
+TEST_CASE(gait_detector_running_and_back_to_idle)
+{
+    GaitDetector detector;
+    double time = 0.0;
+    GaitState state = FeedSteps(detector, time, 20.0, 120.0, 0.7f, 0.2f);
+    CHECK(state.phase == GaitPhase::RUNNING);
+    CHECK_NEAR(state.cadence, 120.0f, 10.0f);
+
+    // Without steps the cadence decays at once and the phase falls back after the timeout.
+    for (double end = time + 5.0; time < end; time += 1.0 / SAMPLE_RATE)
+        state = detector.AddSample(0.0f, time);
+    CHECK(state.phase == GaitPhase::IDLE);
+    CHECK(state.cadence == 0.0f);
+    CHECK(state.cadence_speed == 0.0f);
+}
+
+TEST_CASE(gait_detector_idle_noise)
+{
+    GaitDetector detector;
+    GaitState state;
+    for (int i = 0; i < 600; i++)
+        state = detector.AddSample(0.01f * static_cast<float>(i % 3), i / SAMPLE_RATE);
+    CHECK(state.phase == GaitPhase::IDLE);
+    CHECK(state.step_count == 0);
+}
+
+TEST_CASE(gait_detector_onset_without_delay)
+{
+    GaitDetector detector;
+    for (int i = 0; i < 10; i++)
+        detector.AddSample(0.0f, i / SAMPLE_RATE);
+    GaitState state = detector.AddSample(0.2f, 1.0);
+    CHECK(state.onset_event);
+    CHECK(state.step_event);
+    CHECK(state.phase == GaitPhase::WALKING);
+}
+
+TEST_CASE(gait_detector_onset_counts_stride_once)
+{
+    // A single stride out of idle: the onset is its step, its peak is none of its own.
+    GaitDetector detector;
+    GaitState state;
+    double time = 0.0;
+    for (int i = 0; i < 40; i++, time += 1.0 / SAMPLE_RATE)
+    {
+        double phase = (i - 10) / 12.0;
+        float value = i >= 10 && i < 22 ? 0.3f * static_cast<float>(std::sin(PI * phase)) : 0.0f;
+        state = detector.AddSample(value, time);
+    }
+    CHECK(state.step_count == 1);
+}
+
+/**
+ * The phases and steps of a replayed validation recording.
+ */
+struct GaitReplay
+{
+    // Phase changes out of idle and the most intense phase reached by every bout.
+    std::vector<GaitPhase> bouts;
+    uint32_t steps = 0;
+    float min_cadence = 1000.0f;
+    float max_cadence = 0.0f;
+    double min_step_interval = 1000.0;
+};
+
+static GaitReplay ReplayRecording(const std::string& name)
+{
+    GaitReplay replay;
+    GaitDetector detector;
+    GaitPhase phase = GaitPhase::IDLE;
+    double last_step = -1.0;
+    std::vector<float> values = LoadValidationRecording(name);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        double time = i / SAMPLE_RATE;
+        const GaitState& state = detector.AddSample(values[i], time);
+        if (phase == GaitPhase::IDLE && state.phase != GaitPhase::IDLE)
+            replay.bouts.push_back(state.phase);
+        if (state.phase == GaitPhase::RUNNING)
+            replay.bouts.back() = GaitPhase::RUNNING;
+        phase = state.phase;
+
+        // The cadence as estimated at the steps, in between it decays when the steps stop.
+        if (state.step_event && state.cadence > 0.0f)
+        {
+            replay.min_cadence = std::min(replay.min_cadence, state.cadence);
+            replay.max_cadence = std::max(replay.max_cadence, state.cadence);
+        }
+        if (state.step_event)
+        {
+            if (last_step >= 0.0)
+                replay.min_step_interval = std::min(replay.min_step_interval, time - last_step);
+            last_step = time;
+        }
+    }
+    replay.steps = detector.GetState().step_count;
+    return replay;
+}
+
+TEST_CASE(gait_detector_replay_walk)
+{
+    // Three bouts of walking at 30 to 41 steps/min, one force peak per step.
+    GaitReplay replay = ReplayRecording("02_walk_test.csv");
+    CHECK(replay.bouts.size() == 3);
+    for (GaitPhase bout : replay.bouts)
+        CHECK(bout == GaitPhase::WALKING);
+    CHECK(replay.steps == 20);
+    CHECK(replay.min_cadence >= 25.0f && replay.max_cadence <= 45.0f);
+    // No stride is counted twice.
+    CHECK(replay.min_step_interval >= 1.0);
+}
+
+TEST_CASE(gait_detector_replay_run)
+{
+    // Three runs with a short shuffle between the first two, idle in between.
+    GaitReplay replay = ReplayRecording("03_run_test.csv");
+    CHECK(replay.bouts.size() == 4);
+    size_t runs = 0;
+    for (GaitPhase bout : replay.bouts)
+        runs += bout == GaitPhase::RUNNING ? 1 : 0;
+    CHECK(runs == 3);
+    CHECK(replay.steps == 34);
+    CHECK(replay.max_cadence >= 100.0f);
+}
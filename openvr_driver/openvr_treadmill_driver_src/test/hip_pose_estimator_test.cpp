@@ -0,0 +1,54 @@
+#include <cmath>
+
+#include "hip_pose_estimator.h"
+#include "test_framework.h"
+
+/**
+ * A headset 2 m in front of an anchor at the origin, at 1.7 m height, walking sideways.
+ */
+static TrackingState MakeState(float x)
+{
+    TrackingState state;
+    state.hmd_valid = true;
+    state.hmd_x = x;
+    state.hmd_y = 1.7f;
+    state.hmd_z = -2.0f;
+    state.hmd_velocity_x = 0.5f;
+    state.has_anchor = true;
+    state.rope_length = 1.8f;
+    state.stretch = 0.2f;
+    return state;
+}
+
+TEST_CASE(hip_pose_estimator_needs_anchor)
+{
+    HipPoseEstimator estimator;
+    TrackingState state = MakeState(0.0f);
+    state.has_anchor = false;
+    CHECK(!estimator.Update(state, 0.5f, 1.0).poseIsValid);
+}
+
+TEST_CASE(hip_pose_estimator_follows_frames)
+{
+    HipPoseEstimator estimator;
+    vr::DriverPose_t pose = estimator.Update(MakeState(0.0f), 0.5f, 1.0);
+    CHECK(pose.poseIsValid);
+    CHECK_NEAR(pose.vecPosition[0], 0.0, 1e-5);
+    CHECK_NEAR(pose.vecPosition[1], 1.0, 1e-5);
+    CHECK_NEAR(pose.vecPosition[2], -1.9, 1e-5);
+
+    // The pose describes the frame it was computed for, not the older force sample.
+    CHECK(pose.poseTimeOffset == 0.0);
+
+    // A new force sample 100 ms later rises by 0.1, a radial velocity of 0.2 m/s.
+    pose = estimator.Update(MakeState(0.0f), 0.6f, 1.1);
+    CHECK_NEAR(pose.vecVelocity[2], -0.2, 1e-4);
+
+    // The following frames move with the headset and keep the rate of the last sample.
+    pose = estimator.Update(MakeState(0.05f), 0.6f, 1.1);
+    CHECK(pose.vecPosition[0] > 0.04 && pose.vecPosition[0] < 0.05);
+    double distance = std::sqrt(0.05 * 0.05 + 2.0 * 2.0);
+    double radial_velocity = (pose.vecVelocity[0] * 0.05 - pose.vecVelocity[2] * 2.0) / distance;
+    CHECK_NEAR(radial_velocity, 0.2, 1e-4);
+    CHECK(pose.poseTimeOffset == 0.0);
+}
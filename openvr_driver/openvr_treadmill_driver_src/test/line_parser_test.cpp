@@ -0,0 +1,98 @@
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "frame_codec.h"
+#include "line_parser.h"
+#include "test_framework.h"
+
+/**
+ * Feeds the bytes one per millisecond and returns the number of completed lines. The
+ * value of the last one is read when it ends, like the capture does.
+ */
+static int Feed(LineParser& parser, const std::string& bytes, double& time, float* value = nullptr)
+{
+    int lines = 0;
+    for (char ch : bytes)
+    {
+        if (parser.Push(ch, time))
+        {
+            lines++;
+            if (value != nullptr)
+                *value = parser.GetValue();
+        }
+        time += 0.001;
+    }
+    return lines;
+}
+
+TEST_CASE(line_parser_text_lines)
+{
+    LineParser parser;
+    double time = 1.0;
+    CHECK(Feed(parser, "0.42\r", time) == 1);
+    CHECK(!parser.IsBinary());
+    CHECK(std::strcmp(parser.GetLine(), "0.42") == 0);
+    CHECK_NEAR(parser.GetValue(), 0.42f, 1e-6f);
+    CHECK_NEAR(parser.GetFirstByteTime(), 1.0, 1e-9);
+    CHECK_NEAR(parser.GetEndTime(), 1.004, 1e-9);
+
+    // The line feed after the carriage return belongs to no line.
+    float value = 0.0f;
+    CHECK(Feed(parser, "\n-1.5\r\n", time, &value) == 1);
+    CHECK_NEAR(value, -1.5f, 1e-6f);
+}
+
+TEST_CASE(line_parser_invalid_lines)
+{
+    LineParser parser;
+    double time = 0.0;
+    CHECK(Feed(parser, "abc\r", time) == 1);
+    CHECK(std::isnan(parser.GetValue()));
+    CHECK(Feed(parser, "nan\r", time) == 1);
+    CHECK(std::isnan(parser.GetValue()));
+    CHECK(std::isnan(LineParser::ParseValue("")));
+    CHECK(std::isnan(LineParser::ParseValue("inf")));
+
+    // Endless noise ends as an overflow instead of growing the line.
+    CHECK(Feed(parser, std::string(LineParser::MAX_LINE_LENGTH + 1, '7'), time) == 1);
+    CHECK(parser.IsOverflow());
+    CHECK(std::isnan(parser.GetValue()));
+}
+
+TEST_CASE(line_parser_binary_frames)
+{
+    uint8_t frame[FrameCodec::FRAME_SIZE];
+    FrameCodec::Encode(0.625f, frame);
+    CHECK(frame[0] == FrameCodec::SYNC_BYTE);
+    CHECK(FrameCodec::Decode(frame) == 0.625f);
+
+    LineParser parser;
+    double time = 0.0;
+    std::string bytes(reinterpret_cast<const char*>(frame), sizeof(frame));
+    float value = 0.0f;
+    CHECK(Feed(parser, "0.1\r" + bytes + "0.2\r", time, &value) == 3);
+    CHECK(!parser.IsBinary());
+    CHECK_NEAR(value, 0.2f, 1e-6f);
+
+    CHECK(Feed(parser, bytes, time) == 1);
+    CHECK(parser.IsBinary());
+    CHECK(parser.GetValue() == 0.625f);
+}
+
+TEST_CASE(line_parser_corrupted_frames)
+{
+    uint8_t frame[FrameCodec::FRAME_SIZE];
+    FrameCodec::Encode(0.5f, frame);
+    for (size_t bit = 8; bit < 8 * FrameCodec::FRAME_SIZE; bit++)
+    {
+        uint8_t corrupted[FrameCodec::FRAME_SIZE];
+        std::memcpy(corrupted, frame, sizeof(frame));
+        corrupted[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+        CHECK(std::isnan(FrameCodec::Decode(corrupted)));
+    }
+
+    // Non-finite values are no valid frames either.
+    FrameCodec::Encode(INFINITY, frame);
+    CHECK(std::isnan(FrameCodec::Decode(frame)));
+}
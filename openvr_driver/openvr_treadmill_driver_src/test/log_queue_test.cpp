@@ -0,0 +1,202 @@
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_queue.h"
+#include "test_framework.h"
+
+static std::vector<std::string> written;
+
+static void Sink(const char* message)
+{
+    written.push_back(message);
+}
+
+static std::mutex written_lock;
+
+/**
+ * A sink for the flusher thread and the producers writing directly at the same time.
+ */
+static void LockedSink(const char* message)
+{
+    std::lock_guard<std::mutex> lock(written_lock);
+    written.push_back(message);
+}
+
+static bool Log(LogQueue& queue, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool queued = queue.Enqueue(format, args);
+    va_end(args);
+    return queued;
+}
+
+static bool LogWhileRunning(LogQueue& queue, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool taken = queue.EnqueueWhileRunning(format, args);
+    va_end(args);
+    return taken;
+}
+
+TEST_CASE(log_queue_keeps_order)
+{
+    written.clear();
+    LogQueue queue;
+    queue.Start(Sink);
+    for (int i = 0; i < 100; i++)
+        CHECK(Log(queue, "message %d", i));
+    queue.Stop();
+
+    CHECK(written.size() == 100);
+    for (size_t i = 0; i < written.size(); i++)
+        CHECK(written[i] == "message " + std::to_string(i));
+}
+
+TEST_CASE(log_queue_summarizes_repetitions)
+{
+    written.clear();
+    LogQueue queue;
+    queue.Start(Sink);
+    for (int i = 0; i < 37; i++)
+        Log(queue, "Failed to open serial port");
+    Log(queue, "Connected to serial port");
+    queue.Stop();
+
+    CHECK(written.size() == 3);
+    CHECK(written[0] == "Failed to open serial port");
+    CHECK(written[1] == "Connected to serial port");
+    CHECK(written.size() == 3 && written[2] == "Failed to open serial port \xC3\x97" "36");
+}
+
+TEST_CASE(log_queue_summarizes_empty_messages)
+{
+    // A serial port search without a result logs an empty device name.
+    written.clear();
+    LogQueue queue;
+    queue.Start(Sink);
+    for (int i = 0; i < 37; i++)
+        Log(queue, "%s", "");
+    queue.Stop();
+
+    CHECK(written.size() == 2);
+    CHECK(written.size() == 2 && written[0].empty() && written[1] == " \xC3\x97" "36");
+}
+
+TEST_CASE(log_queue_drops_when_full)
+{
+    written.clear();
+    LogQueue queue;
+    // Without a running flusher nothing is taken out of the queue.
+    size_t queued = 0;
+    for (size_t i = 0; i < LogQueue::CAPACITY + 10; i++)
+        queued += Log(queue, "message %zu", i) ? 1 : 0;
+    CHECK(queued == LogQueue::CAPACITY);
+    CHECK(queue.GetDroppedCount() == 10);
+
+    queue.Start(Sink);
+    queue.Stop();
+    CHECK(written.size() == LogQueue::CAPACITY + 1);
+    CHECK(!written.empty() && written.back() == "10 log messages dropped");
+}
+
+TEST_CASE(log_queue_concurrent_producers)
+{
+    written.clear();
+    LogQueueSettings settings;
+    settings.flush_interval = 0.001f;
+    LogQueue queue(settings);
+    queue.Start(Sink);
+
+    std::vector<std::thread> producers;
+    for (int thread = 0; thread < 4; thread++)
+    {
+        producers.emplace_back([&queue, thread]() {
+            for (int i = 0; i < 200; i++)
+            {
+                while (!Log(queue, "thread %d message %d", thread, i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (std::thread& producer : producers)
+        producer.join();
+    queue.Stop();
+
+    // Dropped attempts are reported, every message arrives exactly once and in order per thread.
+    int next[4] = { 0, 0, 0, 0 };
+    for (const std::string& message : written)
+    {
+        int thread = 0;
+        int i = 0;
+        if (std::sscanf(message.c_str(), "thread %d message %d", &thread, &i) != 2)
+            continue;
+        CHECK(thread >= 0 && thread < 4 && i == next[thread]);
+        if (thread >= 0 && thread < 4)
+            next[thread] = i + 1;
+    }
+    for (int count : next)
+        CHECK(count == 200);
+}
+
+TEST_CASE(log_queue_stop_keeps_late_messages)
+{
+    written.clear();
+    LogQueueSettings settings;
+    settings.flush_interval = 0.001f;
+    LogQueue queue(settings);
+    queue.Start(LockedSink);
+
+    // The producers run into the stop of the queue and then write their messages directly
+    // like DriverLog() does. Every message is written once by either path, unless it was
+    // dropped on a full queue.
+    const int PRODUCERS = 4;
+    const int MESSAGES = 2000;
+    std::atomic<int> started{ 0 };
+    std::vector<std::thread> producers;
+    for (int thread = 0; thread < PRODUCERS; thread++)
+    {
+        producers.emplace_back([&queue, &started, thread]() {
+            started++;
+            for (int i = 0; i < MESSAGES; i++)
+            {
+                if (!LogWhileRunning(queue, "thread %d message %d", thread, i))
+                {
+                    char message[64];
+                    snprintf(message, sizeof(message), "thread %d message %d", thread, i);
+                    LockedSink(message);
+                }
+            }
+        });
+    }
+    while (started < PRODUCERS)
+        std::this_thread::yield();
+    queue.Stop();
+    for (std::thread& producer : producers)
+        producer.join();
+
+    std::vector<int> counts(PRODUCERS * MESSAGES, 0);
+    for (const std::string& message : written)
+    {
+        int thread = 0;
+        int i = 0;
+        if (std::sscanf(message.c_str(), "thread %d message %d", &thread, &i) == 2 && thread >= 0 && thread < PRODUCERS &&
+            i >= 0 && i < MESSAGES)
+            counts[thread * MESSAGES + i]++;
+    }
+    size_t missing = 0;
+    size_t repeated = 0;
+    for (int count : counts)
+    {
+        missing += count == 0 ? 1 : 0;
+        repeated += count > 1 ? 1 : 0;
+    }
+    CHECK(repeated == 0);
+    CHECK(missing == queue.GetDroppedCount());
+}
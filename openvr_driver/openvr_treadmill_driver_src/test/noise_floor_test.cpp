@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gait_detector.h"
+#include "noise_floor.h"
+#include "test_framework.h"
+
+static const double SAMPLE_RATE = 10.0;
+
+/**
+ * The output of a validation recording through the gait detector and noise floor.
+ */
+struct NoiseFloorReplay
+{
+    // Idle samples that still moved the player, and their largest output.
+    size_t idle_outputs = 0;
+    float max_idle_output = 0.0f;
+    // The first sample the gait detector left idle at and the first that moved the player.
+    size_t first_movement = 0;
+    size_t first_output = 0;
+};
+
+/**
+ * Replays a recording with a constant lean into the rope added to every sample.
+ */
+static NoiseFloorReplay ReplayNoiseFloor(const std::string& name, float lean)
+{
+    NoiseFloorReplay replay;
+    GaitDetector detector;
+    NoiseFloorEstimator estimator;
+    std::vector<float> values = LoadValidationRecording(name);
+    bool moved = false;
+    bool output = false;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        double time = i / SAMPLE_RATE;
+        float value = std::min(values[i] + lean, 1.0f);
+        bool idle = detector.AddSample(value, time).phase == GaitPhase::IDLE;
+        float result = estimator.Process(value, idle, time);
+        if (idle && result > 0.0f)
+        {
+            replay.idle_outputs++;
+            replay.max_idle_output = std::max(replay.max_idle_output, result);
+        }
+        if (!idle && !moved)
+        {
+            replay.first_movement = i;
+            moved = true;
+        }
+        if (result > 0.0f && !output)
+        {
+            replay.first_output = i;
+            output = true;
+        }
+    }
+    return replay;
+}
+
+TEST_CASE(noise_floor_continuous_at_idle_band)
+{
+    // A fixed baseline, so that it does not follow the pull.
+    NoiseFloorSettings settings;
+    settings.baseline_rate = 0.0f;
+    NoiseFloorEstimator estimator(settings);
+    for (int i = 0; i < 30; i++)
+        estimator.Process(0.0f, true, i / SAMPLE_RATE);
+
+    // A pull slowly rising through the idle band while idle starts at zero at its
+    // edge instead of jumping to the deflection the band would have rescaled to.
+    float previous = 0.0f;
+    for (int i = 0; i <= 100; i++)
+    {
+        float output = estimator.Process(0.002f * static_cast<float>(i), true, 3.0 + i / SAMPLE_RATE);
+        CHECK(output >= previous && output - previous < 0.01f);
+        previous = output;
+    }
+    CHECK(previous > 0.0f);
+}
+
+TEST_CASE(noise_floor_no_empty_range)
+{
+    // A baseline and idle band that leave almost no range above them do not turn the
+    // last bit of force into a full deflection.
+    NoiseFloorSettings settings;
+    settings.idle_band = 0.695f;
+    settings.max_baseline = 0.3f;
+    NoiseFloorEstimator estimator(settings);
+    for (int i = 0; i < 200; i++)
+        estimator.Process(0.3f, true, i / SAMPLE_RATE);
+    CHECK_NEAR(estimator.GetBaseline(), 0.3f, 1e-3f);
+    float output = estimator.Process(1.0f, true, 20.0);
+    CHECK(std::isfinite(output) && output > 0.0f && output <= 0.2f);
+}
+
+TEST_CASE(noise_floor_replay_idle_creep)
+{
+    // Leaning into the rope while standing never moves the player.
+    for (float lean : { 0.0f, 0.05f, 0.1f })
+    {
+        for (const char* name : { "01_general_test.csv", "02_walk_test.csv", "03_run_test.csv" })
+        {
+            NoiseFloorReplay replay = ReplayNoiseFloor(name, lean);
+            CHECK(replay.idle_outputs == 0);
+        }
+    }
+}
+
+TEST_CASE(noise_floor_replay_onset_latency)
+{
+    // The player starts moving with the first sample the gait detector leaves idle at.
+    NoiseFloorReplay general = ReplayNoiseFloor("01_general_test.csv", 0.0f);
+    NoiseFloorReplay walk = ReplayNoiseFloor("02_walk_test.csv", 0.0f);
+    NoiseFloorReplay run = ReplayNoiseFloor("03_run_test.csv", 0.0f);
+    CHECK(general.first_movement == 251 && general.first_output == 251);
+    CHECK(walk.first_movement == 175 && walk.first_output == 175);
+    CHECK(run.first_movement == 135 && run.first_output == 135);
+
+    NoiseFloorReplay leaning = ReplayNoiseFloor("02_walk_test.csv", 0.1f);
+    CHECK(leaning.first_output == leaning.first_movement);
+}
@@ -0,0 +1,48 @@
+#include <cstdint>
+
+#include "quantile_estimator.h"
+#include "test_framework.h"
+
+/**
+ * A reproducible uniform sequence between 0 and 1.
+ */
+static double NextUniform(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0;
+}
+
+TEST_CASE(quantile_estimator_uniform)
+{
+    const double quantiles[] = { 0.05, 0.5, 0.95 };
+    for (double quantile : quantiles)
+    {
+        P2QuantileEstimator estimator(quantile);
+        uint32_t state = 1;
+        for (int i = 0; i < 20000; i++)
+            estimator.Add(NextUniform(state));
+        CHECK_NEAR(estimator.GetEstimate(), quantile, 0.02);
+        CHECK(estimator.GetCount() == 20000);
+    }
+}
+
+TEST_CASE(quantile_estimator_few_values)
+{
+    P2QuantileEstimator estimator(0.5);
+    estimator.Add(3.0);
+    estimator.Add(1.0);
+    estimator.Add(2.0);
+    CHECK(estimator.GetEstimate() == 2.0);
+
+    estimator.Reset();
+    CHECK(estimator.GetCount() == 0);
+}
+
+TEST_CASE(quantile_estimator_ignores_outliers)
+{
+    P2QuantileEstimator estimator(0.5);
+    uint32_t state = 7;
+    for (int i = 0; i < 5000; i++)
+        estimator.Add(i % 50 == 0 ? 1000.0 : NextUniform(state));
+    CHECK_NEAR(estimator.GetEstimate(), 0.5, 0.05);
+}
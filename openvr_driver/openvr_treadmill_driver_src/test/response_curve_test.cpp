@@ -0,0 +1,72 @@
+#include <cmath>
+
+#include "response_curve.h"
+#include "test_framework.h"
+
+TEST_CASE(response_curve_tables_match_functions)
+{
+    ResponseCurve soft(ResponseCurveType::GAMMA_SOFT);
+    ResponseCurve hard(ResponseCurveType::GAMMA_HARD);
+    ResponseCurve s_curve(ResponseCurveType::S_CURVE);
+    ResponseCurve gamma(ResponseCurveType::GAMMA, 1.7f);
+
+    // The tolerances documented at RESPONSE_CURVE_SEGMENTS. The steep start of x^0.6
+    // is the worst case of the linear interpolation.
+    for (int i = 0; i <= 10000; i++)
+    {
+        float x = i / 10000.0f;
+        CHECK_NEAR(soft.Evaluate(x), std::pow(x, 0.6f), x < 1.0f / RESPONSE_CURVE_SEGMENTS ? 0.016f : 0.0015f);
+        CHECK_NEAR(hard.Evaluate(x), x * x, 0.0002f);
+        CHECK_NEAR(s_curve.Evaluate(x), x * x * (3.0f - 2.0f * x), 0.0002f);
+        CHECK_NEAR(gamma.Evaluate(x), std::pow(x, 1.7f), 0.005f);
+    }
+}
+
+TEST_CASE(response_curve_rejects_invalid_gamma)
+{
+    const float invalid[] = { 0.0f, -1.0f, NAN };
+    for (float gamma : invalid)
+    {
+        ResponseCurve curve(ResponseCurveType::GAMMA, gamma);
+        CHECK(curve.GetType() == ResponseCurveType::LINEAR);
+        CHECK_NEAR(curve.Evaluate(0.3f), 0.3f, 1e-6f);
+    }
+}
+
+TEST_CASE(response_curve_clamps_input)
+{
+    ResponseCurve curve(ResponseCurveType::S_CURVE);
+    CHECK(curve.Evaluate(-0.5f) == 0.0f);
+    CHECK(curve.Evaluate(NAN) == 0.0f);
+    CHECK_NEAR(curve.Evaluate(2.0f), 1.0f, 1e-6f);
+
+    float values[4] = { -1.0f, 0.5f, 1.5f, NAN };
+    float results[4];
+    curve.EvaluateBlock(values, results, 4);
+    for (int i = 0; i < 4; i++)
+        CHECK(results[i] == curve.Evaluate(values[i]));
+}
+
+TEST_CASE(response_curve_custom_points)
+{
+    ResponseCurve curve;
+    CHECK(curve.FromPoints("1:1,0:0,0.5:0.1"));
+    CHECK(curve.GetType() == ResponseCurveType::CUSTOM);
+    CHECK_NEAR(curve.Evaluate(0.25f), 0.05f, 1e-5f);
+    CHECK_NEAR(curve.Evaluate(0.75f), 0.55f, 1e-5f);
+}
+
+TEST_CASE(response_curve_rejects_invalid_points)
+{
+    const char* invalid[] = {
+        "", "0:0", "0:0,1", "0-0,1:1", "0:0,1.5:1", "0:0,1:1.2", "0:-0.1,1:1", "0:0,1:nan", "0:0,nan:1",
+    };
+    for (const char* description : invalid)
+    {
+        ResponseCurve curve(ResponseCurveType::GAMMA_HARD);
+        CHECK(!curve.FromPoints(description));
+        // The curve stays untouched.
+        CHECK(curve.GetType() == ResponseCurveType::GAMMA_HARD);
+        CHECK_NEAR(curve.Evaluate(0.5f), 0.25f, 0.001f);
+    }
+}
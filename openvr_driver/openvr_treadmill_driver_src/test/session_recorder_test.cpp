@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "session_recorder.h"
+#include "test_framework.h"
+
+/**
+ * Reads a session log like load_cell_module/validation/session_reader.py: the chunks
+ * in order up to the first one that was not started, and of every chunk only the
+ * committed records. Returns false if the header is not one of a session log.
+ */
+static bool ReadSession(const std::string& file, SessionFileHeader& header, std::vector<SessionRecord>& records)
+{
+    std::ifstream input(file, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    records.clear();
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != SessionFileHeader::MAGIC || header.version != SessionFileHeader::VERSION ||
+        header.record_size != sizeof(SessionRecord) || header.chunk_size != SessionRecorder::CHUNK_SIZE)
+        return false;
+
+    size_t offset = header.header_size;
+    for (uint32_t index = 0; offset + header.chunk_size <= data.size(); index++, offset += header.chunk_size)
+    {
+        SessionChunkHeader chunk;
+        std::memcpy(&chunk, data.data() + offset, sizeof(chunk));
+        if (chunk.magic != SessionChunkHeader::MAGIC || chunk.index != index)
+            break;
+        size_t count = std::min<size_t>(chunk.record_count, SessionRecorder::RECORDS_PER_CHUNK);
+        for (size_t position = 0; position < count; position++)
+        {
+            SessionRecord record;
+            std::memcpy(&record, data.data() + offset + (position + 1) * sizeof(SessionRecord), sizeof(record));
+            records.push_back(record);
+        }
+    }
+    return true;
+}
+
+/**
+ * Records a sample whose times and values follow from its index, so that a reader can
+ * check every record.
+ */
+static bool RecordIndexed(SessionRecorder& recorder, uint32_t index)
+{
+    return recorder.Record(SessionRecordType::SAMPLE, 1, index * 0.1, index * 0.1 - 0.004,
+        static_cast<float>(index), static_cast<float>(index) / 4.0f);
+}
+
+/**
+ * Returns the number of leading records that match RecordIndexed().
+ */
+static size_t CountIndexed(const std::vector<SessionRecord>& records)
+{
+    size_t count = 0;
+    for (const SessionRecord& record : records)
+    {
+        uint32_t index = static_cast<uint32_t>(count);
+        if (record.sequence != index || record.type != static_cast<uint16_t>(SessionRecordType::SAMPLE) ||
+            record.flags != 1 || record.host_time != index * 0.1 || record.device_time != index * 0.1 - 0.004 ||
+            record.raw_value != static_cast<float>(index) || record.value != static_cast<float>(index) / 4.0f)
+            break;
+        count++;
+    }
+    return count;
+}
+
+TEST_CASE(session_recorder_round_trip)
+{
+    const uint32_t RECORDS = 3 * SessionRecorder::RECORDS_PER_CHUNK + 100;
+    std::string file = "session_recorder_test_round_trip.tmlog";
+
+    SessionRecorder recorder;
+    CHECK(recorder.Open(file, 0.0, "serial_number=round_trip\n"));
+    for (uint32_t index = 0; index < RECORDS; index++)
+    {
+        CHECK(RecordIndexed(recorder, index));
+        if (index % 1000 == 999)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    recorder.Close();
+    CHECK(recorder.GetWrittenCount() == RECORDS && recorder.GetLostCount() == 0);
+
+    SessionFileHeader header;
+    std::vector<SessionRecord> records;
+    CHECK(ReadSession(file, header, records));
+    CHECK(header.closed == 1 && header.lost_records == 0);
+    CHECK(std::string(header.metadata) == "serial_number=round_trip\n");
+    CHECK(records.size() == RECORDS && CountIndexed(records) == RECORDS);
+    std::remove(file.c_str());
+}
+
+#ifndef _WIN32
+
+TEST_CASE(session_recorder_survives_kill)
+{
+    std::string file = "session_recorder_test_kill.tmlog";
+    std::remove(file.c_str());
+
+    // The child records until it is killed, at a pace the writer keeps up with. The test
+    // runner has no other threads at this point, so the child can start the writer.
+    pid_t child = fork();
+    if (child == 0)
+    {
+        SessionRecorder recorder;
+        if (!recorder.Open(file, 0.0, "serial_number=kill\n"))
+            _exit(1);
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        for (uint32_t index = 0; std::chrono::steady_clock::now() < deadline; index++)
+        {
+            while (!RecordIndexed(recorder, index))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        _exit(1);
+    }
+    CHECK(child > 0);
+    if (child <= 0)
+        return;
+
+    // Killed once the second chunk is half written, while the writer is in the middle
+    // of it and the recorder never got to close the log.
+    SessionFileHeader header;
+    std::vector<SessionRecord> records;
+    size_t committed = 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (committed < SessionRecorder::RECORDS_PER_CHUNK * 3 / 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (ReadSession(file, header, records))
+            committed = records.size();
+    }
+    kill(child, SIGKILL);
+    int status = 0;
+    waitpid(child, &status, 0);
+    CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+
+    // Everything committed before the kill is still there and intact, the records after
+    // it at most add to them.
+    CHECK(ReadSession(file, header, records));
+    CHECK(header.closed == 0);
+    CHECK(std::string(header.metadata) == "serial_number=kill\n");
+    CHECK(committed >= SessionRecorder::RECORDS_PER_CHUNK * 3 / 2);
+    CHECK(records.size() >= committed);
+    CHECK(CountIndexed(records) == records.size());
+    std::remove(file.c_str());
+}
+
+#endif
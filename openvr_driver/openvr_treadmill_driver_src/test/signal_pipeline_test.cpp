@@ -0,0 +1,81 @@
+#include <string>
+#include <vector>
+
+#include "signal_pipeline.h"
+#include "test_framework.h"
+
+static const double SAMPLE_RATE = 10.0;
+
+/**
+ * The result of a calibration session over the validation recordings.
+ */
+struct CalibrationReplay
+{
+    bool finished = false;
+    size_t finished_at = 0;
+    CalibrationProfile profile;
+    float baseline_after = -1.0f;
+    // Samples after the session whose value left the normalized range.
+    size_t clamped_after = 0;
+    size_t samples_after = 0;
+};
+
+/**
+ * Runs a calibration session from the first sample over the walking, running and
+ * general recording, with an offset added to every value.
+ */
+static CalibrationReplay ReplayCalibration(bool raw_counts, float offset)
+{
+    CalibrationReplay replay;
+    SignalPipeline pipeline;
+    pipeline.StartCalibration();
+    size_t index = 0;
+    for (const char* name : { "02_walk_test.csv", "03_run_test.csv", "01_general_test.csv" })
+    {
+        std::vector<float> values = raw_counts ? LoadValidationCounts(name) : LoadValidationRecording(name);
+        for (float value : values)
+        {
+            const ConditionedSample& sample = pipeline.Process(value + offset, index / SAMPLE_RATE);
+            if (replay.finished)
+            {
+                replay.samples_after++;
+                if (sample.value >= 1.0f)
+                    replay.clamped_after++;
+            }
+            else if (pipeline.TakeCalibrationResult(replay.profile))
+            {
+                replay.finished = true;
+                replay.finished_at = index;
+                replay.baseline_after = pipeline.GetNoiseFloor().GetBaseline();
+            }
+            index++;
+        }
+    }
+    return replay;
+}
+
+TEST_CASE(signal_pipeline_calibrates_normalized_values)
+{
+    // The stock firmware normalizes with 100000 to 800000 counts already.
+    CalibrationReplay replay = ReplayCalibration(false, 0.0f);
+    CHECK(replay.finished);
+    CHECK_NEAR(replay.profile.min_value, 0.0f, 0.01f);
+    CHECK(replay.profile.max_value > 0.5f && replay.profile.max_value < 0.7f);
+}
+
+TEST_CASE(signal_pipeline_calibrates_raw_counts)
+{
+    // With send_raw_counts the default 0 to 1 profile clamps every value of a load cell
+    // with an idle load of 100000 counts to 1, so the gait detector sees no movement.
+    CalibrationReplay replay = ReplayCalibration(true, 100000.0f);
+    CHECK(replay.finished);
+    CHECK(replay.finished_at < 900);
+    CHECK_NEAR(replay.profile.min_value, 90000.0f, 5000.0f);
+    CHECK(replay.profile.max_value > 450000.0f && replay.profile.max_value < 650000.0f);
+
+    // The noise floor starts over in the new range, which is no longer saturated. Only
+    // the fastest running exceeds the calibrated range.
+    CHECK(replay.baseline_after == 0.0f);
+    CHECK(replay.samples_after > 1000);
+    CHECK(replay.clamped_after < replay.samples_after / 2);
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "spike_filter.h"
+#include "test_framework.h"
+
+TEST_CASE(spike_filter_removes_single_spike)
+{
+    SpikeFilter filter;
+    float outputs[12];
+    for (int i = 0; i < 12; i++)
+        outputs[i] = filter.Process(i == 8 ? 0.9f : 0.2f);
+
+    // The spike is held back for one sample and then replaced by the median.
+    for (float output : outputs)
+        CHECK_NEAR(output, 0.2f, 1e-6f);
+    CHECK(filter.GetRemovedSpikes() == 1);
+}
+
+TEST_CASE(spike_filter_passes_step)
+{
+    SpikeFilter filter;
+    float outputs[12];
+    for (int i = 0; i < 12; i++)
+        outputs[i] = filter.Process(i < 8 ? 0.1f : 0.8f);
+
+    // A jump confirmed by the next sample is a real onset, delayed by one sample.
+    CHECK_NEAR(outputs[8], 0.1f, 1e-6f);
+    CHECK_NEAR(outputs[9], 0.8f, 1e-6f);
+    CHECK_NEAR(outputs[11], 0.8f, 1e-6f);
+    CHECK(filter.GetRemovedSpikes() == 0);
+    CHECK(filter.GetDelayedOnsets() == 1);
+}
+
+TEST_CASE(spike_filter_passes_ramp)
+{
+    SpikeFilter filter;
+    for (int i = 0; i < 80; i++)
+    {
+        // Up and down in steps of 0.05.
+        float value = 0.05f * static_cast<float>(i % 40 < 20 ? i % 40 : 40 - i % 40);
+        CHECK(filter.Process(value) == value);
+    }
+    CHECK(filter.GetRemovedSpikes() == 0);
+}
+
+TEST_CASE(spike_filter_disabled)
+{
+    SpikeFilterSettings settings;
+    settings.window = 0;
+    SpikeFilter filter(settings);
+    for (int i = 0; i < 10; i++)
+        filter.Process(0.0f);
+    CHECK(filter.Process(1.0f) == 1.0f);
+}
+
+/**
+ * The result of a validation recording through the spike filter.
+ */
+struct SpikeReplay
+{
+    size_t removed_spikes = 0;
+    size_t delayed_onsets = 0;
+    // Injected spikes whose sample left the filter within 0.05 of the clean recording.
+    size_t injected = 0;
+    size_t caught = 0;
+};
+
+/**
+ * Replays a recording, with a spike of +0.4 to +0.7 on every 37th sample if asked for.
+ */
+static SpikeReplay ReplaySpikes(const std::string& name, bool inject)
+{
+    SpikeReplay replay;
+    SpikeFilter filter;
+    std::vector<float> values = LoadValidationRecording(name);
+    std::vector<float> outputs;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        float value = values[i];
+        if (inject && i % 37 == 36)
+        {
+            value = std::min(value + 0.4f + 0.1f * static_cast<float>(i / 37 % 4), 1.0f);
+            replay.injected++;
+        }
+        outputs.push_back(filter.Process(value));
+    }
+
+    // A held back sample leaves the filter one sample later.
+    if (inject)
+    {
+        for (size_t i = 36; i + 1 < values.size(); i += 37)
+        {
+            if (std::fabs(outputs[i + 1] - values[i]) <= 0.05f)
+                replay.caught++;
+        }
+    }
+    replay.removed_spikes = filter.GetRemovedSpikes();
+    replay.delayed_onsets = filter.GetDelayedOnsets();
+    return replay;
+}
+
+TEST_CASE(spike_filter_replay_clean)
+{
+    // The recordings have no glitches. Nothing is removed, only steep real onsets are
+    // held back for a sample.
+    SpikeReplay general = ReplaySpikes("01_general_test.csv", false);
+    SpikeReplay walk = ReplaySpikes("02_walk_test.csv", false);
+    SpikeReplay run = ReplaySpikes("03_run_test.csv", false);
+    CHECK(general.removed_spikes == 0 && walk.removed_spikes == 0 && run.removed_spikes == 0);
+    CHECK(general.delayed_onsets == 15);
+    CHECK(walk.delayed_onsets == 2);
+    CHECK(run.delayed_onsets == 15);
+}
+
+TEST_CASE(spike_filter_replay_injected)
+{
+    // Spikes on a steep flank are replaced by the median of the window, which lags the
+    // flank by more than the tolerance. Only in a saturated running segment, where the
+    // spike cannot rise above the clamped range, one passes.
+    SpikeReplay general = ReplaySpikes("01_general_test.csv", true);
+    SpikeReplay walk = ReplaySpikes("02_walk_test.csv", true);
+    SpikeReplay run = ReplaySpikes("03_run_test.csv", true);
+    CHECK(general.injected == 27 && general.caught >= 25);
+    CHECK(walk.injected == 24 && walk.caught >= 23 && walk.removed_spikes == 24);
+    CHECK(run.injected == 24 && run.caught >= 21);
+}
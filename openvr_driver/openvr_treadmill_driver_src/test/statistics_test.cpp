@@ -0,0 +1,44 @@
+#include "statistics.h"
+#include "test_framework.h"
+
+TEST_CASE(statistics_histogram_buckets)
+{
+    // Exact below the linear range, then 8 buckets per power of two.
+    for (uint64_t value = 0; value < LatencyHistogram::LINEAR_RANGE; value++)
+        CHECK(LatencyHistogram::GetLowerBound(LatencyHistogram::GetBucket(value)) == value);
+
+    for (size_t bucket = 0; bucket + 1 < LatencyHistogram::BUCKETS; bucket++)
+    {
+        uint64_t lower = LatencyHistogram::GetLowerBound(bucket);
+        uint64_t upper = LatencyHistogram::GetUpperBound(bucket);
+        CHECK(upper > lower);
+        CHECK(LatencyHistogram::GetLowerBound(bucket + 1) == upper);
+        CHECK(LatencyHistogram::GetBucket(lower) == bucket);
+        CHECK(LatencyHistogram::GetBucket(upper - 1) == bucket);
+        // The resolution is 12.5% of the value.
+        CHECK(lower < LatencyHistogram::LINEAR_RANGE || (upper - lower) * 8 <= lower);
+    }
+    CHECK(LatencyHistogram::GetBucket(UINT64_MAX) == LatencyHistogram::BUCKETS - 1);
+}
+
+TEST_CASE(statistics_histogram_percentiles)
+{
+    LatencyHistogram histogram;
+    CHECK(histogram.GetPercentile(0.5) == 0);
+
+    for (uint64_t value = 1; value <= 1000; value++)
+        histogram.Record(value);
+    CHECK(histogram.GetTotalCount() == 1000);
+    CHECK(histogram.GetMax() == 1000);
+
+    uint64_t median = histogram.GetPercentile(0.5);
+    CHECK(median >= 500 && median <= 500 * 9 / 8);
+    uint64_t p99 = histogram.GetPercentile(0.99);
+    CHECK(p99 >= 990 && p99 <= 1000 * 9 / 8);
+
+    histogram.RecordSeconds(-1.0);
+    CHECK(histogram.GetCount(0) == 1);
+    histogram.Reset();
+    CHECK(histogram.GetTotalCount() == 0);
+    CHECK(histogram.GetMax() == 0);
+}
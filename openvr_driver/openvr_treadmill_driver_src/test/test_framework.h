@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * A test case, registered by TEST_CASE before main runs.
+ */
+struct TestCase
+{
+    const char* name;
+    void (*function)();
+};
+
+/**
+ * Adds a test case to the ones test_main.cpp runs. Returns true, so that it can
+ * initialize a static.
+ */
+bool RegisterTest(const char* name, void (*function)());
+
+/**
+ * Marks the running test case as failed and prints the failed check.
+ */
+void ReportFailure(const char* file, int line, const char* expression);
+
+/**
+ * Reads a recording of load_cell_module/validation/data and normalizes it with the
+ * calibration range of the firmware, like the module sends it at 10 Hz.
+ */
+std::vector<float> LoadValidationRecording(const std::string& name);
+
+/**
+ * Reads the raw counts of a recording, like the module sends them with send_raw_counts.
+ */
+std::vector<float> LoadValidationCounts(const std::string& name);
+
+/**
+ * Defines a test case. Its name starts with the suite, e.g. "gait_detector", which the
+ * command line of the test runner selects.
+ */
+#define TEST_CASE(name)                                                             \
+    static void name();                                                             \
+    static const bool name##_registered = RegisterTest(#name, name);                \
+    static void name()
+
+/**
+ * Checks a condition, the test case continues after a failure to report all of them.
+ */
+#define CHECK(condition)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(condition))                                                           \
+            ReportFailure(__FILE__, __LINE__, #condition);                          \
+    } while (0)
+
+#define CHECK_NEAR(value, expected, tolerance) CHECK(std::fabs((value) - (expected)) <= (tolerance))
@@ -0,0 +1,100 @@
+/**
+ * Runs the test cases of the driver core:
+ *
+ *     treadmill_tests [suite or test case...]
+ *
+ * Without arguments all test cases run, otherwise the ones whose name starts with one
+ * of the arguments. CTest runs every suite as a test of its own. Returns 1 if a check
+ * failed.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test_framework.h"
+
+// Firmware calibration range of load_cell_module.ino.
+static const float FIRMWARE_MIN_VALUE = 100000.0f;
+static const float FIRMWARE_MAX_VALUE = 800000.0f;
+
+static std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+static int failures = 0;
+
+bool RegisterTest(const char* name, void (*function)())
+{
+    GetTestCases().push_back({ name, function });
+    return true;
+}
+
+void ReportFailure(const char* file, int line, const char* expression)
+{
+    printf("%s:%d: check failed: %s\n", file, line, expression);
+    failures++;
+}
+
+std::vector<float> LoadValidationCounts(const std::string& name)
+{
+    std::vector<float> values;
+    std::ifstream input(std::string(TREADMILL_VALIDATION_DIR) + "/data/" + name);
+    std::string line;
+    while (std::getline(input, line))
+    {
+        char* end = nullptr;
+        float value = std::strtof(line.c_str(), &end);
+        if (end != line.c_str())
+            values.push_back(value);
+    }
+    if (values.empty())
+        printf("cannot read the recording %s\n", name.c_str());
+    return values;
+}
+
+std::vector<float> LoadValidationRecording(const std::string& name)
+{
+    std::vector<float> values = LoadValidationCounts(name);
+    for (float& value : values)
+    {
+        value = (value - FIRMWARE_MIN_VALUE) / (FIRMWARE_MAX_VALUE - FIRMWARE_MIN_VALUE);
+        value = std::min(std::max(value, 0.0f), 1.0f);
+    }
+    return values;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<TestCase> test_cases = GetTestCases();
+    std::sort(test_cases.begin(), test_cases.end(),
+        [](const TestCase& a, const TestCase& b) { return std::string(a.name) < b.name; });
+
+    size_t count = 0;
+    for (const TestCase& test_case : test_cases)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+            selected = selected || std::string(test_case.name).rfind(argv[i], 0) == 0;
+        if (!selected)
+            continue;
+
+        int previous_failures = failures;
+        test_case.function();
+        printf("%s %s\n", failures == previous_failures ? "passed" : "FAILED", test_case.name);
+        count++;
+    }
+
+    if (count == 0)
+    {
+        printf("no test case matches\n");
+        return 1;
+    }
+    printf("%zu test cases, %d failed checks\n", count, failures);
+    return failures == 0 ? 0 : 1;
+}
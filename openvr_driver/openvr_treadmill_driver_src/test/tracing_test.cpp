@@ -0,0 +1,75 @@
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_framework.h"
+#include "tracing.h"
+
+/**
+ * Returns the written trace of all threads.
+ */
+static std::string WriteTrace()
+{
+    std::string file = "tracing_test_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".json";
+    CHECK(Tracer::WriteChromeTrace(file));
+    std::ifstream input(file);
+    std::stringstream content;
+    content << input.rdbuf();
+    std::remove(file.c_str());
+    return content.str();
+}
+
+TEST_CASE(tracing_reuses_buffers_of_finished_threads)
+{
+    Tracer::Start();
+    size_t buffers = Tracer::GetBufferCount();
+
+    // Threads restarted one after the other, like the capture thread on reconnects.
+    for (int i = 0; i < 50; i++)
+    {
+        std::thread thread([] {
+            Tracer::SetThreadName("restarted");
+            TraceEvent(TraceEventId::RECONNECT, TracePhase::INSTANT, 7);
+        });
+        thread.join();
+    }
+    CHECK(Tracer::GetBufferCount() <= buffers + 1);
+
+    // The events of the last finished thread are still written.
+    std::string trace = WriteTrace();
+    CHECK(trace.find("\"name\":\"restarted\"") != std::string::npos);
+    CHECK(trace.find("\"name\":\"reconnect\"") != std::string::npos);
+    Tracer::Stop();
+}
+
+TEST_CASE(tracing_caps_buffers)
+{
+    Tracer::Start();
+
+    // More threads than buffers at the same time. The surplus ones record nothing.
+    std::atomic<int> recorded{ 0 };
+    std::atomic<bool> release{ false };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Tracer::MAX_THREADS + 8; i++)
+    {
+        threads.emplace_back([&] {
+            TraceEvent(TraceEventId::PARSE, TracePhase::INSTANT);
+            recorded++;
+            while (!release)
+                std::this_thread::yield();
+        });
+    }
+    while (recorded < static_cast<int>(threads.size()))
+        std::this_thread::yield();
+    CHECK(Tracer::GetBufferCount() == Tracer::MAX_THREADS);
+
+    release = true;
+    for (std::thread& thread : threads)
+        thread.join();
+    CHECK(Tracer::GetBufferCount() == Tracer::MAX_THREADS);
+    Tracer::Stop();
+}
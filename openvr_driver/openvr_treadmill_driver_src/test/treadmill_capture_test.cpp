@@ -0,0 +1,79 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mock_driver_host.h"
+#include "simulated_serial_transport.h"
+#include "test_framework.h"
+#include "treadmill_capture.h"
+
+/**
+ * Runs the capture thread until the simulated clock passed the given seconds. Returns
+ * false if the clock got stuck, e.g. in a capture thread spinning without reading.
+ */
+static bool RunCapture(TreadmillCapture& capture, SimulatedClock& clock, double seconds)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    capture.StartBackgroundCapture();
+    while (clock.Now() <= seconds && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    capture.StopBackgroundCapture();
+    return clock.Now() > seconds;
+}
+
+TEST_CASE(treadmill_capture_reports_calibration_result)
+{
+    // The capture logs its connection changes through the driver context.
+    MockDriverHost host;
+    host.SetRecording(false);
+    vr::InitServerDriverContext(&host);
+
+    SimulatedClock clock;
+    std::vector<float> values = ModuleModel::MakeGaitProfile(GaitProfile::MIXED, 10.0, 1);
+    std::unique_ptr<SimulatedSerialTransport> transport(new SimulatedSerialTransport(clock, SimulatorSettings(), values));
+    TreadmillCapture capture(std::move(transport), clock);
+    capture.Configure(SignalPipelineSettings(), SimulatedSerialTransport::PORT_NAME);
+    CHECK(capture.GetCalibration().min_value == 0.0f && capture.GetCalibration().max_value == 1.0f);
+
+    capture.StartCalibration();
+    CHECK(RunCapture(capture, clock, 180.0));
+
+    // The profile in use is the result of the session, also before the result is taken.
+    CalibrationProfile in_use = capture.GetCalibration();
+    CalibrationProfile result;
+    CHECK(capture.TakeCalibrationResult(result));
+    CHECK(in_use.min_value == result.min_value && in_use.max_value == result.max_value);
+    CHECK(result.max_value > result.min_value && result.max_value < 1.0f);
+}
+
+TEST_CASE(treadmill_capture_standby_while_disconnected)
+{
+    MockDriverHost host;
+    host.SetRecording(false);
+    vr::InitServerDriverContext(&host);
+
+    // The module hangs up after 10 seconds for 5 seconds.
+    SimulatorSettings settings;
+    settings.disconnect_interval = 10.0;
+    settings.disconnect_duration = 5.0;
+    SimulatedClock clock;
+    std::vector<float> values = ModuleModel::MakeGaitProfile(GaitProfile::WALK, 10.0, 1);
+    std::unique_ptr<SimulatedSerialTransport> transport(new SimulatedSerialTransport(clock, settings, values));
+    SimulatedSerialTransport& module = *transport;
+    TreadmillCapture capture(std::move(transport), clock);
+    capture.Configure(SignalPipelineSettings(), SimulatedSerialTransport::PORT_NAME);
+
+    // The standby is requested before the capture is connected. It can only be applied
+    // after the connect, and the failing reads until then must lead to it instead of
+    // being skipped as aborted by the standby change. The module leaves the standby when
+    // it hangs up, so the capture sends it again after the reconnect. The simulated time
+    // runs ahead of the test, which can stop it at any point of the cycle, so the number
+    // of commands is checked instead of the mode at the end.
+    capture.SetStandby(true);
+    CHECK(RunCapture(capture, clock, 30.0));
+    SimulatorStatistics statistics = module.GetStatistics();
+    CHECK(statistics.disconnects >= 1);
+    CHECK(statistics.commands >= 2);
+    CHECK(capture.GetStatistics().reconnects.load() >= 2);
+}